@@ -0,0 +1,80 @@
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// this should be found in include under 
+// the massivethreads installation directory 
+// (<prefix>/include)
+#include <mtbb/parallel_reduce_per_worker.h>
+
+double cur_time() {
+  struct timeval tp[1];
+  gettimeofday(tp, NULL);
+  return tp->tv_sec + 1.0E-6 * tp->tv_usec;
+}
+
+// what mtbb::parallel_reduce_per_worker needs of tbb::blocked_range
+struct range {
+  long b, e, g;
+  range(long b_, long e_, long g_ = 1) : b(b_), e(e_), g(g_) {}
+  long begin() const { return b; }
+  long end() const { return e; }
+  long grainsize() const { return g; }
+  bool empty() const { return b >= e; }
+  bool is_divisible() const { return e - b > g; }
+};
+
+// a histogram counting the histograms made
+struct histogram {
+  static long n_made;
+  std::vector<long> bins;
+  histogram(long n_bins) : bins(n_bins, 0) {}
+  histogram(const histogram & h) : bins(h.bins) {
+    __sync_fetch_and_add(&n_made, 1);
+  }
+};
+long histogram::n_made = 0;
+
+int main(int argc, char ** argv) {
+  long n = (argc > 1 ? atol(argv[1]) : 100 * 1000 * 1000);
+  long n_bins = (argc > 2 ? atol(argv[2]) : 1000 * 1000);
+  long grainsize = (argc > 3 ? atol(argv[3]) : 10000);
+  int reps = (argc > 4 ? atoi(argv[4]) : 3);
+  std::vector<int> x(n);
+  unsigned short seed[3] = { 1, 2, 3 };
+  for (long i = 0; i < n; i++) {
+    x[i] = nrand48(seed) % n_bins;
+  }
+  for (int r = 0; r < reps; r++) {
+    double t0 = cur_time();
+    histogram s(n_bins);
+    for (long i = 0; i < n; i++) {
+      s.bins[x[i]]++;
+    }
+    double t1 = cur_time();
+    histogram::n_made = 0;
+    histogram p = mtbb::parallel_reduce_per_worker(range(0, n, grainsize), histogram(n_bins),
+      [&](const range & rg, histogram & h) {
+        for (long i = rg.begin(); i < rg.end(); i++) {
+          h.bins[x[i]]++;
+        }
+      },
+      [&](histogram & h, const histogram & g) {
+        for (long i = 0; i < n_bins; i++) {
+          h.bins[i] += g.bins[i];
+        }
+      });
+    double t2 = cur_time();
+    if (p.bins != s.bins) {
+      printf("NG: mtbb::parallel_reduce_per_worker got a wrong result\n");
+      return 1;
+    }
+    printf("%ld elements into %ld bins: serial %.3f sec,"
+           " mtbb::parallel_reduce_per_worker %.3f sec (%.2fx),"
+           " %ld histograms made\n",
+           n, n_bins, t1 - t0, t2 - t1, (t1 - t0) / (t2 - t1),
+           histogram::n_made);
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#if BENCH_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_scan.h>
+#define parallel_scan_name "tbb::parallel_scan"
+#define parallel_scan_fun tbb::parallel_scan
+typedef tbb::blocked_range<long> range;
+#else
+// this should be found in include under 
+// the massivethreads installation directory 
+// (<prefix>/include)
+#include <mtbb/parallel_scan.h>
+#define parallel_scan_name "mtbb::parallel_scan"
+#define parallel_scan_fun mtbb::parallel_scan
+// what mtbb::parallel_scan needs of tbb::blocked_range
+struct range {
+  long b, e, g;
+  range(long b_, long e_, long g_ = 1) : b(b_), e(e_), g(g_) {}
+  long begin() const { return b; }
+  long end() const { return e; }
+  long grainsize() const { return g; }
+  bool empty() const { return b >= e; }
+  bool is_divisible() const { return e - b > g; }
+};
+#endif
+
+double cur_time() {
+  struct timeval tp[1];
+  gettimeofday(tp, NULL);
+  return tp->tv_sec + 1.0E-6 * tp->tv_usec;
+}
+
+int main(int argc, char ** argv) {
+  long n = (argc > 1 ? atol(argv[1]) : 100 * 1000 * 1000);
+  long grainsize = (argc > 2 ? atol(argv[2]) : 10000);
+  int reps = (argc > 3 ? atoi(argv[3]) : 3);
+  std::vector<long> x(n), y(n), z(n);
+  unsigned short seed[3] = { 1, 2, 3 };
+  for (long i = 0; i < n; i++) {
+    x[i] = nrand48(seed) % 1000;
+  }
+  for (int r = 0; r < reps; r++) {
+    double t0 = cur_time();
+    long s = 0;
+    for (long i = 0; i < n; i++) {
+      s += x[i];
+      y[i] = s;
+    }
+    double t1 = cur_time();
+    long ps = parallel_scan_fun(range(0, n, grainsize), 0L,
+      [&](const range & rg, long sum, bool is_final) {
+        for (long i = rg.begin(); i < rg.end(); i++) {
+          sum += x[i];
+          if (is_final) z[i] = sum;
+        }
+        return sum;
+      },
+      [](long a, long b) { return a + b; });
+    double t2 = cur_time();
+    if (ps != s || y != z) {
+      printf("NG: " parallel_scan_name " got a wrong result\n");
+      return 1;
+    }
+    printf("%ld elements: serial %.3f sec, " parallel_scan_name
+           " %.3f sec (%.2fx)\n",
+           n, t1 - t0, t2 - t1, (t1 - t0) / (t2 - t1));
+  }
+  return 0;
+}
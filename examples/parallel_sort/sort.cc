@@ -0,0 +1,57 @@
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#if BENCH_TBB
+#include <tbb/parallel_sort.h>
+#define parallel_sort_name "tbb::parallel_sort"
+#define parallel_sort_fun tbb::parallel_sort
+#else
+// this should be found in include under 
+// the massivethreads installation directory 
+// (<prefix>/include)
+#include <mtbb/parallel_sort.h>
+#define parallel_sort_name "mtbb::parallel_sort"
+#define parallel_sort_fun mtbb::parallel_sort
+#endif
+
+double cur_time() {
+  struct timeval tp[1];
+  gettimeofday(tp, NULL);
+  return tp->tv_sec + 1.0E-6 * tp->tv_usec;
+}
+
+// n random numbers in [0, m) (duplicates galore if m is small)
+void gen(std::vector<long> & a, long n, long m, unsigned short seed[3]) {
+  a.resize(n);
+  for (long i = 0; i < n; i++) {
+    a[i] = nrand48(seed) % m;
+  }
+}
+
+int main(int argc, char ** argv) {
+  long n = (argc > 1 ? atol(argv[1]) : 10 * 1000 * 1000);
+  long m = (argc > 2 ? atol(argv[2]) : 1L << 30);
+  int reps = (argc > 3 ? atoi(argv[3]) : 3);
+  unsigned short seed[3] = { 1, 2, 3 };
+  std::vector<long> a, b;
+  for (int r = 0; r < reps; r++) {
+    gen(a, n, m, seed);
+    b = a;
+    double t0 = cur_time();
+    std::sort(a.begin(), a.end());
+    double t1 = cur_time();
+    parallel_sort_fun(b.begin(), b.end());
+    double t2 = cur_time();
+    if (a != b) {
+      printf("NG: " parallel_sort_name " got a wrong result\n");
+      return 1;
+    }
+    printf("%ld elements: std::sort %.3f sec, " parallel_sort_name
+           " %.3f sec (%.2fx)\n",
+           n, t1 - t0, t2 - t1, (t1 - t0) / (t2 - t1));
+  }
+  return 0;
+}
@@ -33,7 +33,10 @@ extern "C" {
     MYTH_MUTEX_NORMAL = 0,
     MYTH_MUTEX_ERRORCHECK = 1,
     MYTH_MUTEX_RECURSIVE = 2,
-    MYTH_MUTEX_INVALID = 3,
+    /* spin for a while (self-tuned per mutex) before blocking,
+       like glibc's PTHREAD_MUTEX_ADAPTIVE_NP */
+    MYTH_MUTEX_ADAPTIVE = 3,
+    MYTH_MUTEX_INVALID = 4,
     MYTH_MUTEX_DEFAULT = MYTH_MUTEX_NORMAL
   };
   
@@ -45,7 +48,7 @@ extern "C" {
     int magic;
     myth_mutexattr_t attr;
     myth_sleep_queue_t sleep_q[1];
-    volatile long state;		/* n_waiters|locked */
+    volatile long state;		/* spins|n_waiters|locked */
   } myth_mutex_t;
 
   enum { myth_mutex_magic_no = 123456789, 
@@ -57,24 +60,34 @@ extern "C" {
      --- reader-writer lock  ---
      --------------------------------------- */
 
+  /* as in glibc, only PREFER_WRITER_NONRECURSIVE makes a reader
+     wait for blocked writers; PREFER_WRITER behaves like
+     PREFER_READER so that recursive read locks never deadlock */
   enum {
     MYTH_RWLOCK_PREFER_READER, 
     MYTH_RWLOCK_PREFER_WRITER,
     MYTH_RWLOCK_PREFER_WRITER_NONRECURSIVE,
-    MYTH_RWLOCK_PREFER_INVALID
+    MYTH_RWLOCK_PREFER_INVALID,
+    MYTH_RWLOCK_DEFAULT = MYTH_RWLOCK_PREFER_READER
   };
 
   typedef struct myth_rwlockattr {
-    int kind;
+    int kind;			/* one of the above constants */
+    int read_mostly;		/* 1 : count readers per worker */
   } myth_rwlockattr_t;
 
+  struct myth_rwlock_reader_count;
+
   typedef struct myth_rwlock {
-    myth_sleep_queue_t sleep_q[1];
+    myth_sleep_queue_t sleep_q[1]; /* blocked writers */
+    myth_sleep_stack_t sleep_s[1]; /* blocked readers */
     volatile long state;
     myth_rwlockattr_t attr;
+    /* per-worker reader counters of a read-mostly lock, or null */
+    struct myth_rwlock_reader_count * reader_count;
   } myth_rwlock_t;
 
-#define MYTH_RWLOCK_INITIALIZER { { MYTH_SLEEP_QUEUE_INITIALIZER }, 0, { MYTH_RWLOCK_DEFAULT }  }
+#define MYTH_RWLOCK_INITIALIZER { { MYTH_SLEEP_QUEUE_INITIALIZER }, { { 0 } }, 0, { MYTH_RWLOCK_DEFAULT, 0 }, 0 }
 
   /* ---------------------------------------
      --- condition variable ---
@@ -151,6 +164,34 @@ extern "C" {
     volatile myth_thread_t th; /* the thread sleeping on it */
   } myth_uncond_t;
 
+  /* ---------------------------------------
+     --- future ---
+     --------------------------------------- */
+
+  /* values up to this size are stored in myth_future_t itself */
+#define MYTH_FUTURE_INLINE_SIZE 32
+
+  struct myth_future;
+
+  /* a continuation attached by myth_future_then */
+  typedef struct myth_future_cont {
+    struct myth_future_cont * next;
+    void (*fn)(struct myth_future * f, void * arg);
+    void * arg;
+  } myth_future_cont_t;
+
+  typedef struct myth_future {
+    volatile long state;		/* n_waiters|ready|set */
+    myth_sleep_queue_t sleep_q[1];
+    myth_future_cont_t * volatile conts; /* attached continuations */
+    size_t size;			/* size of the value */
+    union {
+      char buf[MYTH_FUTURE_INLINE_SIZE];
+      void * ptr;			/* if size > MYTH_FUTURE_INLINE_SIZE */
+      long double align_;
+    } value;
+  } myth_future_t;
+
   /* ---------------------------------------
      --- global attributes and initialization functions ---
      --------------------------------------- */
@@ -363,11 +404,28 @@ extern "C" {
     size_t guardsize;
     int detachstate;
     int child_first;
+    int priority;
+    int on_worker;		/* 1 + the worker to run on, or 0 (see myth_thread_attr_setworker) */
+    int on_numa_node;		/* 1 + the NUMA node to run on, or 0 (see myth_thread_attr_setnumanode) */
+    int pinned;			/* never migrate (see below) */
     /* TODO: get rid of them */
     size_t custom_data_size;
     void *custom_data;
   } myth_thread_attr_t;
   
+  /*
+    A thread created with attr->pinned = 1 runs only on the worker
+    it is created on (or that of myth_thread_attr_setworker), so that it can
+    keep worker-local state such as <myth_wls_setspecific> values
+    or per-worker descriptors. Pinned threads are kept out of the
+    runqueues other workers steal from. A worker runs its pinned
+    threads before the others, yet lets the others run regularly
+    so that they do not starve. Wakeups from other workers are
+    sent back to the worker. A pinned thread moves only when its
+    worker is made inactive (<myth_set_num_active_workers>); it is
+    then pinned to the worker it is given to.
+  */
+
   typedef void*(*myth_func_t)(void*);
   
   /*
@@ -428,6 +486,40 @@ extern "C" {
   */
   int myth_create_ex(myth_thread_t * id, myth_thread_attr_t * attr,
 		     myth_func_t func, void * arg);
+
+  /*
+    Function: myth_create_on
+
+    Create a new user-level thread executing func(arg) on
+    the specified worker, e.g., the one owning the data it
+    works on. It is equivalent to myth_create_ex with an
+    attribute given the worker by <myth_thread_attr_setworker>.
+
+    The thread is delivered to the worker through a lock-free
+    inbox, which the worker checks whenever it looks for the
+    next thread to run, and it runs there first. Like any
+    other thread, it may be stolen by another worker later
+    while waiting in the runqueue of the worker.
+    Similarly, <myth_thread_attr_setnumanode> asks for a worker
+    of a NUMA node.
+
+    Parameters:
+
+    worker - a worker (0 <= worker < myth_get_num_workers()).
+    If it is out of range, the thread is created as myth_create
+    does. If it is inactive (<myth_set_num_active_workers>), an
+    active one is chosen instead.
+    func - a pointer to a function.
+    arg - a pointer given to func.
+
+    Returns:
+
+    The identifier of the newly created thread.
+
+    See Also:
+    <myth_create>, <myth_create_ex>, <myth_get_worker_num>
+  */
+  myth_thread_t myth_create_on(int worker, myth_func_t func, void * arg);
   myth_thread_t myth_create_nosched(myth_func_t func, void * arg,
 				    myth_thread_attr_t * attr);
 
@@ -723,6 +815,67 @@ extern "C" {
   int myth_thread_attr_setstack(myth_thread_attr_t *attr,
 				void *stackaddr, size_t stacksize);
 
+  /* 
+     Function: myth_thread_attr_getpriority
+   */
+  int myth_thread_attr_getpriority(const myth_thread_attr_t *attr,
+				   int *priority);
+
+  /* 
+     Function: myth_thread_attr_setpriority
+
+     Set the priority of threads created with attr, from 0 (the
+     default) to 3. A worker runs and steals threads of higher
+     priorities first, but lets a thread of a lower one run after
+     every 64 threads taken from above, so that they do not starve.
+     Priorities are not preemptive: a running thread is not
+     interrupted for a higher one. Programs that never set it
+     are scheduled exactly as before.
+
+     Returns:
+     Zero, or EINVAL if priority is out of range.
+   */
+  int myth_thread_attr_setpriority(myth_thread_attr_t *attr, int priority);
+
+  /* 
+     Function: myth_thread_attr_getworker
+   */
+  int myth_thread_attr_getworker(const myth_thread_attr_t *attr,
+				 int *worker);
+
+  /* 
+     Function: myth_thread_attr_setworker
+
+     Make threads created with attr start on worker (see
+     <myth_create_on>), or on any worker if worker is -1 (the
+     default). The attribute keeps it as worker + 1, so that
+     a zero-filled attribute asks for no worker.
+
+     Returns:
+     Zero, or EINVAL if worker is less than -1.
+   */
+  int myth_thread_attr_setworker(myth_thread_attr_t *attr, int worker);
+
+  /* 
+     Function: myth_thread_attr_getnumanode
+   */
+  int myth_thread_attr_getnumanode(const myth_thread_attr_t *attr,
+				   int *numa_node);
+
+  /* 
+     Function: myth_thread_attr_setnumanode
+
+     Make threads created with attr start on a worker of NUMA
+     node numa_node, or on any worker if it is -1 (the default).
+     Nodes of workers are known only when they are bound to cpus
+     (MYTH_BIND_WORKERS); otherwise it is ignored. A worker given
+     by <myth_thread_attr_setworker> takes precedence.
+
+     Returns:
+     Zero, or EINVAL if numa_node is less than -1.
+   */
+  int myth_thread_attr_setnumanode(myth_thread_attr_t *attr, int numa_node);
+
   /* 
      Function: myth_getattr_default_np
    */
@@ -985,6 +1138,10 @@ extern "C" {
 
   /* 
      Function: myth_mutexattr_settype
+
+     Set the type of a mutex. MYTH_MUTEX_ADAPTIVE makes
+     <myth_mutex_lock> spin for a while before blocking,
+     which helps when critical sections are short.
    */
   int myth_mutexattr_settype(myth_mutexattr_t *attr, int type);
 
@@ -1055,6 +1212,23 @@ extern "C" {
      Function: myth_rwlockattr_setkind
   */
   int myth_rwlockattr_setkind(myth_rwlockattr_t *attr, int pref);
+
+  /* 
+     Function: myth_rwlockattr_getreadmostly
+  */
+  int myth_rwlockattr_getreadmostly(const myth_rwlockattr_t *attr,
+				    int *read_mostly);
+
+  /* 
+     Function: myth_rwlockattr_setreadmostly
+
+     If read_mostly is 1, locks initialized with attr count readers
+     in per-worker counters, so that read-locking does not write to
+     a cache line shared with other workers.  Write-locking becomes
+     more expensive, as it has to wait for all the counters to become zero.
+  */
+  int myth_rwlockattr_setreadmostly(myth_rwlockattr_t *attr,
+				    int read_mostly);
   
 
   /*
@@ -1416,6 +1590,155 @@ extern "C" {
 
    */
   int myth_uncond_signal(myth_uncond_t * uncond);
+
+  /* 
+     Function: myth_future_init
+
+     initialize a future, a place for a value of size bytes
+     that is set once (by <myth_future_set>) and read by any
+     number of threads (by <myth_future_get>), which block until
+     it is set.  values of up to MYTH_FUTURE_INLINE_SIZE bytes
+     are stored in the future itself; larger ones are malloc'ed
+     here.
+
+     Parameters:
+     f - a pointer to a future to initialize
+     size - the size of the value in bytes (may be zero, when
+     the future only tells that something has happened)
+
+     Returns:
+     zero if it succeeds and non-zero otherwise
+   */
+  int myth_future_init(myth_future_t * f, size_t size);
+
+  /* 
+     Function: myth_future_destroy
+
+     destroy a future.  no thread may be blocking on it, and
+     continuations attached to it must have returned.
+
+     Returns:
+     zero if it succeeds and non-zero otherwise
+   */
+  int myth_future_destroy(myth_future_t * f);
+
+  /* 
+     Function: myth_future_set
+
+     set the value of a future, run the continuations attached
+     to it (see <myth_future_then>) in the order they were
+     attached, and wake up threads blocking on it.
+     the continuations run in the calling thread.
+
+     Parameters:
+     f - a pointer to a future
+     value - a pointer to the value (size bytes given to
+     <myth_future_init>), or NULL when the caller has already
+     written the value at <myth_future_value>(f) (only safe when
+     nobody else may set f; see <myth_future_claim>)
+
+     Returns:
+     zero if it succeeds, or EBUSY if the value has already
+     been set (the value is left as it is)
+   */
+  int myth_future_set(myth_future_t * f, const void * value);
+
+  /* 
+     Function: myth_future_claim
+
+     take the right to set the value of a future, for a
+     producer that constructs the value in place at
+     <myth_future_value>(f).  only one caller succeeds; it
+     must then write the value and call <myth_future_publish>.
+     <myth_future_set> fails with EBUSY once it is claimed.
+
+     Parameters:
+     f - a pointer to a future
+
+     Returns:
+     zero if the caller got the right, or EBUSY if the future
+     has already been claimed or set (nothing is changed)
+   */
+  int myth_future_claim(myth_future_t * f);
+
+  /* 
+     Function: myth_future_publish
+
+     finish setting a future claimed by <myth_future_claim>
+     after the value has been written at <myth_future_value>(f):
+     run the continuations and wake up blocking threads as
+     <myth_future_set> does.  only the thread that claimed it
+     may call it, and only once.
+
+     Parameters:
+     f - a pointer to a future
+
+     Returns:
+     zero if it succeeds and non-zero otherwise
+   */
+  int myth_future_publish(myth_future_t * f);
+
+  /* 
+     Function: myth_future_get
+
+     block until the value of a future is set, and copy it.
+     the calling thread sleeps on the future rather than
+     spinning.
+
+     Parameters:
+     f - a pointer to a future
+     value - where to copy the value, or NULL (then read it
+     at <myth_future_value>(f))
+
+     Returns:
+     zero if it succeeds and non-zero otherwise
+   */
+  int myth_future_get(myth_future_t * f, void * value);
+
+  /* 
+     Function: myth_future_ready
+
+     Returns:
+     nonzero if the value of a future has been set
+     (i.e., <myth_future_get> would not block), zero otherwise
+   */
+  int myth_future_ready(myth_future_t * f);
+
+  /* 
+     Function: myth_future_value
+
+     Returns:
+     where the value of a future is stored.
+     it is valid after <myth_future_get> has returned (or a
+     continuation has been called) until the future is
+     destroyed.  the producer may also write the value there
+     between <myth_future_claim> and <myth_future_publish>.
+   */
+  void * myth_future_value(myth_future_t * f);
+
+  /* 
+     Function: myth_future_then
+
+     attach a continuation fn(f, arg) to a future, to be
+     called once its value is set.  no thread is created or
+     blocked for it; if the value has already been set, the
+     caller calls it right away, otherwise the thread calling
+     <myth_future_set> does.  fn should therefore be short,
+     or create a thread for a longer job.
+
+     Parameters:
+     f - a pointer to a future
+     cont - memory to keep the continuation in, which must
+     be left untouched until fn is called
+     fn - the function to call
+     arg - the second parameter of fn
+
+     Returns:
+     zero if it succeeds and non-zero otherwise
+   */
+  int myth_future_then(myth_future_t * f, myth_future_cont_t * cont,
+		       void (*fn)(myth_future_t * f, void * arg),
+		       void * arg);
   
 
   typedef int myth_key_t;
@@ -1531,6 +1854,128 @@ extern "C" {
   */
   int myth_get_num_workers(void);
 
+  /*
+    Function: myth_set_num_active_workers
+
+    Change the number of workers running threads to n
+    (1 <= n <= myth_get_num_workers()), e.g., to give cores
+    back to other parts of a program and take them again.
+    Workers n, n+1, ... become inactive; each one gives the
+    threads in its runqueue to active workers and sleeps at
+    its next scheduling point. A thread running on it keeps
+    running until it blocks, yields or exits. Inactive workers
+    are never chosen as victims of work stealing. Worker 0 is
+    always active.
+
+    Parameters:
+
+    n - the number of active workers. It is clamped to
+    [1, myth_get_num_workers()].
+
+    Returns:
+
+    The number of active workers set.
+
+    See Also:
+
+    <myth_get_num_active_workers>, <myth_get_num_workers>
+  */
+  int myth_set_num_active_workers(int n);
+
+  /*
+    Function: myth_get_num_active_workers
+
+    Returns:
+    The number of active workers, which is myth_get_num_workers()
+    unless changed by <myth_set_num_active_workers>.
+  */
+  int myth_get_num_active_workers(void);
+
+  /*
+    Function: myth_runqueue_is_empty
+
+    Check if the runqueue of the calling worker has no thread
+    other workers could steal. With child-first creation, a
+    parent waits there while its child runs, so this becoming
+    true means a thief took it. Lazy loop splitting
+    (mtbb::parallel_for with mtbb::auto_partitioner) exposes
+    more iterations only then.
+
+    Returns:
+    Nonzero if the runqueue is empty, zero otherwise.
+    The answer may be stale as soon as it is returned.
+  */
+  int myth_runqueue_is_empty(void);
+
+  /*
+    Type: myth_worker_stats_t
+
+    Counters of a worker (or their sums over all workers),
+    filled by <myth_get_stats>.
+  */
+  typedef struct myth_worker_stats {
+    unsigned long long n_created;	/* threads created */
+    unsigned long long n_steal_attempts; /* steal attempts as a thief */
+    unsigned long long n_steal_hits;	/* attempts that got a thread */
+    unsigned long long n_steal_misses;	/* attempts that found no thread */
+    unsigned long long idle_ns;		/* nanoseconds the scheduler had nothing to run */
+    long queue_high_water;		/* most threads ever in the runqueue */
+    long n_stacks_cached;		/* free stacks in the caches now */
+  } myth_worker_stats_t;
+
+  /*
+    Type: myth_steal_stats_t
+
+    Steals of a worker from one victim, filled by <myth_get_stats>.
+  */
+  typedef struct myth_steal_stats {
+    unsigned long long n_attempts;
+    unsigned long long n_hits;
+    unsigned long long n_misses;
+  } myth_steal_stats_t;
+
+  /*
+    Type: myth_stats_t
+
+    A snapshot of the scheduler counters, filled by <myth_get_stats>.
+    Set workers and steals before the call to obtain the counters
+    of each worker and each thief/victim pair.
+  */
+  typedef struct myth_stats {
+    int n_workers;		/* out: the number of workers */
+    myth_worker_stats_t total;	/* out: sums over workers (queue_high_water is the maximum) */
+    myth_worker_stats_t * workers; /* in: NULL, or myth_get_num_workers() entries */
+    myth_steal_stats_t * steals;   /* in: NULL, or myth_get_num_workers()^2 entries,
+				      steals[thief * n_workers + victim] */
+  } myth_stats_t;
+
+  /*
+    Function: myth_get_stats
+
+    Take a snapshot of the counters every worker keeps:
+    threads created, steal attempts/hits/misses (per victim),
+    idle time, the high-water mark of the runqueue and the
+    number of stacks cached. They are always kept and cost
+    a few increments on the paths they count, so this may be
+    called any time, from any thread, to monitor a running
+    program. Workers update them while they are read, so the
+    numbers may be a little stale.
+
+    Parameters:
+
+    s - a pointer to a structure to fill. s->workers and s->steals
+    are arrays to fill, or NULL.
+
+    Returns:
+
+    Zero.
+
+    See Also:
+
+    <myth_get_num_workers>
+  */
+  int myth_get_stats(myth_stats_t * s);
+
   typedef pthread_key_t myth_wls_key_t;
 
   /*
@@ -1648,11 +2093,87 @@ extern "C" {
      declare myth_pickle_t to be an opaque structure
    */
   typedef struct myth_pickle myth_pickle_t;
+
+  /*
+    Function: myth_pickle_size
+
+    Parameters:
+
+    th - a suspended thread (e.g., one obtained by myth_steal).
+
+    Returns:
+
+    the number of bytes myth_serialize writes for th.
+    A pickle has a versioned header followed by the part
+    of the stack th actually uses, so it is usually a few
+    kilobytes regardless of the stack size.
+  */
+  size_t myth_pickle_size(myth_thread_t th);
+
+  /*
+    Function: myth_serialize
+
+    Serialize a suspended thread th into p, which must have
+    myth_pickle_size(th) bytes. The first 32 bits of p are
+    a magic number and the next 32 bits are its version.
+  */
   void myth_serialize(myth_thread_t th,myth_pickle_t * p);
 #define myth_ext_serialize(th,p) myth_serialize(th,p)
+
+  /*
+    Function: myth_pickle_valid
+
+    Check a pickle received in a buffer of size bytes (e.g.,
+    from another process) before deserializing it.
+
+    Returns:
+
+    nonzero if p is a pickle of this version and the buffer
+    holds all of it, zero if the header is corrupted, of
+    another version, or p has been truncated.
+  */
+  int myth_pickle_valid(myth_pickle_t * p, size_t size);
+
+  /*
+    Function: myth_deserialize
+
+    Make a thread out of a pickle made by myth_serialize,
+    possibly in another process of the same program. Its
+    stack is mapped at the same address as it was.
+
+    Returns:
+
+    the thread, which can be passed to myth_import, or NULL
+    if p is not a pickle of this version or the address of
+    the stack is in use.
+
+    See Also:
+
+    <myth_deserialize_into>
+  */
   myth_thread_t myth_deserialize(myth_pickle_t * p);
   myth_thread_t myth_ext_deserialize(myth_pickle_t * p);
 
+  /*
+    Function: myth_deserialize_into
+
+    Same as myth_deserialize, except that the stack goes into
+    [addr, addr + size), an address range the caller has reserved
+    (e.g., by mmap with PROT_NONE) for stacks of migrating threads.
+    Only the pages of the stack are made accessible and only the
+    live part of it is written. The pages belong to the thread
+    (and then to the stack cache) afterwards.
+
+    Returns:
+
+    the thread, or NULL if p is not a pickle of this version or
+    its stack is not within the range.
+  */
+  myth_thread_t myth_deserialize_into(myth_pickle_t * p,
+				      void * addr, size_t size);
+  myth_thread_t myth_ext_deserialize_into(myth_pickle_t * p,
+					  void * addr, size_t size);
+
   myth_thread_t myth_steal(void);
 #define myth_ext_steal() myth_steal()
   void myth_import(myth_thread_t th);
@@ -0,0 +1,219 @@
+/*
+ * futures on top of MassiveThreads
+
+ it supports the following interface, similar to (a subset of)
+ std::future, std::promise and std::async of C++11, plus then().
+
+// run f() in a new thread and return a future of its value
+template<typename F>
+future<R> async( F f );               // R is the type of f()
+
+template<typename T> class future {
+  bool valid() const;                 // refers to a value
+  bool ready() const;                 // the value has been set
+  void wait() const;                  // block until it is set
+  const T& get() const;               // wait and return the value
+  template<typename G>
+  future<R> then( G g ) const;        // R is the type of g(get())
+};
+
+template<typename T> class promise {
+  future<T> get_future() const;
+  void set_value( const T& x );       // set it once (std::future_error
+                                      // with promise_already_satisfied
+                                      // if it has been set)
+};
+
+it is built on myth_future_t of MassiveThreads (see myth.h),
+so values live in the shared state of a future (not
+separately allocated) and get() sleeps, rather than spins,
+until the value is set.  unlike std::future, futures can be
+copied and get() called many times, like std::shared_future.
+
+then(g) does not create or block any thread; g is called
+with the value by the thread that sets it (or by the caller
+of then if it has already been set), and its return value
+becomes the value of the returned future.  g should thus be
+short; call async in it for a longer job.
+
+T (and the type returned by the function given to async or
+then) must not be void, nor be aligned more strictly than
+long double.  exceptions thrown by f or g are not carried
+to get().  it needs C++11.
+
+To use this file on top of MassiveThreads, you should
+include the following files.
+
+#include <myth.h>
+#include <mtbb/future.h>
+
+ */
+
+#pragma once
+#include <future>
+#include <new>
+#include <utility>
+#include <myth/myth.h>
+
+namespace mtbb {
+
+  template<typename T> class future;
+  template<typename T> class promise;
+
+  /* the state shared by futures and a promise of a value.
+     it is deleted when the last of them (or a pending
+     continuation) releases it */
+  template<typename T>
+    struct future_state {
+      myth_future_t f[1];
+      volatile long refcount;
+    future_state() : refcount(1) {
+        static_assert(alignof(T) <= alignof(long double),
+                      "mtbb::future: T aligned too strictly");
+        myth_future_init(f, sizeof(T));
+      }
+      virtual ~future_state() {
+        if (myth_future_ready(f)) {
+          value()->~T();
+        }
+        myth_future_destroy(f);
+      }
+      T * value() {
+        return (T *)myth_future_value(f);
+      }
+      /* claim the future, construct the value in place and
+         wake up waiters. a second set leaves the value as it is */
+      template<typename X>
+        void set(X&& x) {
+        if (myth_future_claim(f) != 0) {
+          throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+        new (myth_future_value(f)) T(std::forward<X>(x));
+        myth_future_publish(f);
+      }
+      void ref() {
+        __sync_fetch_and_add(&refcount, 1);
+      }
+      void unref() {
+        if (__sync_sub_and_fetch(&refcount, 1) == 0) {
+          delete this;
+        }
+      }
+    };
+
+  /* the state of a future returned by then(g), which is
+     also the continuation attached to the source future */
+  template<typename T, typename R, typename G>
+    struct future_then_state : future_state<R> {
+      myth_future_cont_t cont[1];
+      future_state<T> * src;
+      G g;
+    future_then_state(future_state<T> * src_, const G& g_) :
+      future_state<R>(), src(src_), g(g_) {}
+      static void run(myth_future_t * f, void * arg) {
+        future_then_state * s = (future_then_state *)arg;
+        s->set(s->g(*(const T *)myth_future_value(f)));
+        s->src->unref();
+        s->src = 0;
+        /* the reference held by the continuation */
+        s->unref();
+      }
+    };
+
+  template<typename T>
+    class future {
+    future_state<T> * s;
+    friend class promise<T>;
+    template<typename F> friend
+      future<decltype(std::declval<F>()())> async(F f);
+    template<typename U> friend class future;
+    /* take the reference of s */
+    explicit future(future_state<T> * s_) : s(s_) {}
+  public:
+  future() : s(0) {}
+  future(const future& x) : s(x.s) {
+      if (s) s->ref();
+    }
+    ~future() {
+      if (s) s->unref();
+    }
+    future& operator=(const future& x) {
+      if (x.s) x.s->ref();
+      if (s) s->unref();
+      s = x.s;
+      return *this;
+    }
+    bool valid() const {
+      return s != 0;
+    }
+    bool ready() const {
+      return myth_future_ready(s->f);
+    }
+    void wait() const {
+      myth_future_get(s->f, 0);
+    }
+    const T& get() const {
+      myth_future_get(s->f, 0);
+      return *s->value();
+    }
+    template<typename G>
+      future<decltype(std::declval<G>()(std::declval<const T&>()))>
+      then(G g) const {
+      typedef decltype(std::declval<G>()(std::declval<const T&>())) R;
+      future_then_state<T,R,G> * t = new future_then_state<T,R,G>(s, g);
+      /* one for the returned future and one for the continuation */
+      t->ref();
+      s->ref();
+      myth_future_then(s->f, t->cont, future_then_state<T,R,G>::run, t);
+      return future<R>(t);
+    }
+  };
+
+  template<typename T>
+    class promise {
+    future_state<T> * s;
+    promise(const promise&);
+    promise& operator=(const promise&);
+  public:
+  promise() : s(new future_state<T>()) {}
+    ~promise() {
+      s->unref();
+    }
+    future<T> get_future() const {
+      s->ref();
+      return future<T>(s);
+    }
+    void set_value(const T& x) {
+      s->set(x);
+    }
+    void set_value(T&& x) {
+      s->set(std::move(x));
+    }
+  };
+
+  template<typename F, typename R>
+    struct async_arg {
+      future_state<R> * s;
+      F f;
+    async_arg(future_state<R> * s_, const F& f_) : s(s_), f(f_) {}
+      static void * run(void * arg) {
+        async_arg * a = (async_arg *)arg;
+        a->s->set(a->f());
+        a->s->unref();
+        delete a;
+        return 0;
+      }
+    };
+
+  template<typename F>
+    future<decltype(std::declval<F>()())> async(F f) {
+    typedef decltype(std::declval<F>()()) R;
+    future_state<R> * s = new future_state<R>();
+    /* one for the returned future and one for the thread */
+    s->ref();
+    myth_thread_t th = myth_create(async_arg<F,R>::run, new async_arg<F,R>(s, f));
+    myth_detach(th);
+    return future<R>(s);
+  }
+
+} /* namespace mtbb */
@@ -20,8 +20,40 @@ Func parallel_for( Index first, Index_type last,
 template<typename Range, typename Body> 
 void parallel_for( const Range& range, const Body& body );
 
+// the same, but splitting lazily (see below)
+template<typename Index, typename Func>
+Func parallel_for( Index first, Index_type last, const Func& f,
+                   const auto_partitioner& ap );
+template<typename Index, typename Func>
+Func parallel_for( Index first, Index_type last, Index step,
+                   const Func& f, const auto_partitioner& ap );
+template<typename Range, typename Body> 
+void parallel_for( const Range& range, const Body& body,
+                   const auto_partitioner& ap );
+
 The main difference from TBB is they do not take
-partitioner and task_group_context parameters.
+task_group_context parameters, and auto_partitioner is the
+only partitioner.  Without it, the iterations are divided
+eagerly down to single iterations (or to ranges not
+divisible), creating a task at every division.
+
+With auto_partitioner, the iterations are divided lazily
+(lazy binary splitting).  A task runs its iterations one
+chunk (ap.chunk iterations, or a piece of grainsize for
+ranges) at a time and halves the rest, giving one half
+to a new task, only when its worker's runqueue is empty,
+i.e., when a thief has taken everything it exposed.  When
+nobody steals, a loop creates only a few tasks.  By default
+(auto_partitioner()) the chunk of the index-based forms is
+adaptive: it starts at one iteration and doubles every time
+the runqueue is found non-empty, up to
+MTBB_AUTO_PARTITIONER_MAX_CHUNK (256) iterations, and goes
+back to one after a division, so that checking the runqueue
+costs little on short iterations while long ones are still
+divided soon.  auto_partitioner(c) fixes it to c.  Only
+TO_MTHREAD_NATIVE can tell whether the runqueue is empty;
+on other backends auto_partitioner divides iterations
+eagerly down to chunks (and never under TO_SERIAL).
 
 range is any object implementing "Range concept"
 (http://software.intel.com/en-us/node/467886).  Among others it has
@@ -54,6 +86,32 @@ include the following files.
 
 namespace mtbb {
 
+#if !defined(MTBB_AUTO_PARTITIONER_MAX_CHUNK)
+#define MTBB_AUTO_PARTITIONER_MAX_CHUNK 256
+#endif
+
+  /* partitioner asking for lazy binary splitting.
+     chunk is the number of iterations (of the index-based forms)
+     run between checks of the runqueue; zero (the default) makes
+     it adaptive (see above) */
+  struct auto_partitioner {
+    long chunk;
+  auto_partitioner() : chunk(0) {}
+    explicit auto_partitioner(long chunk_) : chunk(chunk_ > 0 ? chunk_ : 0) {}
+  };
+
+  /* true if iterations should be divided now, i.e., a thief took
+     everything this worker exposed */
+  static inline bool lazy_split_wanted() {
+#if TO_SERIAL || TASK_GROUP_NULL_CREATE
+    return false;
+#elif TO_MTHREAD_NATIVE
+    return myth_runqueue_is_empty();
+#else
+    return true;
+#endif
+  }
+
   /* Range-class-based parallel for: BEGIN */
 #ifdef USE_OLD_RANGE_BASED_PARALLEL_FOR
   /* tbb-dependant due to the use of tbb::split() */
@@ -90,6 +148,14 @@ namespace mtbb {
     }
   }
 
+  /* tbb::split() cannot cut a piece of grainsize off a range,
+     so ranges are divided eagerly */
+  template<typename Range, typename Body>
+    void parallel_for( const Range& range, Body& body,
+                       const auto_partitioner& ) {
+    mtbb::parallel_for(range, body);
+  }
+
 #else
   /* in order to remove dependence on tbb when compiling (by removing tbb::split()),
    range is divided directly here without using its split construction */
@@ -128,6 +194,57 @@ namespace mtbb {
     }
   }
 
+  template<typename Range, typename Body>
+    void parallel_for_lazy( const Range& range, Body& body );
+
+  /* holds its range by value, as the splitting task goes on
+     dividing its own range while the child may not have started */
+  template<typename Range, typename Body>
+    struct parallel_for_lazy_callable {
+      const Range range;
+      Body & body;
+    parallel_for_lazy_callable(const Range & range_, Body & body_) :
+      range(range_), body(body_) {}
+      void operator() () const {
+        mtbb::parallel_for_lazy(range, body);
+      }
+    };
+
+  template<typename Range, typename Body>
+    void parallel_for_lazy( const Range& range_, Body& body ) {
+    task_group tg;
+    Range range(range_);
+    while (!range.empty()) {
+      if (!range.is_divisible()) {
+        body(range);
+        break;
+      } else if (lazy_split_wanted()) {
+        /* the left half goes to a child; with child-first creation
+           this task, now holding the right half, waits in the
+           runqueue for thieves */
+        const Range left(range.begin(),
+                         range.begin() + (range.end() - range.begin()) / 2u,
+                         range.grainsize());
+        tg.run_(parallel_for_lazy_callable<Range,Body>(left, body), __FILE__, __LINE__);
+        range = Range(left.end(), range.end(), range.grainsize());
+      } else {
+        /* nobody is stealing; run a piece of grainsize */
+        const Range piece(range.begin(),
+                          range.begin() + range.grainsize(),
+                          range.grainsize());
+        body(piece);
+        range = Range(piece.end(), range.end(), range.grainsize());
+      }
+    }
+    tg.wait_(__FILE__, __LINE__);
+  }
+
+  template<typename Range, typename Body>
+    void parallel_for( const Range& range, Body& body,
+                       const auto_partitioner& ) {
+    mtbb::parallel_for_lazy(range, body);
+  }
+
 #endif
   /* Range-class-based parallel for: END */
 
@@ -194,6 +311,70 @@ namespace mtbb {
   /* index-based parallel: END */
 
 
+  /* index-based parallel for with lazy splitting: BEGIN */
+
+  template<typename Index, typename Func>
+    void parallel_for_lazy_aux(Index first,
+                               Index a, Index b, Index step, Index chunk,
+                               const Func& f);
+
+  template<typename Index, typename Func>
+    struct parallel_for_lazy_aux_callable {
+      Index first;
+      Index a;
+      Index b;
+      Index step;
+      Index chunk;
+      const Func & f;
+    parallel_for_lazy_aux_callable(Index first_, Index a_, Index b_, Index step_, Index chunk_, const Func & f_) :
+      first(first_), a(a_), b(b_), step(step_), chunk(chunk_), f(f_) {}
+      void operator() () const {
+        parallel_for_lazy_aux(first, a, b, step, chunk, f);
+      }
+    };
+
+  template<typename Index, typename Func>
+    void parallel_for_lazy_aux(Index first,
+                               Index a, Index b, Index step, Index chunk,
+                               const Func& f) {
+    mtbb::task_group tg;
+    /* iterations to run before the next check */
+    Index n = (chunk > 0 ? chunk : Index(1));
+    while (a < b) {
+      if (b - a > n && lazy_split_wanted()) {
+        /* [a,c) goes to a child, [c,b) stays with this task */
+        const Index c = a + (b - a) / 2;
+        tg.run_(parallel_for_lazy_aux_callable<Index,Func>(first, a, c, step, chunk, f), __FILE__, __LINE__);
+        a = c;
+        if (chunk <= 0) n = 1;
+      } else {
+        const Index c = (b - a > n ? a + n : b);
+        for (; a < c; a++) {
+          f(first + a * step);
+        }
+        if (chunk <= 0 && n < MTBB_AUTO_PARTITIONER_MAX_CHUNK) n *= 2;
+      }
+    }
+    tg.wait_(__FILE__, __LINE__);
+  }
+
+  template<typename Index, typename Func>
+    Func parallel_for(Index first, Index last, Index step,
+                      const Func& f, const auto_partitioner& ap) {
+    parallel_for_lazy_aux(first, Index(0), (last - first + step - 1) / step, step, Index(ap.chunk), f);
+    return f;
+  }
+
+  template<typename Index, typename Func>
+    Func parallel_for(Index first, Index last,
+                      const Func& f, const auto_partitioner& ap) {
+    parallel_for_lazy_aux(first, Index(0), (last - first), Index(1), Index(ap.chunk), f);
+    return f;
+  }
+
+  /* index-based parallel for with lazy splitting: END */
+
+
   /* index-based parallel for with grainsize: BEGIN */
 
   template<typename Index, typename Func>
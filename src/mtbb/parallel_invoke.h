@@ -0,0 +1,58 @@
+/*
+ * parallel_invoke implementation on top of MassiveThreads
+
+ it supports an interface similar to TBB's parallel_invoke
+ (http://software.intel.com/en-us/node/506156)
+
+// call f0(), f1(), ... in parallel and return when all returned
+template<typename Func0, typename... Funcs>
+void parallel_invoke( const Func0& f0, const Funcs&... fs );
+
+every function but the last runs in a task of a task_group
+(i.e., a thread created by myth_create and joined by myth_join
+on MassiveThreads); the last one runs in the caller.
+unlike TBB, the number of functions is not limited (TBB takes
+2 to 10), but it needs C++11 variadic templates.
+
+To use this file on top of MassiveThreads, you should
+include the following files.
+
+#include <myth.h>
+#include <mtbb/parallel_invoke.h>
+
+ */
+
+#pragma once
+#include <mtbb/task_group.h>
+
+namespace mtbb {
+
+  template<typename Func>
+    struct parallel_invoke_callable {
+      const Func & f;
+    parallel_invoke_callable(const Func & f_) : f(f_) {}
+      void operator() () const {
+        f();
+      }
+    };
+
+  template<typename Func>
+    void parallel_invoke_aux(task_group& tg, const Func& f) {
+    (void)tg;
+    f();
+  }
+
+  template<typename Func, typename... Funcs>
+    void parallel_invoke_aux(task_group& tg, const Func& f, const Funcs&... fs) {
+    tg.run_(parallel_invoke_callable<Func>(f), __FILE__, __LINE__);
+    parallel_invoke_aux(tg, fs...);
+  }
+
+  template<typename Func0, typename... Funcs>
+    void parallel_invoke(const Func0& f0, const Funcs&... fs) {
+    task_group tg;
+    parallel_invoke_aux(tg, f0, fs...);
+    tg.wait_(__FILE__, __LINE__);
+  }
+
+} /* namespace mtbb */
@@ -25,10 +25,17 @@ but I believe this is a documentation bug, since body is supposed to
 modify its variables along the way.  tbb's implementation also does
 not have const qualifier, as a matter of fact.
 
+both of the above divide range with tbb::split() and make a value
+(or a body) at every division.  when values are large (e.g.,
+histograms), use parallel_reduce_per_worker instead, which makes
+one per worker (see parallel_reduce_per_worker.h, which can be
+included without TBB).
+
 */
 
 #pragma once
 #include <mtbb/task_group.h>
+#include <mtbb/parallel_reduce_per_worker.h>
 
 namespace mtbb {
 
@@ -0,0 +1,152 @@
+/* 
+ * parallel_reduce with an accumulator per worker, on top of MassiveThreads
+
+ mtbb::parallel_reduce (parallel_reduce.h) divides range with
+ tbb::split() and makes a value (or a body) at every division,
+ which is costly when values are large (e.g., histograms).
+ it supports the following interface instead, which is not in TBB.
+
+template<typename Range, typename Value,
+         typename Func, typename Reduction>
+Value parallel_reduce_per_worker( const Range& range,
+                                  const Value& identity,
+                                  const Func& func,
+                                  const Reduction& reduction );
+
+it makes at most one accumulator per worker, as a copy of
+identity, and func(r, acc) adds subrange r into accumulator acc
+of the worker running it (acc is a Value&).  then accumulators
+are combined in parallel along a binary tree, by
+reduction(x, y), which adds y into x (x is a Value& and y a
+const Value&); it must be associative and commutative, since
+which subranges go to which worker is up to the scheduler.
+range is divided lazily as by parallel_for with
+auto_partitioner (see parallel_for.h), so it needs no
+tbb::split().  func must not create threads or block, so
+that it stays on one worker while it uses acc.
+
+To use this file on top of MassiveThreads, you should
+include the following files.
+
+#include <myth.h>
+#include <mtbb/parallel_reduce_per_worker.h>
+
+ */
+
+#pragma once
+#include <vector>
+#include <mtbb/task_group.h>
+#include <mtbb/parallel_for.h>
+#if TO_MTHREAD
+#include <myth/myth.h>
+#elif TO_TBB
+#include <tbb/task_arena.h>
+#endif
+
+namespace mtbb {
+
+  /* reduce with an accumulator per worker */
+#if TO_SERIAL || TO_MTHREAD || TO_MTHREAD_NATIVE || TO_QTHREAD || TO_TBB
+#define MTBB_HAVE_PARALLEL_REDUCE_PER_WORKER 1
+
+  static inline int reduce_get_worker() {
+#if TO_SERIAL
+    return 0;
+#elif TO_MTHREAD || TO_MTHREAD_NATIVE
+    return myth_get_worker_num();
+#elif TO_QTHREAD
+    return qthread_worker(NULL);
+#elif TO_TBB
+    return tbb::this_task_arena::current_thread_index();
+#endif
+  }
+
+  static inline int reduce_get_max_workers() {
+#if TO_SERIAL
+    return 1;
+#elif TO_MTHREAD || TO_MTHREAD_NATIVE
+    return myth_get_num_workers();
+#elif TO_QTHREAD
+    return qthread_num_workers();
+#elif TO_TBB
+    return tbb::this_task_arena::max_concurrency();
+#endif
+  }
+
+  /* called by parallel_for on subranges. accs[w] is the
+     accumulator of worker w, made when w first needs it */
+  template<typename Range, typename Value, typename Func>
+    struct parallel_reduce_per_worker_body {
+      std::vector<Value *> & accs;
+      const Value& identity;
+      const Func& func;
+    parallel_reduce_per_worker_body(std::vector<Value *> & accs_,
+                                    const Value& identity_,
+                                    const Func& func_) :
+      accs(accs_), identity(identity_), func(func_) {}
+      void operator() (const Range& r) const {
+        Value *& acc = accs[reduce_get_worker()];
+        if (!acc) acc = new Value(identity);
+        func(r, *acc);
+      }
+    };
+
+  /* add accs[a+1..b-1] into accs[a] and delete them */
+  template<typename Value, typename Reduction>
+    void parallel_reduce_combine(std::vector<Value *> & accs, size_t a, size_t b,
+                                 const Reduction& reduction);
+
+  template<typename Value, typename Reduction>
+    struct parallel_reduce_combine_callable {
+      std::vector<Value *> & accs;
+      size_t a;
+      size_t b;
+      const Reduction& reduction;
+    parallel_reduce_combine_callable(std::vector<Value *> & accs_, size_t a_, size_t b_,
+                                     const Reduction& reduction_) :
+      accs(accs_), a(a_), b(b_), reduction(reduction_) {}
+      void operator() () const {
+        mtbb::parallel_reduce_combine(accs, a, b, reduction);
+      }
+    };
+
+  template<typename Value, typename Reduction>
+    void parallel_reduce_combine(std::vector<Value *> & accs, size_t a, size_t b,
+                                 const Reduction& reduction) {
+    if (b - a > 1) {
+      task_group tg;
+      const size_t c = a + (b - a) / 2;
+      tg.run_(parallel_reduce_combine_callable<Value,Reduction>(accs, a, c, reduction), __FILE__, __LINE__);
+      mtbb::parallel_reduce_combine(accs, c, b, reduction);
+      tg.wait_(__FILE__, __LINE__);
+      reduction(*accs[a], *accs[c]);
+      delete accs[c];
+    }
+  }
+
+  template<typename Range, typename Value,
+    typename Func, typename Reduction>
+    Value parallel_reduce_per_worker(const Range& range,
+                                     const Value& identity,
+                                     const Func& func,
+                                     const Reduction& reduction) {
+    std::vector<Value *> accs(reduce_get_max_workers(), (Value *)0);
+    parallel_reduce_per_worker_body<Range,Value,Func> body(accs, identity, func);
+    mtbb::parallel_for(range, body, auto_partitioner());
+    /* pack accumulators of workers that ran subranges */
+    size_t n = 0;
+    for (size_t i = 0; i < accs.size(); i++) {
+      if (accs[i]) accs[n++] = accs[i];
+    }
+    if (n == 0) {
+      accs[n++] = new Value(identity);
+    }
+    mtbb::parallel_reduce_combine(accs, 0, n, reduction);
+    Value result(*accs[0]);
+    delete accs[0];
+    return result;
+  }
+
+#endif
+
+} /* namespace mtbb */
@@ -0,0 +1,180 @@
+/*
+ * parallel_scan implementation on top of MassiveThreads
+
+ it supports an interface similar to the functional form of
+ TBB's parallel_scan
+ (https://oneapi-src.github.io/oneTBB/main/tbb_userguide/parallel_scan.html)
+
+// compute prefix sums over range.
+template<typename Range, typename Value,
+         typename Scan, typename Combine>
+Value parallel_scan( const Range& range, const Value& identity,
+                     const Scan& scan, const Combine& combine );
+
+scan(r, sum, is_final) must return sum followed by the elements
+of subrange r (e.g., sum + x[i] + ... for i in r).  when is_final
+is true, it must also store the prefix sums of r (sum included)
+where the program wants them.  combine(left, right) must return
+the sum of two adjacent subranges (left comes first) and be
+associative.  parallel_scan returns the sum of the whole range.
+
+It is done in two passes over a tree of subranges, each of which
+runs in parallel.  The first pass divides range down to subranges
+not divisible and computes the sum of each subtree, calling
+scan(r, identity, false) on leaves.  The second pass gives each
+leaf the sum of everything on its left and calls
+scan(r, prefix, true).  Thus every element is scanned twice and
+each leaf costs a task in each pass and a tree node; choose
+the grainsize of range accordingly.
+
+Like parallel_for, range is divided directly by its begin(),
+end() and grainsize() so it does not need tbb::split().
+The imperative form of TBB (body with pre_scan_tag and
+final_scan_tag) is not supported.
+
+To use this file on top of MassiveThreads, you should
+include the following files.
+
+#include <myth.h>
+#include <mtbb/parallel_scan.h>
+
+ */
+
+#pragma once
+#include <mtbb/task_group.h>
+
+namespace mtbb {
+
+  /* a subtree made in the first pass. sum is the sum of its
+     subrange; leaves have no children */
+  template<typename Value>
+    struct parallel_scan_node {
+      Value sum;
+      parallel_scan_node * left;
+      parallel_scan_node * right;
+    parallel_scan_node(const Value& identity) :
+      sum(identity), left(0), right(0) {}
+      ~parallel_scan_node() {
+        delete left;
+        delete right;
+      }
+    };
+
+  /* first pass: compute sums */
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    void parallel_scan_up(parallel_scan_node<Value> * node,
+                          const Range& range,
+                          const Value& identity,
+                          const Scan& scan,
+                          const Combine& combine);
+
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    struct parallel_scan_up_callable {
+      parallel_scan_node<Value> * node;
+      const Range& range;
+      const Value& identity;
+      const Scan& scan;
+      const Combine& combine;
+    parallel_scan_up_callable(parallel_scan_node<Value> * node_,
+                              const Range& range_, const Value& identity_,
+                              const Scan& scan_, const Combine& combine_) :
+      node(node_), range(range_), identity(identity_),
+        scan(scan_), combine(combine_) {}
+      void operator() () const {
+        mtbb::parallel_scan_up(node, range, identity, scan, combine);
+      }
+    };
+
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    void parallel_scan_up(parallel_scan_node<Value> * node,
+                          const Range& range,
+                          const Value& identity,
+                          const Scan& scan,
+                          const Combine& combine) {
+    if (!range.is_divisible()) {
+      node->sum = scan(range, identity, false);
+    } else {
+      task_group tg;
+      const Range left(range.begin(),
+                       range.begin() + (range.end() - range.begin()) / 2u,
+                       range.grainsize());
+      const Range right(left.end(), range.end(), range.grainsize());
+      node->left = new parallel_scan_node<Value>(identity);
+      node->right = new parallel_scan_node<Value>(identity);
+      tg.run_(parallel_scan_up_callable<Range,Value,Scan,Combine>(node->left, left, identity, scan, combine), __FILE__, __LINE__);
+      mtbb::parallel_scan_up(node->right, right, identity, scan, combine);
+      tg.wait_(__FILE__, __LINE__);
+      node->sum = combine(node->left->sum, node->right->sum);
+    }
+  }
+
+  /* second pass: scan leaves with the sums on their left */
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    void parallel_scan_down(const parallel_scan_node<Value> * node,
+                            const Range& range,
+                            const Value& prefix,
+                            const Scan& scan,
+                            const Combine& combine);
+
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    struct parallel_scan_down_callable {
+      const parallel_scan_node<Value> * node;
+      const Range& range;
+      const Value& prefix;
+      const Scan& scan;
+      const Combine& combine;
+    parallel_scan_down_callable(const parallel_scan_node<Value> * node_,
+                                const Range& range_, const Value& prefix_,
+                                const Scan& scan_, const Combine& combine_) :
+      node(node_), range(range_), prefix(prefix_),
+        scan(scan_), combine(combine_) {}
+      void operator() () const {
+        mtbb::parallel_scan_down(node, range, prefix, scan, combine);
+      }
+    };
+
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    void parallel_scan_down(const parallel_scan_node<Value> * node,
+                            const Range& range,
+                            const Value& prefix,
+                            const Scan& scan,
+                            const Combine& combine) {
+    if (!node->left) {
+      scan(range, prefix, true);
+    } else {
+      /* divide range exactly as the first pass did */
+      task_group tg;
+      const Range left(range.begin(),
+                       range.begin() + (range.end() - range.begin()) / 2u,
+                       range.grainsize());
+      const Range right(left.end(), range.end(), range.grainsize());
+      const Value right_prefix = combine(prefix, node->left->sum);
+      tg.run_(parallel_scan_down_callable<Range,Value,Scan,Combine>(node->left, left, prefix, scan, combine), __FILE__, __LINE__);
+      mtbb::parallel_scan_down(node->right, right, right_prefix, scan, combine);
+      tg.wait_(__FILE__, __LINE__);
+    }
+  }
+
+  template<typename Range, typename Value,
+    typename Scan, typename Combine>
+    Value parallel_scan(const Range& range,
+                        const Value& identity,
+                        const Scan& scan,
+                        const Combine& combine) {
+    if (range.empty()) {
+      return identity;
+    } else {
+      parallel_scan_node<Value> root(identity);
+      mtbb::parallel_scan_up(&root, range, identity, scan, combine);
+      mtbb::parallel_scan_down(&root, range, identity, scan, combine);
+      return root.sum;
+    }
+  }
+
+} /* namespace mtbb */
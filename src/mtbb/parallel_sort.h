@@ -0,0 +1,152 @@
+/*
+ * parallel_sort implementation on top of MassiveThreads
+
+ it supports an interface similar to TBB's parallel_sort
+ (http://software.intel.com/en-us/node/506167)
+
+// sort [first, last) with comp (std::less by default)
+template<typename RandomAccessIterator>
+void parallel_sort( RandomAccessIterator first,
+                    RandomAccessIterator last );
+template<typename RandomAccessIterator, typename Compare>
+void parallel_sort( RandomAccessIterator first,
+                    RandomAccessIterator last,
+                    const Compare& comp );
+
+// sort a container having begin() and end()
+template<typename Container>
+void parallel_sort( Container& c );
+
+It is a quicksort whose two partitions are sorted in parallel.
+The pivot is the median of nine elements.  When few elements
+are below it, elements equal to it are also moved out of the
+right partition, so that many duplicates do not make it
+quadratic.  Partitions of up to MTBB_PARALLEL_SORT_CUTOFF
+elements are sorted by std::sort.  Like TBB's, it is not stable.
+
+To use this file on top of MassiveThreads, you should
+include the following files.
+
+#include <myth.h>
+#include <mtbb/parallel_sort.h>
+
+ */
+
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mtbb/task_group.h>
+
+#if !defined(MTBB_PARALLEL_SORT_CUTOFF)
+#define MTBB_PARALLEL_SORT_CUTOFF 500
+#endif
+
+namespace mtbb {
+
+  template<typename RandomAccessIterator, typename Compare>
+    void parallel_sort(RandomAccessIterator first,
+                       RandomAccessIterator last,
+                       const Compare& comp);
+
+  template<typename RandomAccessIterator, typename Compare>
+    struct parallel_sort_callable {
+      RandomAccessIterator first;
+      RandomAccessIterator last;
+      const Compare & comp;
+    parallel_sort_callable(RandomAccessIterator first_,
+                           RandomAccessIterator last_,
+                           const Compare & comp_) :
+      first(first_), last(last_), comp(comp_) {}
+      void operator() () const {
+        mtbb::parallel_sort(first, last, comp);
+      }
+    };
+
+  /* x < pivot */
+  template<typename T, typename Compare>
+    struct parallel_sort_below {
+      const T & pivot;
+      const Compare & comp;
+    parallel_sort_below(const T & pivot_, const Compare & comp_) :
+      pivot(pivot_), comp(comp_) {}
+      bool operator() (const T & x) const {
+        return comp(x, pivot);
+      }
+    };
+
+  /* x <= pivot */
+  template<typename T, typename Compare>
+    struct parallel_sort_not_above {
+      const T & pivot;
+      const Compare & comp;
+    parallel_sort_not_above(const T & pivot_, const Compare & comp_) :
+      pivot(pivot_), comp(comp_) {}
+      bool operator() (const T & x) const {
+        return !comp(pivot, x);
+      }
+    };
+
+  template<typename RandomAccessIterator, typename Compare>
+    RandomAccessIterator parallel_sort_median3(RandomAccessIterator a,
+                                               RandomAccessIterator b,
+                                               RandomAccessIterator c,
+                                               const Compare& comp) {
+    if (comp(*a, *b)) {
+      if (comp(*b, *c)) return b;
+      return (comp(*a, *c) ? c : a);
+    } else {
+      if (comp(*a, *c)) return a;
+      return (comp(*b, *c) ? c : b);
+    }
+  }
+
+  template<typename RandomAccessIterator, typename Compare>
+    void parallel_sort(RandomAccessIterator first,
+                       RandomAccessIterator last,
+                       const Compare& comp) {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    typedef typename std::iterator_traits<RandomAccessIterator>::difference_type D;
+    const D n = last - first;
+    if (n <= MTBB_PARALLEL_SORT_CUTOFF) {
+      std::sort(first, last, comp);
+    } else {
+      task_group tg;
+      const D s = n / 8;
+      const RandomAccessIterator mid = first + n / 2;
+      const RandomAccessIterator p
+        = parallel_sort_median3(parallel_sort_median3(first, first + s, first + 2 * s, comp),
+                                parallel_sort_median3(mid - s, mid, mid + s, comp),
+                                parallel_sort_median3(last - 1 - 2 * s, last - 1 - s, last - 1, comp),
+                                comp);
+      /* the pivot stays at first while [first + 1, last)
+         is partitioned, and then goes to m */
+      std::iter_swap(first, p);
+      RandomAccessIterator m
+        = std::partition(first + 1, last, parallel_sort_below<T,Compare>(*first, comp));
+      --m;
+      std::iter_swap(first, m);
+      /* now [first, m) < *m <= [m + 1, last) */
+      RandomAccessIterator r = m + 1;
+      if (m - first < n / 8) {
+        r = std::partition(r, last, parallel_sort_not_above<T,Compare>(*m, comp));
+      }
+      tg.run_(parallel_sort_callable<RandomAccessIterator,Compare>(first, m, comp), __FILE__, __LINE__);
+      mtbb::parallel_sort(r, last, comp);
+      tg.wait_(__FILE__, __LINE__);
+    }
+  }
+
+  template<typename RandomAccessIterator>
+    void parallel_sort(RandomAccessIterator first,
+                       RandomAccessIterator last) {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type T;
+    mtbb::parallel_sort(first, last, std::less<T>());
+  }
+
+  template<typename Container>
+    void parallel_sort(Container& c) {
+    mtbb::parallel_sort(c.begin(), c.end());
+  }
+
+} /* namespace mtbb */
@@ -21,6 +21,9 @@
 #include <string.h>
 #include <functional>
 #include <new>
+#if __cplusplus >= 201103L
+#include <type_traits>
+#endif
 
 /* 
  * 
@@ -82,6 +85,17 @@
 #define TASK_MEMORY_CHUNK_SZ 256
 #endif
 
+/* if set to one, task_group is task_group_lean, which
+   allocates nothing per task (only with TO_MTHREAD_NATIVE
+   and C++11, where it is the default) */
+#if !defined(TASK_GROUP_LEAN)
+#if TO_MTHREAD_NATIVE && !TASK_GROUP_NULL_CREATE && !EASY_PAPI2 && !EASY_PAPI && __cplusplus >= 201103L
+#define TASK_GROUP_LEAN 1
+#else
+#define TASK_GROUP_LEAN 0
+#endif
+#endif
+
 #if !defined(DAG_RECORDER)
 #define DAG_RECORDER_VER 0	/* old version */
 #endif
@@ -429,6 +443,129 @@ namespace mtbb {
     }
   };
 
+#if TO_MTHREAD_NATIVE && TASK_GROUP_LEAN
+  /* a leaner task group, which keeps neither task objects nor
+     memory for them.  run() copies the callable onto the stack
+     of the new thread (custom_data of myth_thread_attr_t) and
+     keeps only its handle, which wait() passes to myth_join.
+     a run() thus costs little more than a myth_create.
+     callables that cannot be copied by memcpy (e.g., those
+     holding a std::string) are copied by new instead */
+
+  /* attributes of threads of task_group_lean,
+     taken from the global ones when first used.
+     stacksize 0 takes a stack of the default size from the
+     worker's free list, as myth_create does */
+  static inline myth_thread_attr_t lean_task_make_attr() {
+    myth_thread_attr_t attr;
+    myth_thread_attr_init(&attr);
+    attr.stacksize = 0;
+    return attr;
+  }
+
+  static inline const myth_thread_attr_t & lean_task_attr() {
+    static const myth_thread_attr_t attr = lean_task_make_attr();
+    return attr;
+  }
+
+  template<typename C,
+    bool trivial = std::is_trivially_copyable<C>::value>
+    struct lean_task {
+      static th_func_ret_type invoke(void * arg) {
+        (void)arg;
+        C * c = (C *)myth_wsapi_get_hint_ptr(myth_self());
+        (*c)();
+        return 0;
+      }
+      static myth_thread_t create(const C & c) {
+        myth_thread_attr_t attr = lean_task_attr();
+        myth_thread_t th = 0;
+        attr.custom_data_size = sizeof(C);
+        attr.custom_data = (void *)&c;
+        myth_create_ex(&th, &attr, invoke, 0);
+        return th;
+      }
+    };
+
+  template<typename C>
+    struct lean_task<C, false> {
+      static th_func_ret_type invoke(void * arg) {
+        C * c = (C *)arg;
+        (*c)();
+        delete c;
+        return 0;
+      }
+      static myth_thread_t create(const C & c) {
+        return myth_create(invoke, (void *)new C(c));
+      }
+    };
+
+  /* handles of outstanding threads; the first node
+     lives in task_group_lean */
+  struct lean_task_list_node {
+    lean_task_list_node * next;
+    int n;
+    myth_thread_t a[TASK_GROUP_INIT_SZ];
+  };
+
+  struct task_group_lean {
+    lean_task_list_node head[1];
+    lean_task_list_node * tail;
+    task_group_lean() {
+      head->next = NULL;
+      head->n = 0;
+      tail = head;
+    }
+
+    /* run any callable object (e.g., closure) */
+    template<typename C>
+    void run(C c) {
+      if (tail->n == TASK_GROUP_INIT_SZ) {
+        lean_task_list_node * p = new lean_task_list_node();
+        p->next = NULL;
+        p->n = 0;
+        tail->next = p;
+        tail = p;
+      }
+      tail->a[tail->n++] = mtbb::lean_task<C>::create(c);
+    }
+
+    /* run if x is true. otherwise call it in serial */
+    template<typename C>
+    void run_if(bool x, C c) {
+      if (x) c();
+      else run(c);
+    }
+
+    void wait() {
+      lean_task_list_node * q = NULL;
+      for (lean_task_list_node * p = head; p; p = q) {
+        for (int i = 0; i < p->n; i++) {
+          myth_join(p->a[i], NULL);
+        }
+        q = p->next;
+        if (p != head) delete p;
+      }
+      head->next = NULL;
+      head->n = 0;
+      tail = head;
+    }
+
+    template<typename C>
+    void run_(C c, const char * file, int line) {
+      (void)file;
+      (void)line;
+      run(c);
+    }
+
+    void wait_(const char * file, int line) {
+      (void)file;
+      (void)line;
+      wait();
+    }
+  };
+#endif
+
 #endif	/* TO_TBB. have defined task_group_no_prof */
 
 
@@ -521,6 +658,10 @@ namespace mtbb {
   };
   typedef task_group_with_prof task_group;
 
+#elif TO_MTHREAD_NATIVE && TASK_GROUP_LEAN
+
+  typedef task_group_lean task_group;
+
 #else
 
   typedef task_group_no_prof task_group;
@@ -258,16 +258,73 @@ void myth_get_available_cpus(void) {
 #endif	/* debug */
 }
 
+/* the cpu worker rank is bound to, or -1 if it is not bound */
+int myth_get_worker_cpu(int rank) {
 #if defined(HAVE_PTHREAD_AFFINITY_NP)
-static int myth_get_worker_cpu(int rank) {
   assert(n_available_cpus >= 0);
   if (n_available_cpus == 0) {
     return -1;			/* no bind */
   } else {
     return worker_cpu[rank % n_available_cpus];
   }
-}
+#else
+  (void)rank;
+  return -1;
 #endif
+}
+
+/* read the first integer of /sys/devices/system/cpu/cpuN/<file>.
+   for a cpu list like "4-5" or "4,36", this is the lowest cpu */
+static int myth_read_cpu_sysfs(int cpu, const char * file) {
+  char path[128];
+  int x = -1;
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, file);
+  FILE * fp = fopen(path, "r");
+  if (!fp) return -1;
+  if (fscanf(fp, "%d", &x) != 1) x = -1;
+  fclose(fp);
+  return x;
+}
+
+/* 
+   an id of the topology domain cpu belongs to at level,
+   or -1 if unknown.  two cpus are in the same domain iff
+   they get the same id.
+   MYTH_CPU_DOMAIN_CACHE : cpus sharing the L2 cache
+                           (SMT siblings if L2 is not found)
+   MYTH_CPU_DOMAIN_SOCKET : cpus in the same package
+   MYTH_CPU_DOMAIN_NODE : cpus in the same NUMA node
+*/
+int myth_get_cpu_domain(int cpu, int level) {
+  char file[64];
+  int i;
+  if (cpu < 0) return -1;
+  switch (level) {
+  case MYTH_CPU_DOMAIN_CACHE:
+    for (i = 0; i < 8; i++) {
+      snprintf(file, sizeof(file), "cache/index%d/level", i);
+      int l = myth_read_cpu_sysfs(cpu, file);
+      if (l == -1) break;
+      if (l == 2) {
+	snprintf(file, sizeof(file), "cache/index%d/shared_cpu_list", i);
+	return myth_read_cpu_sysfs(cpu, file);
+      }
+    }
+    return myth_read_cpu_sysfs(cpu, "topology/thread_siblings_list");
+  case MYTH_CPU_DOMAIN_SOCKET:
+    return myth_read_cpu_sysfs(cpu, "topology/physical_package_id");
+  case MYTH_CPU_DOMAIN_NODE:
+    /* cpuN has a link nodeM to its node */
+    for (i = 0; i < 1024; i++) {
+      char path[128];
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, i);
+      if (access(path, F_OK) == 0) return i;
+    }
+    return -1;
+  default:
+    return -1;
+  }
+}
 
 void myth_bind_worker(int rank) {
 #if defined(HAVE_PTHREAD_AFFINITY_NP)
@@ -8,5 +8,12 @@
 void myth_get_available_cpus(void);
 int  myth_get_n_available_cpus(void);
 void myth_bind_worker(int rank);
+int  myth_get_worker_cpu(int rank);
+
+/* levels of myth_get_cpu_domain */
+#define MYTH_CPU_DOMAIN_CACHE  0
+#define MYTH_CPU_DOMAIN_SOCKET 1
+#define MYTH_CPU_DOMAIN_NODE   2
+int  myth_get_cpu_domain(int cpu, int level);
 
 #endif	/* MYTH_BIND_WORKER_H_ */
@@ -20,6 +20,32 @@
 
 #define MYTH_PAUSE 0
 
+//Idle workers (MYTH_IDLE_POLICY=yield/park) try to steal this many
+//times before calling sched_yield,
+#define MYTH_IDLE_SPIN_COUNT 1000
+//and, with MYTH_IDLE_POLICY=park, yield this many times before parking
+#define MYTH_IDLE_YIELD_COUNT 100
+//A parked worker rechecks the run queues after this (ns) even if
+//nobody wakes it up (a safety net; pushes do wake parked workers)
+#define MYTH_IDLE_PARK_TIMEOUT_NS 10000000
+
+//Timed waits (timedlock, cond_timedwait, timedjoin, nanosleep)
+//suspend the thread on a per-worker timer wheel of this resolution
+//(ns), MYTH_TIMER_LEVELS levels of 2^MYTH_TIMER_SLOT_BITS slots
+#define MYTH_TIMER_TICK_NS 100000
+#define MYTH_TIMER_SLOT_BITS 6
+#define MYTH_TIMER_LEVELS 4
+//Timed rwlock operations sleep between attempts, doubling the
+//sleep from MYTH_TIMER_TICK_NS up to this (ns)
+#define MYTH_RWLOCK_TIMED_SLEEP_MAX_NS 1000000
+
+//Upper bound of the number of times an adaptive mutex
+//(MYTH_MUTEX_ADAPTIVE) polls the lock before blocking (at most 255)
+#define MYTH_MUTEX_SPIN_MAX 100
+//If 1, mutexes used through the wrapped pthread_mutex_lock are
+//adaptive unless MYTH_WRAP_MUTEX_ADAPTIVE=0 is set
+#define MYTH_WRAP_MUTEX_ADAPTIVE 1
+
 //Enable debug for eco-mode
 
 //Cache line size
@@ -44,8 +70,32 @@
 //Split desc and stack allocation
 #define MYTH_SPLIT_STACK_DESC 1
 
-//Runqueue length
-#define INITIAL_QUEUE_SIZE (65536*2)
+//A worker keeps this many freed stacks and descriptors for reuse
+//(MYTH_STACK_CACHE_HIGH). Pages of stacks freed beyond it are given
+//back to the OS with madvise; descriptors are unmapped
+#define MYTH_STACK_CACHE_HIGH 1024
+//Stacks freed while this many released ones are cached are unmapped
+//(MYTH_STACK_CACHE_MAX)
+#define MYTH_STACK_CACHE_MAX 16384
+
+//Default stacks are carved out of per-worker arenas of this many
+//bytes (MYTH_STACK_ARENA_SIZE), rounded up to MYTH_STACK_ARENA_ALIGN.
+//0 maps each stack separately
+#define MYTH_STACK_ARENA_SIZE (32 << 20)
+//Arenas are aligned to this (the huge page size), so that
+//MYTH_STACK_ARENA_HUGEPAGE=1 can back them by transparent huge pages
+#define MYTH_STACK_ARENA_ALIGN (2 << 20)
+
+//Initial runqueue length (must be a power of two).
+//The runqueue grows on demand, so this can be small.
+#define INITIAL_QUEUE_SIZE 256
+
+//Number of thread priority levels (myth_thread_attr_setpriority).
+//Each worker has a runqueue per level; 1 disables priorities
+#define MYTH_N_PRIORITIES 4
+//After this many consecutive threads taken from levels above 0,
+//a worker runs one from the lowest non-empty level
+#define MYTH_PRIO_STARVATION_LIMIT 64
 
 //Wrap and multipelx I/O functions
 #define MYTH_WRAP_SOCKIO 0
@@ -119,9 +169,15 @@
 #define MYTH_FLMALLOC_PROF 0
 
 //Collect and emit sslog
+#ifndef MYTH_COLLECT_LOG
 #define MYTH_COLLECT_LOG 0
-//Log buffer size
-#define MYTH_LOG_INITIAL_BUFFER_SIZE 1024
+#endif
+//Records in the ring buffer of each worker (a power of 2).
+//Records are dropped while the ring is full
+#define MYTH_LOG_RING_SIZE (1 << 16)
+//Interval (in microseconds) at which a background thread
+//writes the rings to files
+#define MYTH_LOG_WRITE_INTERVAL_US 10000
 //Collect context switching events
 #define MYTH_COLLECT_CONTEXT_SWITCH 1
 
@@ -167,6 +223,13 @@
 //Scheduling policy of runqueue
 #define MYTH_QUEUE_LIFO 1
 
+//Runqueue implementation
+//0 : thieves take the queue lock (THE protocol)
+//1 : thieves take threads by CAS without the lock (Chase-Lev style)
+#ifndef MYTH_WSQUEUE_CAS_STEAL
+#define MYTH_WSQUEUE_CAS_STEAL 0
+#endif
+
 //Confirm if a thread descriptor is used in two threads at the same time.
 #define MYTH_DESC_REUSE_CHECK 0
 
@@ -181,9 +244,6 @@
 //turned out very important; never turn off
 #define QUICK_CHECK_ON_STEAL 1
 
-//Check whether the thread is sure to be ready for release before acquiring the lock
-#define QUICK_CHECK_ON_JOIN 0
-
 //Do trylock before work stealing
 //#define TRY_LOCK_BEFORE_STEAL 1
 
@@ -330,6 +330,23 @@ static inline void myth_make_context_empty(myth_context_t ctx, void *stack,
 #endif
 }
 
+//Lowest address of the stack a suspended context uses,
+//or 0 if it is unknown
+static inline uintptr_t myth_context_stack_pointer(myth_context_t ctx) {
+#if MYTH_CONTEXT == MYTH_CONTEXT_i386
+  return (uintptr_t)ctx->esp;
+#elif MYTH_CONTEXT == MYTH_CONTEXT_amd64 || MYTH_CONTEXT == MYTH_CONTEXT_amd64_knc
+  return (uintptr_t)ctx->rsp;
+#elif MYTH_CONTEXT == MYTH_CONTEXT_sparc_v9
+  return (uintptr_t)(ctx->sp + STACKBIAS);
+#elif MYTH_CONTEXT == MYTH_CONTEXT_sparc_v8
+  return (uintptr_t)ctx->sp;
+#else
+  (void)ctx;
+  return 0;
+#endif
+}
+
 #if PIC
 #if GLOBAL_SYM_MODIFIER == GLOBAL_SYM_MODIFIER_WITH_UNDERSCORE_WITH_PLT
 #define FUNC_PREFIX "_"
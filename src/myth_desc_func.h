@@ -14,6 +14,9 @@
 #include "myth_worker.h"
 #include "myth_thread.h"
 
+#include "myth_misc_func.h"
+#include "myth_mem_barrier_func.h"
+
 static inline myth_thread_t myth_context_to_thread(myth_running_env_t env,myth_context_t ctx)
 {
   if (ctx==&env->sched.context){return NULL;}//scheduler
@@ -21,9 +24,47 @@ static inline myth_thread_t myth_context_to_thread(myth_running_env_t env,myth_c
   return (myth_thread_t)(&ctx_ptr[-offsetof(struct myth_thread,context)]);
 }
 
-static inline void myth_desc_join_set(myth_thread_t thread,myth_thread_t wait_thread)
+//Register wait_thread as the joiner of thread. Fails (returns 0)
+//if thread has finished meanwhile
+static inline int myth_desc_join_set(myth_thread_t thread,myth_thread_t wait_thread)
+{
+  return __sync_bool_compare_and_swap(&thread->join_state,
+				      MYTH_JOIN_RUNNING,(uintptr_t)wait_thread);
+}
+
+//Unregister wait_thread unless thread has finished. Returns 1 if
+//wait_thread was still waiting
+static inline int myth_desc_join_unset(myth_thread_t thread,myth_thread_t wait_thread)
+{
+  return __sync_bool_compare_and_swap(&thread->join_state,
+				      (uintptr_t)wait_thread,MYTH_JOIN_RUNNING);
+}
+
+//Called by thread itself when it finishes. Returns the previous
+//join state (i.e., the waiting thread, if any)
+static inline uintptr_t myth_desc_join_exit(myth_thread_t thread)
+{
+  uintptr_t s;
+  do {
+    s = thread->join_state;
+  } while (!__sync_bool_compare_and_swap(&thread->join_state,s,MYTH_JOIN_EXITING));
+  return s;
+}
+
+//Called once thread has left its stack; joiners may release it
+static inline void myth_desc_join_finish(myth_thread_t thread)
+{
+  myth_wbarrier();
+  thread->join_state=MYTH_JOIN_FINISHED;
+}
+
+//Wait for a finished (exiting) thread to become releasable
+static inline void myth_desc_wait_finished(myth_thread_t thread)
 {
-  thread->join_thread=wait_thread;
+  while (thread->join_state!=MYTH_JOIN_FINISHED) {
+    myth_spin_pause();
+  }
+  myth_rbarrier();
 }
 
 static inline void myth_desc_set_not_runnable(myth_thread_t thread)
@@ -38,12 +79,15 @@ static inline int myth_desc_is_runnable(myth_thread_t thread)
 
 static inline int myth_desc_is_finished(myth_thread_t thread)
 {
-  return thread->status>=MYTH_STATUS_FREE_READY;
+  uintptr_t s=thread->join_state;
+  return s==MYTH_JOIN_EXITING||s==MYTH_JOIN_FINISHED;
 }
 
-static inline void myth_desc_set_detached(myth_thread_t th)
+//Mark thread as detached. Fails (returns 0) if thread has finished
+static inline int myth_desc_set_detached(myth_thread_t th)
 {
-  th->detached=1;
+  return __sync_bool_compare_and_swap(&th->join_state,
+				      MYTH_JOIN_RUNNING,MYTH_JOIN_DETACHED);
 }
 
 #endif /* MYTH_DESC_H_ */
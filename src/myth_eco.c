@@ -54,7 +54,7 @@ myth_thread_t myth_eco_steal(int rank) {
     //int ws_victim;
     //ws_victim=busy_env->rank;
     //Try to steal thread
-    next_run = myth_queue_take(&busy_env->runnable_q);
+    next_run = myth_steal_from(env, busy_env);
     if (next_run){
 #if MYTH_SCHED_LOOP_DEBUG
       myth_dprintf("env %p is stealing thread %p from %p...\n",
@@ -139,7 +139,7 @@ myth_thread_t myth_eco_all_task_check(myth_running_env_t env)
   while(i < g_attr.n_workers){
     if(g_envs[i].c == RUNNING) {
       busy_env = &g_envs[i];
-      next_run = myth_queue_take(&busy_env->runnable_q);
+      next_run = myth_runq_take(busy_env);
       if(next_run){
 	next_run->env = env;
 	return next_run;
@@ -395,7 +395,7 @@ static void myth_eco_sched_loop(myth_running_env_t env) {
     //sched_yield();
     myth_thread_t next_run;
     //Get runnable thread
-    next_run=myth_queue_pop(&env->runnable_q);
+    next_run=myth_runq_pop(env);
 #if MYTH_WRAP_SOCKIO
     //If there is no runnable thread, check I/O
     if (!next_run){
@@ -0,0 +1,48 @@
+/* 
+ * myth_idle.h : what idle workers do (MYTH_IDLE_POLICY)
+ */
+#pragma once
+#ifndef MYTH_IDLE_H_
+#define MYTH_IDLE_H_
+
+#include "myth_config.h"
+
+typedef enum {
+  //Keep trying to steal (default)
+  myth_idle_policy_spin = 0,
+  //Try to steal MYTH_IDLE_SPIN_COUNT times, then sched_yield between tries
+  myth_idle_policy_yield = 1,
+  //As yield, then sleep on a futex until a thread becomes runnable
+  myth_idle_policy_park = 2,
+} myth_idle_policy_t;
+
+typedef struct {
+  //Number of workers parked or about to park
+  volatile int n_parked;
+  //1 while a wakeup has been issued and the worker it picked has
+  //not returned yet, so that pushes do not issue another one
+  volatile int waking;
+} __attribute__((aligned(CACHE_LINE_SIZE))) myth_idle_t;
+
+extern int g_myth_idle_policy;
+extern myth_idle_t g_myth_idle;
+
+struct myth_running_env;
+int myth_idle_park(struct myth_running_env * env);
+void myth_idle_wake(struct myth_running_env * env);
+void myth_idle_wake_one(void);
+void myth_idle_wake_all(void);
+
+//A thread has become runnable; wake a parked worker if any.
+//The fence orders the push before the load of n_parked, as
+//myth_idle_park orders its announce before its recheck; otherwise
+//both could miss each other. Other policies never park
+static inline void myth_idle_notify(void) {
+  if (g_myth_idle_policy != myth_idle_policy_park) return;
+  __sync_synchronize();
+  if (g_myth_idle.n_parked && !g_myth_idle.waking) {
+    myth_idle_wake_one();
+  }
+}
+
+#endif	/* MYTH_IDLE_H_ */
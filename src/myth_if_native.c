@@ -105,6 +105,10 @@ int myth_create_ex(myth_thread_t * id, myth_thread_attr_t * attr,
   return myth_create_ex_body(id, attr, func, arg);
 }
 
+myth_thread_t myth_create_on(int worker, myth_func_t func, void *arg) {
+  return myth_create_on_body(worker, func, arg);
+}
+
 void myth_exit(void *ret) {
   myth_exit_body(ret);
 }
@@ -224,6 +228,30 @@ int myth_thread_attr_setstack(myth_thread_attr_t *attr,
   return myth_thread_attr_setstack_body(attr, stackaddr, stacksize);
 }
 
+int myth_thread_attr_getpriority(const myth_thread_attr_t *attr, int *priority) {
+  return myth_thread_attr_getpriority_body(attr, priority);
+}
+
+int myth_thread_attr_setpriority(myth_thread_attr_t *attr, int priority) {
+  return myth_thread_attr_setpriority_body(attr, priority);
+}
+
+int myth_thread_attr_getworker(const myth_thread_attr_t *attr, int *worker) {
+  return myth_thread_attr_getworker_body(attr, worker);
+}
+
+int myth_thread_attr_setworker(myth_thread_attr_t *attr, int worker) {
+  return myth_thread_attr_setworker_body(attr, worker);
+}
+
+int myth_thread_attr_getnumanode(const myth_thread_attr_t *attr, int *numa_node) {
+  return myth_thread_attr_getnumanode_body(attr, numa_node);
+}
+
+int myth_thread_attr_setnumanode(myth_thread_attr_t *attr, int numa_node) {
+  return myth_thread_attr_setnumanode_body(attr, numa_node);
+}
+
 int myth_getconcurrency(void) {
   return myth_getconcurrency_body();
 }
@@ -373,6 +401,16 @@ int myth_rwlockattr_setkind(myth_rwlockattr_t *attr,
   return myth_rwlockattr_setkind_body(attr, pref);
 }
 
+int myth_rwlockattr_getreadmostly(const myth_rwlockattr_t *attr,
+				  int *read_mostly) {
+  return myth_rwlockattr_getreadmostly_body(attr, read_mostly);
+}
+
+int myth_rwlockattr_setreadmostly(myth_rwlockattr_t *attr,
+				  int read_mostly) {
+  return myth_rwlockattr_setreadmostly_body(attr, read_mostly);
+}
+
 /* ------------------------------
    --- condition variables 
    ------------------------------ */
@@ -547,6 +585,48 @@ int myth_uncond_signal(myth_uncond_t * u) {
   return myth_uncond_signal_body(u);
 }
 
+/* ------------------------------
+   --- futures
+   ------------------------------ */
+
+int myth_future_init(myth_future_t * f, size_t size) {
+  return myth_future_init_body(f, size);
+}
+
+int myth_future_destroy(myth_future_t * f) {
+  return myth_future_destroy_body(f);
+}
+
+int myth_future_set(myth_future_t * f, const void * value) {
+  return myth_future_set_body(f, value);
+}
+
+int myth_future_claim(myth_future_t * f) {
+  return myth_future_claim_body(f);
+}
+
+int myth_future_publish(myth_future_t * f) {
+  return myth_future_publish_body(f);
+}
+
+int myth_future_get(myth_future_t * f, void * value) {
+  return myth_future_get_body(f, value);
+}
+
+int myth_future_ready(myth_future_t * f) {
+  return myth_future_ready_body(f);
+}
+
+void * myth_future_value(myth_future_t * f) {
+  return myth_future_value_body(f);
+}
+
+int myth_future_then(myth_future_t * f, myth_future_cont_t * cont,
+		     void (*fn)(myth_future_t * f, void * arg),
+		     void * arg) {
+  return myth_future_then_body(f, cont, fn, arg);
+}
+
 /* --------------------------------
    --- thread local storage 
    -------------------------------- */
@@ -599,6 +679,22 @@ int myth_get_num_workers(void) {
   return myth_get_num_workers_body();
 }
 
+int myth_get_num_active_workers(void) {
+  return myth_get_num_active_workers_body();
+}
+
+int myth_set_num_active_workers(int n) {
+  return myth_set_num_active_workers_body(n);
+}
+
+int myth_runqueue_is_empty(void) {
+  return myth_runqueue_is_empty_body();
+}
+
+int myth_get_stats(myth_stats_t * s) {
+  return myth_get_stats_body(s);
+}
+
 /* --------------------------------
    --- thread-related functions 
    -------------------------------- */
@@ -696,6 +792,13 @@ void myth_wsapi_randarr(int *ret,int n) {
   }
 }
 
+#if MYTH_WSQUEUE_CAS_STEAL
+myth_thread_t myth_wsapi_runqueue_take(int victim,
+				       myth_wsapi_decidefn_t decidefn,
+				       void *udata) {
+  return myth_queue_take_if(&g_envs[victim].runnable_q,decidefn,udata);
+}
+#else
 myth_thread_t myth_wsapi_runqueue_take(int victim,
 				       myth_wsapi_decidefn_t decidefn,
 				       void *udata) {
@@ -721,13 +824,13 @@ myth_thread_t myth_wsapi_runqueue_take(int victim,
 #else
   myth_wsqueue_lock_lock(&q->lock);
 #endif
-  //Increment base
+  //Increment base (read the slot first; see myth_queue_take)
   b=q->base;
+  ret=*myth_queue_slot(q,b);
   q->base=b+1;
   myth_wsqueue_rwbarrier();
   top=q->top;
   if (b<top){
-    ret=q->ptr[b];
     if ((!decidefn) || decidefn(ret,udata)){
       //q->ptr[b]=NULL;
       //invalidate cache
@@ -757,8 +860,10 @@ myth_thread_t myth_wsapi_runqueue_take(int victim,
 #endif
   return NULL;
 }
+#endif
 
-#if 1
+//the peek cache below fills itself by the locked take protocol
+#if !MYTH_WSQUEUE_CAS_STEAL
 myth_thread_t myth_wsapi_runqueue_peek(int victim,void *ptr,size_t *psize) {
   myth_thread_queue_t q;
   myth_wscache_t wc;
@@ -783,15 +888,15 @@ myth_thread_t myth_wsapi_runqueue_peek(int victim,void *ptr,size_t *psize) {
     //check status again
     if (!wc->ptr){
       //Increment base
+      myth_thread_t th;
       b=q->base;
+      th=*myth_queue_slot(q,b);
       q->base=b+1;
       myth_wsqueue_rwbarrier();
       top=q->top;
       if (b<top){
 	//fprintf(stderr,"%d cache update\n",victim);
 	int s;
-	myth_thread_t th;
-	th=q->ptr[b];
 	size_t thcs=myth_wsapi_get_hint_size(th);
 	void* thcd=myth_wsapi_get_hint_ptr(th);
 	//Copy data
@@ -867,12 +972,12 @@ myth_thread_t myth_wsapi_runqueue_peek(int victim,void *ptr,size_t *psize) {
   myth_thread_t ret;
   ret=myth_queue_peek(&g_envs[victim].runnable_q);
   if (ret){
-    size_t csize=myth_custom_data_size(ret);
+    size_t csize=myth_wsapi_get_hint_size(ret);
     if (psize && ptr && (*psize)>0){
       csize=((*psize)<csize)?(*psize):csize;
       *psize=csize;
       if (csize>0){
-	memcpy(ptr,myth_custom_data_ptr(ret),csize);
+	memcpy(ptr,myth_wsapi_get_hint_ptr(ret),csize);
       }
     }
   }
@@ -898,27 +1003,39 @@ myth_thread_t myth_wsapi_runqueue_pop(void) {
   return myth_queue_pop(&env->runnable_q);
 }
 
-/* --------------------------------
-   --- disabled functions
-   -------------------------------- */
-
-#if 0
-
 /* --------------------------------
    --- serialize functions
    -------------------------------- */
 
+size_t myth_pickle_size(myth_thread_t th) {
+  return myth_pickle_size_body(th);
+}
+
 void myth_serialize(myth_thread_t th, myth_pickle_t * p) {
   myth_serialize_body(th,p);
 }
 
+int myth_pickle_valid(myth_pickle_t * p, size_t size) {
+  return myth_pickle_valid_body(p,size);
+}
+
 //Deserialize
 myth_thread_t myth_deserialize(myth_pickle_t * p) {
-  return myth_deserialize_body(p);
+  return myth_deserialize_body(p,NULL,0);
 }
 
 myth_thread_t myth_ext_deserialize(myth_pickle_t * p) {
-  return myth_ext_deserialize_body(p);
+  return myth_ext_deserialize_body(p,NULL,0);
+}
+
+myth_thread_t myth_deserialize_into(myth_pickle_t * p,
+				    void * addr, size_t size) {
+  return myth_deserialize_body(p,addr,size);
+}
+
+myth_thread_t myth_ext_deserialize_into(myth_pickle_t * p,
+					void * addr, size_t size) {
+  return myth_ext_deserialize_body(p,addr,size);
 }
 
 myth_thread_t myth_steal(void) {
@@ -940,7 +1057,6 @@ void myth_release_stack(myth_thread_t th) {
 void myth_release_desc(myth_thread_t th) {
   myth_release_desc_body(th);
 }
-#endif
 
 
 /* --------------------------------
@@ -16,6 +16,22 @@
 
 myth_globalattr_t g_attr;
 
+#if MYTH_SPLIT_STACK_DESC
+static void myth_print_stack_cache_stats(void) {
+  int i;
+  for (i = 0; i < g_attr.n_workers; i++) {
+    myth_stack_cache_print_stats(&g_envs[i]);
+  }
+}
+
+//Programs often exit without myth_fini
+static void myth_print_stack_cache_stats_atexit(void) {
+  if (g_myth_init_state == myth_init_state_initialized) {
+    myth_print_stack_cache_stats();
+  }
+}
+#endif
+
 static int myth_init_ex_body_really(const myth_globalattr_t * attr) {
   int nw;
   myth_get_available_cpus();
@@ -25,8 +41,22 @@ static int myth_init_ex_body_really(const myth_globalattr_t * attr) {
     if (!g_attr.initialized) myth_globalattr_init_body(&g_attr);
   }
   nw = g_attr.n_workers;
-  //Initialize logger
-  myth_log_init();
+  g_myth_steal_many = myth_default_steal_many();
+  myth_default_steal_hier(g_myth_steal_hier_retries, MYTH_STEAL_HIER_LEVELS);
+  g_myth_idle_policy = myth_default_idle_policy();
+  g_myth_stack_cache_high = myth_default_stack_cache_high();
+  g_myth_stack_cache_max = myth_default_stack_cache_max();
+  g_myth_stack_cache_stats = myth_default_stack_cache_stats();
+  g_myth_stack_arena_size = myth_default_stack_arena_size();
+  g_myth_stack_arena_hugepage = myth_default_stack_arena_hugepage();
+  g_myth_stack_arena_guard = myth_default_stack_arena_guard();
+#if MYTH_SPLIT_STACK_DESC
+  if (g_myth_stack_cache_stats) {
+    static int registered = 0;
+    if (!registered) atexit(myth_print_stack_cache_stats_atexit);
+    registered = 1;
+  }
+#endif
   //Initialize memory allocators
   myth_flmalloc_init(nw);
   //myth_malloc_wrapper_init(nthreads);
@@ -41,6 +71,8 @@ static int myth_init_ex_body_really(const myth_globalattr_t * attr) {
   //Allocate worker thread descriptors
   g_envs = myth_malloc(sizeof(myth_running_env) * nw);
   g_envs_sz = nw;
+  //Initialize logger
+  myth_log_init();
   // create pthread_key to indicate massivethread workers are massivethread workers
   myth_worker_key_init();
   //Initialize TLS for worker thread descriptor
@@ -51,6 +83,9 @@ static int myth_init_ex_body_really(const myth_globalattr_t * attr) {
 #if EXPERIMENTAL_SCHEDULER
   myth_scheduler_global_init(nw);
 #endif
+  //Victim selection following the cpu topology
+  myth_steal_hier_init(nw);
+  g_myth_n_active_workers = nw;
 
   //Create worker threads
   intptr_t i;
@@ -367,6 +402,10 @@ static void myth_fini_body_really(void) {
 #endif
   //Finalize logger
   myth_log_fini();
+  myth_steal_hier_fini();
+#if MYTH_SPLIT_STACK_DESC
+  if (g_myth_stack_cache_stats) myth_print_stack_cache_stats();
+#endif
   //Release worker thread descriptors
   myth_free_with_size(g_envs, sizeof(myth_running_env)*g_attr.n_workers);
   //Release allocator
@@ -381,14 +420,10 @@ int myth_fini_body() {
     return 1;			/* OK */
   }
   myth_init_once_ctl_wait(&g_myth_init_state, myth_init_state_initialized);
-  //add context switch as a sentinel for emitting logs
-  int i;
-  for (i = 0; i < g_attr.n_workers; i++){
-    myth_log_add_context_switch(&g_envs[i], THREAD_PTR_SCHED_TERM);
-  }
   myth_startpoint_exit_ex_body(0);
   myth_running_env_t env = myth_get_current_env();
   int rank = env->rank;
+  int i;
   assert(rank == 0);
   //Wait for other worker threads
   for (i = 1; i < g_attr.n_workers; i++) {
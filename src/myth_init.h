@@ -19,6 +19,15 @@
 #define ENV_MYTH_DEF_GUARDSIZE "MYTH_DEF_GUARDSIZE"
 #define ENV_MYTH_BIND_WORKERS  "MYTH_BIND_WORKERS"
 #define ENV_MYTH_CHILD_FIRST   "MYTH_CHILD_FIRST"
+#define ENV_MYTH_STEAL_MANY    "MYTH_STEAL_MANY"
+#define ENV_MYTH_STEAL_HIER    "MYTH_STEAL_HIER"
+#define ENV_MYTH_IDLE_POLICY   "MYTH_IDLE_POLICY"
+#define ENV_MYTH_STACK_CACHE_HIGH  "MYTH_STACK_CACHE_HIGH"
+#define ENV_MYTH_STACK_CACHE_MAX   "MYTH_STACK_CACHE_MAX"
+#define ENV_MYTH_STACK_CACHE_STATS "MYTH_STACK_CACHE_STATS"
+#define ENV_MYTH_STACK_ARENA_SIZE     "MYTH_STACK_ARENA_SIZE"
+#define ENV_MYTH_STACK_ARENA_HUGEPAGE "MYTH_STACK_ARENA_HUGEPAGE"
+#define ENV_MYTH_STACK_ARENA_GUARD    "MYTH_STACK_ARENA_GUARD"
 
 enum {
   myth_init_state_uninit,
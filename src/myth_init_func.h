@@ -9,6 +9,8 @@
 #include "myth_init.h"
 #include "myth_misc.h"
 #include "myth_bind_worker.h"
+#include "myth_wsqueue.h"
+#include "myth_idle.h"
 
 #include "myth_misc_func.h"
 
@@ -92,6 +94,142 @@ static inline size_t myth_globalattr_default_child_first(void) {
   return cf;
 }
 
+static inline int myth_default_steal_many(void) {
+  /* max number of threads a thief takes at once.
+     1 steals one thread at a time */
+  int n = 1;
+  char * env = getenv(ENV_MYTH_STEAL_MANY);
+  if (env){
+    n = atoi(env);
+  }
+  if (n < 1) n = 1;
+  if (n > MYTH_QUEUE_TAKE_MANY_MAX) n = MYTH_QUEUE_TAKE_MANY_MAX;
+  return n;
+}
+
+static inline void myth_default_steal_hier(int * retries, int n_levels) {
+  /* number of victims tried at each topology level per steal,
+     nearest level first, e.g., MYTH_STEAL_HIER=1,2,1.
+     missing levels are 1, and the farthest level gets at least
+     one so that work still flows across sockets.
+     MYTH_STEAL_HIER=0 (all given levels zero) disables it */
+  const char * s = "1,2,1";
+  char * env = getenv(ENV_MYTH_STEAL_HIER);
+  int i, any = 0;
+  if (env){
+    s = env;
+  }
+  for (i = 0; i < n_levels; i++) {
+    char * end;
+    long x = strtol(s, &end, 10);
+    if (end == s) {
+      retries[i] = 1;
+    } else {
+      retries[i] = (x > 0 ? x : 0);
+      any |= retries[i];
+    }
+    s = end;
+    if (*s == ',') s++;
+  }
+  if (!any) {
+    for (i = 0; i < n_levels; i++) retries[i] = 0;
+  } else if (retries[n_levels - 1] == 0) {
+    retries[n_levels - 1] = 1;
+  }
+}
+
+static inline int myth_default_idle_policy(void) {
+  /* what a worker does when it finds no thread to run:
+     spin (default), yield or park (see myth_idle.h) */
+  int p = myth_idle_policy_spin;
+  char * env = getenv(ENV_MYTH_IDLE_POLICY);
+  if (env){
+    if (strcmp(env, "yield") == 0) {
+      p = myth_idle_policy_yield;
+    } else if (strcmp(env, "park") == 0) {
+      p = myth_idle_policy_park;
+    } else if (strcmp(env, "spin") != 0) {
+      p = atoi(env);
+      if (p < myth_idle_policy_spin || p > myth_idle_policy_park) {
+	p = myth_idle_policy_spin;
+      }
+    }
+  }
+  return p;
+}
+
+static inline long myth_default_stack_cache_high(void) {
+  /* number of freed stacks (and descriptors) a worker keeps ready
+     for reuse. those freed beyond it release their pages */
+  long n = MYTH_STACK_CACHE_HIGH;
+  char * env = getenv(ENV_MYTH_STACK_CACHE_HIGH);
+  if (env){
+    n = atol(env);
+  }
+  if (n < 0) n = 0;
+  return n;
+}
+
+static inline long myth_default_stack_cache_max(void) {
+  /* number of released stacks a worker keeps. those freed
+     beyond it are unmapped */
+  long n = MYTH_STACK_CACHE_MAX;
+  char * env = getenv(ENV_MYTH_STACK_CACHE_MAX);
+  if (env){
+    n = atol(env);
+  }
+  if (n < 0) n = 0;
+  return n;
+}
+
+static inline int myth_default_stack_cache_stats(void) {
+  /* if 1, each worker prints the sizes of its stack cache at exit */
+  int x = 0;
+  char * env = getenv(ENV_MYTH_STACK_CACHE_STATS);
+  if (env){
+    x = atoi(env);
+  }
+  return x;
+}
+
+static inline size_t myth_default_stack_arena_size(void) {
+  /* size of the arenas default stacks are carved out of.
+     0 maps each stack separately */
+  long sz = MYTH_STACK_ARENA_SIZE;
+  char * env = getenv(ENV_MYTH_STACK_ARENA_SIZE);
+  if (env){
+    sz = atol(env);
+  }
+  if (sz <= 0) return 0;
+  return (((size_t)sz + MYTH_STACK_ARENA_ALIGN - 1)
+	  / MYTH_STACK_ARENA_ALIGN) * MYTH_STACK_ARENA_ALIGN;
+}
+
+static inline int myth_default_stack_arena_hugepage(void) {
+  /* if 1, back arenas by transparent huge pages */
+  int x = 0;
+  char * env = getenv(ENV_MYTH_STACK_ARENA_HUGEPAGE);
+  if (env){
+    x = atoi(env);
+  }
+  return x;
+}
+
+static inline size_t myth_default_stack_arena_guard(void) {
+  /* if 1, put a guard of the default guard size (at least
+     a page) below each stack of an arena */
+  int x = 0;
+  char * env = getenv(ENV_MYTH_STACK_ARENA_GUARD);
+  size_t sz;
+  if (env){
+    x = atoi(env);
+  }
+  if (!x) return 0;
+  sz = g_attr.guardsize;
+  if (sz == 0) sz = PAGE_SIZE;
+  return ((sz + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+}
+
 static inline int myth_globalattr_init_body(myth_globalattr_t * attr) {
   myth_globalattr_t a;
   a.initialized = 1;
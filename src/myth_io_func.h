@@ -441,7 +441,8 @@ static inline void myth_wait_for_read(int fd,myth_running_env_t env,myth_io_op_t
   //Switch to next thread
   myth_thread_t this_thread,next;
   this_thread=op->th;
-  next=myth_queue_pop(&env->runnable_q);
+  myth_log_add_wait(env,MYTH_LOG_IO_WAIT,this_thread,(uint64_t)fd);
+  next=myth_runq_pop(env);
   if (next){
     assert(next->status==MYTH_STATUS_READY);//sanity check
     //Switch context
@@ -496,7 +497,8 @@ static inline void myth_wait_for_write(int fd,myth_running_env_t env,myth_io_op_
   //Switch to next thread
   myth_thread_t this_thread,next;
   this_thread=op->th;
-  next=myth_queue_pop(&env->runnable_q);
+  myth_log_add_wait(env,MYTH_LOG_IO_WAIT,this_thread,(uint64_t)fd);
+  next=myth_runq_pop(env);
   if (next){
     assert(next->status==MYTH_STATUS_READY);//sanity check
     //Switch context
@@ -1133,7 +1135,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
       th->env=env;
       //Push the thread into the runqueue
       if (!first_runnable){first_runnable=th;}
-      else{myth_queue_push(&env->runnable_q,th);}
+      else{myth_runq_push(env, th);}
     }
     else{
       //Blocked. Return to I/O operation list again
@@ -1151,7 +1153,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
       th->env=env;
       //Push the thread into the runqueue
       if (!first_runnable){first_runnable=th;}
-      else{myth_queue_push(&env->runnable_q,th);}
+      else{myth_runq_push(env, th);}
     }
     else{
       //Blocked. Return to I/O operation list again
@@ -1176,7 +1178,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
       assert(b);
       th->env=env;
       if (!first_runnable){first_runnable=th;}
-      else{myth_queue_push(&env->runnable_q,th);}
+      else{myth_runq_push(env, th);}
     }
     myth_io_wait_list_destroy(&fd_data->rd_list);
     while ((op=myth_io_wait_list_pop(env,&fd_data->wr_list))!=NULL){
@@ -1187,7 +1189,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
       assert(b);
       th->env=env;
       if (!first_runnable){first_runnable=th;}
-      else{myth_queue_push(&env->runnable_q,th);}
+      else{myth_runq_push(env, th);}
     }
     myth_io_wait_list_destroy(&fd_data->wr_list);
     fd_data->closed=1;
@@ -1229,7 +1231,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
 	myth_assert(b);
 	th->env=env;
 	if (!first_runnable){first_runnable=th;}
-	else{myth_queue_push(&env->runnable_q,th);}
+	else{myth_runq_push(env, th);}
       }
       while ((op=myth_io_wait_list_pop(env,&fd_data->wr_list))!=NULL){
 	th=op->th;
@@ -1239,7 +1241,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
 	myth_assert(b);
 	th->env=env;
 	if (!first_runnable){first_runnable=th;}
-	else{myth_queue_push(&env->runnable_q,th);}
+	else{myth_runq_push(env, th);}
       }
     }
     else{
@@ -1252,7 +1254,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
 	  if (myth_io_execute(op)){
 	    th->env=env;
 	    if (!first_runnable){first_runnable=th;}
-	    else{myth_queue_push(&env->runnable_q,th);}
+	    else{myth_runq_push(env, th);}
 	  }
 	  else{
 	    myth_io_wait_list_push(env,&fd_data->rd_list,op);
@@ -1269,7 +1271,7 @@ static inline myth_thread_t myth_io_polling(struct myth_running_env *env) {
 	  if (myth_io_execute(op)){
 	    th->env=env;
 	    if (!first_runnable){first_runnable=th;}
-	    else{myth_queue_push(&env->runnable_q,th);}
+	    else{myth_runq_push(env, th);}
 	  }
 	  else{
 	    myth_io_wait_list_push(env,&fd_data->wr_list,op);
@@ -1354,7 +1356,7 @@ static inline myth_thread_t myth_io_polling_sig(struct myth_running_env *env) {
 	myth_assert(b);
 	th->env=env;
 	if (!first_runnable){first_runnable=th;}
-	else{myth_queue_push(&env->runnable_q,th);}
+	else{myth_runq_push(env, th);}
       }
       while ((op=myth_io_wait_list_pop(env,&fd_data->wr_list))!=NULL){
 	th=op->th;
@@ -1364,7 +1366,7 @@ static inline myth_thread_t myth_io_polling_sig(struct myth_running_env *env) {
 	myth_assert(b);
 	th->env=env;
 	if (!first_runnable){first_runnable=th;}
-	else{myth_queue_push(&env->runnable_q,th);}
+	else{myth_runq_push(env, th);}
       }
     }
     else{
@@ -1376,7 +1378,7 @@ static inline myth_thread_t myth_io_polling_sig(struct myth_running_env *env) {
 	  if (myth_io_execute(op)){
 	    th->env=env;
 	    if (!first_runnable){first_runnable=th;}
-	    else{myth_queue_push(&env->runnable_q,th);}
+	    else{myth_runq_push(env, th);}
 	  }
 	  else{
 	    myth_io_wait_list_push(env,&fd_data->rd_list,op);
@@ -1392,7 +1394,7 @@ static inline myth_thread_t myth_io_polling_sig(struct myth_running_env *env) {
 	  if (myth_io_execute(op)){
 	    th->env=env;
 	    if (!first_runnable){first_runnable=th;}
-	    else{myth_queue_push(&env->runnable_q,th);}
+	    else{myth_runq_push(env, th);}
 	  }
 	  else{
 	    myth_io_wait_list_push(env,&fd_data->wr_list,op);
@@ -1455,7 +1457,7 @@ static void myth_io_sighandler(int signum,siginfo_t *sinfo,void* ctx) {
 	myth_assert(op->type==MYTH_IO_ACCEPT || op->type==MYTH_IO_RECV);
 	if (myth_io_execute(op)){
 	  th->env=env;
-	  {myth_queue_push(&env->runnable_q,th);}
+	  {myth_runq_push(env, th);}
 	}
 	else{
 	  myth_io_wait_list_push(env,fd_data->rd_reserve_list_ptr,op);
@@ -1469,7 +1471,7 @@ static void myth_io_sighandler(int signum,siginfo_t *sinfo,void* ctx) {
 	myth_assert(op->type==MYTH_IO_CONNECT || op->type==MYTH_IO_SEND);
 	if (myth_io_execute(op)){
 	  th->env=env;
-	  {myth_queue_push(&env->runnable_q,th);}
+	  {myth_runq_push(env, th);}
 	}
 	else{
 	  myth_io_wait_list_push(env,fd_data->wr_reserve_list_ptr,op);
@@ -1516,7 +1518,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
       th=op->th;
       th->env=env;
       if (!first_runnable){first_runnable=th;}
-      else{myth_queue_push(&env->runnable_q,th);}
+      else{myth_runq_push(env, th);}
     }
     else{
       myth_io_wait_list_push(env,op->wl_ptr,op);
@@ -1529,7 +1531,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
       th=op->th;
       th->env=env;
       if (!first_runnable){first_runnable=th;}
-      else{myth_queue_push(&env->runnable_q,th);}
+      else{myth_runq_push(env, th);}
     }
     else{
       myth_io_wait_list_push(env,op->wl_ptr,op);
@@ -1569,7 +1571,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
 	myth_assert(b);
 	th->env=env;
 	if (!first_runnable){first_runnable=th;}
-	else{myth_queue_push(&env->runnable_q,th);}
+	else{myth_runq_push(env, th);}
       }
       while ((op=myth_io_wait_list_pop(env,&fd_data->wr_list))!=NULL){
 	th=op->th;
@@ -1579,7 +1581,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
 	myth_assert(b);
 	th->env=env;
 	if (!first_runnable){first_runnable=th;}
-	else{myth_queue_push(&env->runnable_q,th);}
+	else{myth_runq_push(env, th);}
       }
     }
     else{
@@ -1591,7 +1593,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
 	  if (myth_io_execute(op)){
 	    th->env=env;
 	    if (!first_runnable){first_runnable=th;}
-	    else{myth_queue_push(&env->runnable_q,th);}
+	    else{myth_runq_push(env, th);}
 	  }
 	  else{
 	    myth_io_wait_list_push(env,&fd_data->rd_list,op);
@@ -1607,7 +1609,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
 	  if (myth_io_execute(op)){
 	    th->env=env;
 	    if (!first_runnable){first_runnable=th;}
-	    else{myth_queue_push(&env->runnable_q,th);}
+	    else{myth_runq_push(env, th);}
 	  }
 	  else{
 	    myth_io_wait_list_push(env,&fd_data->wr_list,op);
@@ -1634,7 +1636,7 @@ static inline myth_thread_t myth_io_polling_thread(struct myth_running_env *env)
     }
   }
 #endif
-  myth_queue_push(&env->runnable_q,first_runnable);
+  myth_runq_push(env, first_runnable);
   myth_io_cs_exit(env);
   return NULL;
 }
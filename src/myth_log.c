@@ -1,40 +1,135 @@
-/* 
+/*
  * myth_log.c
  */
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "myth_config.h"
 #include "myth_log_func.h"
+#include "myth_real.h"
 
-/*
-  int myth_textlog_entry_compare(const void *pa,const void *pb)
-  {
-  myth_textlog_entry_t a,b;
-  a=(myth_textlog_entry_t)pa;b=(myth_textlog_entry_t)pb;
-  if (a->te > b->te)return 1;
-  if (a->te < b->te)return -1;
-  if (a->ts > b->ts)return 1;
-  if (a->ts < b->ts)return -1;
-  return 0;
+uint64_t g_tsc_base=0;
+
+#if MYTH_COLLECT_LOG
+
+//Serializes the writers of the rings (the background thread,
+//myth_log_flush and myth_log_reset)
+static myth_spinlock_t g_log_write_lock;
+static pthread_t g_log_writer;
+static volatile int g_log_writer_exit;
+
+static void myth_log_write_fd(int fd,const void *buf,size_t size) {
+  const char *p=buf;
+  while (size>0){
+    ssize_t n=real_write(fd,p,size);
+    if (n<0){
+      if (errno==EINTR)continue;
+      perror("myth_log: write");
+      return;
+    }
+    p+=n;
+    size-=n;
   }
-*/
-
-int myth_log_entry_compare(const void *pa,const void *pb) {
-  myth_log_entry_t a,b;
-  a=(myth_log_entry_t)pa;b=(myth_log_entry_t)pb;
-  //1st:type
-  if (a->type>b->type)return 1;if (a->type<b->type)return -1;
-  switch (a->type){
-  case MYTH_LOG_THREAD_ANNOTATION:
-    //2nd:timestamp
-    if (a->tsc > b->tsc)return 1;if (a->tsc < b->tsc)return -1;
-    break;
-  case MYTH_LOG_SWITCH:
-    //2nd:worker thread index
-    if (a->rank > b->rank)return 1;if (a->rank < b->rank)return -1;
-    //3rd:timestamp
-    if (a->tsc > b->tsc)return 1;if (a->tsc < b->tsc)return -1;
-    break;
+}
+
+//Write the records in the ring of env to its file
+static void myth_log_write_ring(myth_running_env_t env) {
+  myth_log_ring_t r=&env->log_ring;
+  uint64_t tail=r->tail;
+  uint64_t head=r->head;
+  myth_rbarrier();
+  while (tail<head){
+    uint64_t idx=tail&(MYTH_LOG_RING_SIZE-1);
+    uint64_t n=head-tail;
+    if (n>MYTH_LOG_RING_SIZE-idx)n=MYTH_LOG_RING_SIZE-idx;
+    myth_log_write_fd(r->fd,&r->buf[idx],sizeof(myth_log_entry)*n);
+    tail+=n;
   }
-  return 0;
+  //The worker may reuse the records from now on
+  myth_rwbarrier();
+  r->tail=tail;
 }
 
-uint64_t g_tsc_base=0;
+void myth_log_write_rings(void) {
+  int i;
+  myth_spin_lock_body(&g_log_write_lock);
+  for (i=0;i<g_attr.n_workers;i++){
+    myth_log_write_ring(&g_envs[i]);
+  }
+  myth_spin_unlock_body(&g_log_write_lock);
+}
+
+void myth_log_discard_rings(void) {
+  int i;
+  myth_spin_lock_body(&g_log_write_lock);
+  for (i=0;i<g_attr.n_workers;i++){
+    myth_log_ring_t r=&g_envs[i].log_ring;
+    r->tail=r->head;
+  }
+  myth_spin_unlock_body(&g_log_write_lock);
+}
+
+static void * myth_log_writer_fn(void *arg) {
+  (void)arg;
+  while (!g_log_writer_exit){
+    myth_log_write_rings();
+    real_usleep(MYTH_LOG_WRITE_INTERVAL_US);
+  }
+  return NULL;
+}
+
+//Open the file of each worker and start the background writer
+void myth_log_open_rings(void) {
+  int i;
+  myth_log_file_header h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,MYTH_LOG_FILE_MAGIC,sizeof(MYTH_LOG_FILE_MAGIC));
+  h.version=MYTH_LOG_FILE_VERSION;
+  h.entry_size=sizeof(myth_log_entry);
+  h.n_workers=g_attr.n_workers;
+#if MYTH_ENABLE_THREAD_ANNOTATION
+  h.flags=MYTH_LOG_FILE_ANNOTATION;
+#endif
+  h.tsc_base=g_tsc_base;
+  myth_spin_init_body(&g_log_write_lock);
+  for (i=0;i<g_attr.n_workers;i++){
+    myth_log_ring_t r=&g_envs[i].log_ring;
+    char fname[1000];
+    r->head=0;
+    r->tail=0;
+    r->n_dropped=0;
+    r->buf=myth_malloc(sizeof(myth_log_entry)*MYTH_LOG_RING_SIZE);
+    sprintf(fname,"myth-log-%d-%d.bin",getpid(),i);
+    r->fd=open(fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if (r->fd<0){
+      perror(fname);
+      exit(1);
+    }
+    h.rank=i;
+    myth_log_write_fd(r->fd,&h,sizeof(h));
+  }
+  g_log_writer_exit=0;
+  real_pthread_create(&g_log_writer,NULL,myth_log_writer_fn,NULL);
+}
+
+//Stop the background writer and write the rest. All workers
+//have finished
+void myth_log_close_rings(void) {
+  int i;
+  g_log_writer_exit=1;
+  real_pthread_join(g_log_writer,NULL);
+  myth_log_write_rings();
+  for (i=0;i<g_attr.n_workers;i++){
+    myth_log_ring_t r=&g_envs[i].log_ring;
+    if (r->n_dropped){
+      fprintf(stderr,"myth_log: worker %d dropped %llu records (ring full)\n",
+	      i,(unsigned long long)r->n_dropped);
+    }
+    real_close(r->fd);
+    myth_free_with_size(r->buf,sizeof(myth_log_entry)*MYTH_LOG_RING_SIZE);
+  }
+  myth_spin_destroy(&g_log_write_lock);
+}
+
+#endif
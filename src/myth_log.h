@@ -1,4 +1,4 @@
-/* 
+/*
  * myth_log.h
  */
 #pragma once
@@ -7,33 +7,24 @@
 
 #include <stdint.h>
 #include "myth_config.h"
+#include "myth_log_format.h"
 
 //Special pointer describing status
 #define THREAD_PTR_SCHED NULL //scheduler running
 #define TRREAD_PTR_SCHED_SLEEP ((myth_thread_t)0xFFFFFFFF) //scheduler sleeping
 #define THREAD_PTR_SCHED_TERM ((myth_thread_t)0xFFFFFFFE) //scheduler entering termination
 
-typedef enum {
-  MYTH_LOG_THREAD_ANNOTATION = 0,//thread annotation
-  MYTH_LOG_SWITCH,//context switch
-}myth_log_type_t;
-
-typedef struct myth_log_entry {
-  uint64_t tsc;			//Time stamp counter from rdtsc
-  myth_log_type_t type;
-  int rank;
-  union{
-    struct{
-      struct myth_thread *th;
-      int recycle_count;
-    }ctx_switch;
-    struct{
-      struct myth_thread *th;
-      int recycle_count;
-      char str[MYTH_THREAD_ANNOTATION_MAXLEN];
-    }annotation;
-  }u;
-}myth_log_entry,*myth_log_entry_t;
+//Records of a worker on their way to its file. The worker appends
+//at head and a background thread writes them out from tail
+typedef struct myth_log_ring {
+  //Written by the worker
+  volatile uint64_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+  uint64_t n_dropped;		//records lost because the ring was full
+  //Written by the writer
+  volatile uint64_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+  myth_log_entry * buf;		//MYTH_LOG_RING_SIZE records
+  int fd;
+}myth_log_ring,*myth_log_ring_t;
 
 extern uint64_t g_tsc_base;
 
@@ -43,7 +34,9 @@ static inline void myth_log_init(void);
 static inline void myth_log_worker_init(struct myth_running_env * env);
 static inline void myth_log_worker_fini(struct myth_running_env * env);
 static inline void myth_log_add_context_switch(struct myth_running_env * env, struct myth_thread * th);
-static inline void myth_log_add_context_switch(struct myth_running_env * env, struct myth_thread * th);
+static inline void myth_log_add_create(struct myth_running_env * env, struct myth_thread * th);
+static inline void myth_log_add_steal(struct myth_running_env * env, struct myth_thread * th, int victim);
+static inline void myth_log_add_wait(struct myth_running_env * env, myth_log_type_t type, struct myth_thread * th, uint64_t obj);
 
 
 #endif /* MYTH_LOG_H_ */
@@ -0,0 +1,74 @@
+/*
+ * myth_log_format.h : records of the log and the files workers write
+ * them to (MYTH_COLLECT_LOG). myth-log-merge includes this alone
+ */
+#pragma once
+#ifndef MYTH_LOG_FORMAT_H_
+#define MYTH_LOG_FORMAT_H_
+
+#include <stdint.h>
+
+typedef enum {
+  MYTH_LOG_THREAD_ANNOTATION = 0,//thread annotation
+  MYTH_LOG_SWITCH,//context switch
+  MYTH_LOG_TEXT,//text of the annotation before it
+  MYTH_LOG_CREATE,//thread creation
+  MYTH_LOG_STEAL,//a thread stolen from another worker
+  MYTH_LOG_BLOCK,//the current thread blocks on an object
+  MYTH_LOG_IO_WAIT,//the current thread waits for a file descriptor
+}myth_log_type_t;
+
+#define MYTH_LOG_TEXT_SIZE 16
+
+//A record of the log. Records have the same size and layout
+//in memory and in files
+typedef struct myth_log_entry {
+  uint64_t tsc;			//Time stamp counter from rdtsc
+  uint32_t type;		//myth_log_type_t
+  int32_t rank;
+  union{
+    //MYTH_LOG_SWITCH (the thread switched to),
+    //MYTH_LOG_THREAD_ANNOTATION (the thread annotated) and
+    //MYTH_LOG_CREATE (the thread created)
+    struct{
+      uint64_t th;
+      uint32_t recycle_count;
+      uint32_t len;		//length of the annotation
+    }thread;
+    //MYTH_LOG_STEAL
+    struct{
+      uint64_t th;
+      int32_t victim;		//rank of the worker stolen from
+      uint32_t reserved;
+    }steal;
+    //MYTH_LOG_BLOCK (obj is the address of the queue, thread
+    //joined etc.) and MYTH_LOG_IO_WAIT (obj is the fd)
+    struct{
+      uint64_t th;
+      uint64_t obj;
+    }wait;
+    //MYTH_LOG_TEXT. (len + 1) bytes of an annotation are split
+    //into records of this type following it
+    char text[MYTH_LOG_TEXT_SIZE];
+  }u;
+}myth_log_entry,*myth_log_entry_t;
+
+//Each worker streams its records to myth-log-<pid>-<rank>.bin,
+//which begins with this header. myth-log-merge merges them
+#define MYTH_LOG_FILE_MAGIC "MYTHLOG"
+#define MYTH_LOG_FILE_VERSION 2
+//Threads were annotated (MYTH_ENABLE_THREAD_ANNOTATION)
+#define MYTH_LOG_FILE_ANNOTATION 1
+
+typedef struct myth_log_file_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_size;		//sizeof(myth_log_entry)
+  int32_t rank;
+  int32_t n_workers;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t tsc_base;
+}myth_log_file_header;
+
+#endif /* MYTH_LOG_FORMAT_H_ */
@@ -0,0 +1,383 @@
+/*
+ * myth_log_merge.c : merge myth-log-<pid>-<rank>.bin files written by
+ * workers (MYTH_COLLECT_LOG) into a text log of thread intervals.
+ *
+ * usage: myth-log-merge [-c] [-o output] myth-log-<pid>-*.bin
+ *
+ * Each line of the output is "name,start,end,rank,name", in the order
+ * the intervals end. Records of the workers are merged by their time
+ * stamps without holding them in memory.
+ *
+ * With -c, the output is in Chrome Trace Event Format instead, which
+ * chrome://tracing and Perfetto UI (ui.perfetto.dev) open. Each worker
+ * has a track of the intervals, a steal is a flow arrow from where the
+ * thread became ready (its creation or its last switch-out) to the
+ * thief, and the time a thread spent blocked on a sleep queue, a join
+ * or a file descriptor is an async slice. Time stamp counts are shown
+ * as nanoseconds, as the text output shows them as nanoseconds.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "myth_config.h"
+#include "myth_log_format.h"
+
+#define SCHED_SLEEP ((uint64_t)0xFFFFFFFF)
+#define SCHED_TERM ((uint64_t)0xFFFFFFFE)
+
+/* a file being read */
+typedef struct log_file {
+  const char * name;
+  FILE * fp;
+  myth_log_file_header h;
+  myth_log_entry e;		/* the next record */
+} log_file;
+
+/* an interval a worker is in */
+typedef struct worker_state {
+  int active;
+  char name[MYTH_THREAD_ANNOTATION_MAXLEN + 32];
+  uint64_t t0;
+  uint64_t th;			/* the thread running */
+} worker_state;
+
+/* what -c tracks of each thread */
+typedef struct thread_state {
+  struct thread_state * next;
+  uint64_t th;
+  int ready_rank;		/* -1 if unknown */
+  uint64_t ready_tsc;
+  uint32_t wait_type;		/* 0, MYTH_LOG_BLOCK or MYTH_LOG_IO_WAIT */
+  int wait_rank;
+  uint64_t wait_tsc;
+  uint64_t wait_obj;
+} thread_state;
+
+/* an annotation of a thread */
+typedef struct annotation {
+  struct annotation * next;
+  uint64_t th;
+  uint32_t recycle_count;
+  char name[MYTH_THREAD_ANNOTATION_MAXLEN];
+} annotation;
+
+enum { n_buckets = 4096 };
+static annotation * annotations[n_buckets];
+static int annotated = 0;
+static uint64_t tsc_base = 0;
+static thread_state * threads[n_buckets];
+static int chrome = 0;
+static unsigned long n_flows = 0;
+
+static int read_entry(log_file * f) {
+  return fread(&f->e, sizeof(myth_log_entry), 1, f->fp) == 1;
+}
+
+static unsigned bucket(uint64_t th, uint32_t recycle_count) {
+  return (unsigned)(((th >> 4) * 31 + recycle_count) % n_buckets);
+}
+
+/* read the text records following an annotation in f */
+static void add_annotation(log_file * f) {
+  uint64_t th = f->e.u.thread.th;
+  uint32_t recycle_count = f->e.u.thread.recycle_count;
+  size_t len = f->e.u.thread.len;
+  size_t off;
+  unsigned b = bucket(th, recycle_count);
+  annotation * a;
+  for (a = annotations[b]; a; a = a->next) {
+    if (a->th == th && a->recycle_count == recycle_count) break;
+  }
+  if (!a) {
+    a = (annotation *)calloc(1, sizeof(annotation));
+    a->th = th;
+    a->recycle_count = recycle_count;
+    a->next = annotations[b];
+    annotations[b] = a;
+  }
+  if (len > MYTH_THREAD_ANNOTATION_MAXLEN - 1) {
+    len = MYTH_THREAD_ANNOTATION_MAXLEN - 1;
+  }
+  for (off = 0; off <= len; off += MYTH_LOG_TEXT_SIZE) {
+    size_t sz = (len + 1 - off < MYTH_LOG_TEXT_SIZE
+		 ? len + 1 - off : MYTH_LOG_TEXT_SIZE);
+    if (!read_entry(f) || f->e.type != MYTH_LOG_TEXT) {
+      fprintf(stderr, "%s: broken annotation\n", f->name);
+      exit(1);
+    }
+    memcpy(a->name + off, f->e.u.text, sz);
+  }
+  a->name[len] = 0;
+}
+
+static void thread_name(uint64_t th, uint32_t recycle_count, char * name) {
+  annotation * a;
+  if (th == 0) {
+    strcpy(name, "Scheduler");
+    return;
+  }
+  if (th == SCHED_SLEEP) {
+    strcpy(name, "Sleep");
+    return;
+  }
+  if (!annotated) {
+    strcpy(name, "Computation");
+    return;
+  }
+  for (a = annotations[bucket(th, recycle_count)]; a; a = a->next) {
+    if (a->th == th && a->recycle_count == recycle_count) {
+      strcpy(name, a->name);
+      return;
+    }
+  }
+  sprintf(name, "%p@%u", (void *)(uintptr_t)th, recycle_count);
+}
+
+static int is_thread(uint64_t th) {
+  return th != 0 && th != SCHED_SLEEP && th != SCHED_TERM;
+}
+
+static thread_state * get_thread(uint64_t th) {
+  unsigned b = bucket(th, 0);
+  thread_state * t;
+  for (t = threads[b]; t; t = t->next) {
+    if (t->th == th) return t;
+  }
+  t = (thread_state *)calloc(1, sizeof(thread_state));
+  t->th = th;
+  t->ready_rank = -1;
+  t->next = threads[b];
+  threads[b] = t;
+  return t;
+}
+
+/* time stamp in microseconds for -c */
+static double usec(uint64_t t) {
+  return (double)(t - tsc_base) / 1000.0;
+}
+
+static void put_json_str(FILE * out, const char * s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+    else if (c < 0x20) fprintf(out, "\\u%04x", c);
+    else fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+static void emit(FILE * out, worker_state * w, int rank, uint64_t t1) {
+  if (chrome) {
+    fprintf(out, ",\n{\"name\":");
+    put_json_str(out, w->name);
+    fprintf(out, ",\"cat\":\"thread\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+	    "\"ts\":%.3lf,\"dur\":%.3lf,\"args\":{\"th\":\"%p\"}}",
+	    rank, usec(w->t0), usec(t1) - usec(w->t0),
+	    (void *)(uintptr_t)w->th);
+    return;
+  }
+  fprintf(out, "%s,%.9lf,%.9lf,%d,%s\n", w->name,
+	  (double)(w->t0 - tsc_base) / (1000.0 * 1000.0 * 1000.0),
+	  (double)(t1 - tsc_base) / (1000.0 * 1000.0 * 1000.0),
+	  rank, w->name);
+}
+
+/* -c : the thread th comes to run at time t, ending its wait if any */
+static void resume(FILE * out, uint64_t th, uint64_t t) {
+  thread_state * s = get_thread(th);
+  if (s->wait_type) {
+    const char * name = (s->wait_type == MYTH_LOG_IO_WAIT
+			 ? "io wait" : "blocked");
+    fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"wait\",\"ph\":\"b\","
+	    "\"id\":\"%p\",\"pid\":0,\"tid\":%d,\"ts\":%.3lf,"
+	    "\"args\":{\"%s\":\"%#llx\"}}",
+	    name, (void *)(uintptr_t)th, s->wait_rank, usec(s->wait_tsc),
+	    (s->wait_type == MYTH_LOG_IO_WAIT ? "fd" : "on"),
+	    (unsigned long long)s->wait_obj);
+    fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"wait\",\"ph\":\"e\","
+	    "\"id\":\"%p\",\"pid\":0,\"tid\":%d,\"ts\":%.3lf}",
+	    name, (void *)(uintptr_t)th, s->wait_rank, usec(t));
+    s->wait_type = 0;
+  }
+  s->ready_rank = -1;
+}
+
+/* -c : record e of rank other than a context switch */
+static void thread_event(FILE * out, int rank, myth_log_entry * e) {
+  thread_state * s;
+  switch (e->type) {
+  case MYTH_LOG_CREATE:
+    s = get_thread(e->u.thread.th);
+    s->wait_type = 0;
+    s->ready_rank = rank;
+    s->ready_tsc = e->tsc;
+    break;
+  case MYTH_LOG_STEAL:
+    s = get_thread(e->u.steal.th);
+    n_flows++;
+    /* from where it became ready, or the victim if unknown */
+    fprintf(out, ",\n{\"name\":\"steal\",\"cat\":\"steal\",\"ph\":\"s\","
+	    "\"id\":%lu,\"pid\":0,\"tid\":%d,\"ts\":%.3lf}",
+	    n_flows, (s->ready_rank >= 0 ? s->ready_rank : e->u.steal.victim),
+	    usec(s->ready_rank >= 0 ? s->ready_tsc : e->tsc));
+    /* to the slice of the thread on the thief */
+    fprintf(out, ",\n{\"name\":\"steal\",\"cat\":\"steal\",\"ph\":\"f\","
+	    "\"id\":%lu,\"pid\":0,\"tid\":%d,\"ts\":%.3lf,"
+	    "\"args\":{\"victim\":%d}}",
+	    n_flows, rank, usec(e->tsc), e->u.steal.victim);
+    s->ready_rank = -1;
+    break;
+  case MYTH_LOG_BLOCK:
+  case MYTH_LOG_IO_WAIT:
+    s = get_thread(e->u.wait.th);
+    s->wait_type = e->type;
+    s->wait_rank = rank;
+    s->wait_tsc = e->tsc;
+    s->wait_obj = e->u.wait.obj;
+    break;
+  }
+}
+
+/* process a context switch on worker rank */
+static void context_switch(FILE * out, worker_state * w, int rank,
+			   myth_log_entry * e) {
+  char name[sizeof(w->name)];
+  if (chrome) {
+    /* the thread switched out may be stolen from here later */
+    if (w->active && is_thread(w->th)) {
+      thread_state * s = get_thread(w->th);
+      if (!s->wait_type) {
+	s->ready_rank = rank;
+	s->ready_tsc = (e->tsc > w->t0 ? e->tsc - 1 : e->tsc);
+      }
+    }
+    if (is_thread(e->u.thread.th)) resume(out, e->u.thread.th, e->tsc);
+  }
+  if (e->u.thread.th == SCHED_TERM) {
+    if (w->active) emit(out, w, rank, e->tsc - 1);
+    w->active = 0;
+    return;
+  }
+  thread_name(e->u.thread.th, e->u.thread.recycle_count, name);
+  if (w->active) {
+#if MYTH_LOG_MERGE_SAME_NAME_THREADS
+    if (!chrome && strcmp(w->name, name) == 0) return;
+#endif
+    emit(out, w, rank, e->tsc - 1);
+  }
+  w->active = 1;
+  w->th = e->u.thread.th;
+  strcpy(w->name, name);
+  w->t0 = e->tsc;
+}
+
+/* binary heap of files ordered by the time of their next records */
+static int earlier(log_file * a, log_file * b) {
+  if (a->e.tsc != b->e.tsc) return a->e.tsc < b->e.tsc;
+  return a->h.rank < b->h.rank;
+}
+
+static void sift_down(log_file ** heap, int n, int i) {
+  while (2 * i + 1 < n) {
+    int c = 2 * i + 1;
+    log_file * t;
+    if (c + 1 < n && earlier(heap[c + 1], heap[c])) c++;
+    if (!earlier(heap[c], heap[i])) break;
+    t = heap[c]; heap[c] = heap[i]; heap[i] = t;
+    i = c;
+  }
+}
+
+static void usage(const char * prog) {
+  fprintf(stderr, "usage: %s [-c] [-o output] myth-log-<pid>-<rank>.bin ...\n"
+	  "  -c : write Chrome Trace Event Format (json)\n", prog);
+  exit(1);
+}
+
+int main(int argc, char ** argv) {
+  FILE * out = stdout;
+  log_file * files;
+  log_file ** heap;
+  worker_state * workers;
+  int n_workers = 0;
+  int n = 0, i, c;
+  while ((c = getopt(argc, argv, "co:")) != -1) {
+    switch (c) {
+    case 'c':
+      chrome = 1;
+      break;
+    case 'o':
+      out = fopen(optarg, "w");
+      if (!out) { perror(optarg); return 1; }
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if (optind >= argc) usage(argv[0]);
+  files = (log_file *)calloc(argc - optind, sizeof(log_file));
+  heap = (log_file **)calloc(argc - optind, sizeof(log_file *));
+  for (i = optind; i < argc; i++) {
+    log_file * f = &files[i - optind];
+    f->name = argv[i];
+    f->fp = fopen(f->name, "rb");
+    if (!f->fp) { perror(f->name); return 1; }
+    if (fread(&f->h, sizeof(f->h), 1, f->fp) != 1
+	|| memcmp(f->h.magic, MYTH_LOG_FILE_MAGIC, sizeof(MYTH_LOG_FILE_MAGIC)) != 0
+	|| f->h.version != MYTH_LOG_FILE_VERSION
+	|| f->h.entry_size != sizeof(myth_log_entry)) {
+      fprintf(stderr, "%s: not a log of this version\n", f->name);
+      return 1;
+    }
+    if (f->h.flags & MYTH_LOG_FILE_ANNOTATION) annotated = 1;
+    if (n_workers <= f->h.rank) n_workers = f->h.rank + 1;
+    if (i == optind || f->h.tsc_base < tsc_base) tsc_base = f->h.tsc_base;
+    if (read_entry(f)) heap[n++] = f;
+  }
+  workers = (worker_state *)calloc(n_workers, sizeof(worker_state));
+  if (chrome) {
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\n\"traceEvents\":[\n"
+	    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+	    "\"args\":{\"name\":\"MassiveThreads\"}}");
+    for (i = 0; i < n_workers; i++) {
+      fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+	      "\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", i, i);
+    }
+  }
+  for (i = n / 2 - 1; i >= 0; i--) sift_down(heap, n, i);
+  /* k-way merge */
+  while (n > 0) {
+    log_file * f = heap[0];
+    switch (f->e.type) {
+    case MYTH_LOG_THREAD_ANNOTATION:
+      add_annotation(f);
+      break;
+    case MYTH_LOG_SWITCH:
+      context_switch(out, &workers[f->h.rank], f->h.rank, &f->e);
+      break;
+    case MYTH_LOG_CREATE:
+    case MYTH_LOG_STEAL:
+    case MYTH_LOG_BLOCK:
+    case MYTH_LOG_IO_WAIT:
+      if (chrome) thread_event(out, f->h.rank, &f->e);
+      break;
+    default:
+      fprintf(stderr, "%s: unknown record type %u\n", f->name, f->e.type);
+      return 1;
+    }
+    if (!read_entry(f)) {
+      fclose(f->fp);
+      heap[0] = heap[--n];
+    }
+    sift_down(heap, n, 0);
+  }
+  if (chrome) fprintf(out, "\n]}\n");
+  if (out != stdout) fclose(out);
+  free(workers);
+  free(heap);
+  free(files);
+  return 0;
+}
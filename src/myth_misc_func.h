@@ -40,6 +40,15 @@ static inline uint64_t myth_get_rdtsc() {
 #endif
 }
 
+//Hint to the cpu that we are in a spin-wait loop
+static inline void myth_spin_pause(void) {
+#if MYTH_ARCH == MYTH_ARCH_i386 || MYTH_ARCH == MYTH_ARCH_amd64
+  asm volatile("pause" ::: "memory");
+#else
+  asm volatile("" ::: "memory");
+#endif
+}
+
 static inline int hr_gettime(struct timespec * ts) {
 #if defined(HAVE_LIBRT)
   return clock_gettime(CLOCK_REALTIME, ts);
@@ -16,10 +16,15 @@ int g_envs_sz = 0;
 //A barrier for worker thread to synchronize
 myth_internal_barrier_t g_worker_barrier;
 
-FILE *g_log_fp;
-
 int g_sched_prof=0;
 int g_log_worker_stat=0;
+
+long g_myth_stack_cache_high = MYTH_STACK_CACHE_HIGH;
+long g_myth_stack_cache_max = MYTH_STACK_CACHE_MAX;
+int g_myth_stack_cache_stats = 0;
+size_t g_myth_stack_arena_size = MYTH_STACK_ARENA_SIZE;
+int g_myth_stack_arena_hugepage = 0;
+size_t g_myth_stack_arena_guard = 0;
 pthread_key_t g_worker_key;
 
 #define PAGE_ALIGN(n) ((((n)+(PAGE_SIZE)-1)/(PAGE_SIZE))*PAGE_SIZE)
@@ -76,9 +81,175 @@ void myth_alrm_sighandler(int signum, siginfo_t *sinfo, void* ctx) {
 #if MYTH_WRAP_SOCKIO
       myth_thread_t ret;
       ret=myth_io_polling_sig(env);
-      if (ret)myth_queue_push(&env->runnable_q,ret);
+      if (ret)myth_runq_push(env, ret);
 #endif
     }
   errno=errno_bk;
 }
 
+#if MYTH_SPLIT_STACK_DESC
+
+//Blocks are mapped one by one and can be unmapped one by one
+#define MYTH_STACK_CACHE_CAN_UNMAP (STACK_ALLOC_UNIT == 1 && !ALLOCATE_STACK_BY_MALLOC)
+
+//Size of a slot holding a stack of the default size in an arena;
+//the guard (if any) comes first
+static size_t myth_stack_arena_slot_size(void) {
+  return g_myth_stack_arena_guard + PAGE_ALIGN(g_attr.stacksize);
+}
+
+//Size of a block holding a stack of the default size
+static size_t myth_stack_block_size(void) {
+  size_t th_size = g_attr.stacksize;
+  if (g_myth_stack_arena_size) return myth_stack_arena_slot_size();
+#if USE_STACK_GUARDPAGE
+  th_size += PAGE_SIZE;
+#endif
+  return (MYTH_STACK_CACHE_CAN_UNMAP ? PAGE_ALIGN(th_size) : th_size);
+}
+
+//Map a new arena for env, aligned to MYTH_STACK_ARENA_ALIGN
+static void myth_stack_arena_map(myth_running_env_t env) {
+  size_t slot_size = myth_stack_arena_slot_size();
+  size_t size = g_myth_stack_arena_size;
+  char * p, * q;
+  uintptr_t a;
+  if (size < slot_size) {
+    size = ((slot_size + MYTH_STACK_ARENA_ALIGN - 1)
+	    / MYTH_STACK_ARENA_ALIGN) * MYTH_STACK_ARENA_ALIGN;
+  }
+  p = myth_mmap(NULL, size + MYTH_STACK_ARENA_ALIGN, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MYTH_MAP_ANON|MYTH_MAP_STACK, -1, 0);
+  //Trim both ends so that [q, q + size) is aligned
+  a = ((uintptr_t)p + MYTH_STACK_ARENA_ALIGN - 1)
+    & ~((uintptr_t)MYTH_STACK_ARENA_ALIGN - 1);
+  q = (char *)a;
+  if (q > p) myth_munmap(p, q - p);
+  myth_munmap(q + size, (p + MYTH_STACK_ARENA_ALIGN) - q);
+#ifdef MADV_HUGEPAGE
+  if (g_myth_stack_arena_hugepage) {
+    madvise(q, size, MADV_HUGEPAGE);
+  }
+#endif
+  if (g_myth_stack_arena_guard) {
+    //All guards of the arena at once, rather than as each stack is
+    //first used. Each still splits the arena's mapping
+    char * s;
+    for (s = q; s + slot_size <= q + size; s += slot_size) {
+      mprotect(s, g_myth_stack_arena_guard, PROT_NONE);
+    }
+  }
+  env->stack_arena.cur = q;
+  env->stack_arena.end = q + size;
+  env->stack_cache.n_arenas++;
+}
+
+//Return a new stack of the default size carved out of env's arena
+//(its freelist cell, as get_new_myth_thread_struct_stack does)
+void * myth_stack_arena_alloc(myth_running_env_t env) {
+  size_t slot_size = myth_stack_arena_slot_size();
+  char * th_ptr;
+  uintptr_t * blk_size;
+  if (env->stack_arena.end - env->stack_arena.cur < (ptrdiff_t)slot_size) {
+    myth_stack_arena_map(env);
+  }
+  th_ptr = env->stack_arena.cur;
+  env->stack_arena.cur += slot_size;
+  th_ptr += slot_size - (sizeof(void*) * 2);
+  blk_size = (uintptr_t*)(th_ptr + sizeof(void*));
+  *blk_size = 0;	  //indicates default
+  return th_ptr;
+}
+
+//Size of a block holding a descriptor
+static size_t myth_desc_block_size(void) {
+  size_t th_size = sizeof(struct myth_thread);
+  return (MYTH_STACK_CACHE_CAN_UNMAP ? PAGE_ALIGN(th_size) : th_size);
+}
+
+//Called when env frees a stack beyond g_myth_stack_cache_high.
+//ptr is the freelist cell at the top of the stack.
+//Release the pages of the stack but keep it for reuse, or unmap
+//it if g_myth_stack_cache_max released stacks are kept already.
+//Stacks in arenas are never unmapped
+void myth_stack_cache_release_stack(myth_running_env_t env, void * ptr) {
+  uintptr_t a, b;
+  if (g_myth_stack_arena_size) {
+    a = (uintptr_t)ptr + sizeof(void*) * 2 - myth_stack_arena_slot_size()
+      + g_myth_stack_arena_guard;
+  } else {
+    size_t th_size = g_attr.stacksize;
+    char * base;
+#if USE_STACK_GUARDPAGE
+    th_size += PAGE_SIZE;
+#endif
+    base = (char *)ptr + sizeof(void*) * 2 - th_size;
+#if MYTH_STACK_CACHE_CAN_UNMAP
+    if (env->stack_cache.n_released_stacks >= g_myth_stack_cache_max) {
+      myth_munmap(base, PAGE_ALIGN(th_size));
+      env->stack_cache.n_unmapped_stacks++;
+      return;
+    }
+#endif
+    a = PAGE_ALIGN((uintptr_t)base);
+#if USE_STACK_GUARDPAGE
+    a += PAGE_SIZE;
+#endif
+  }
+  //All pages but the top one, which holds the freelist cell
+  b = (uintptr_t)ptr & ~((uintptr_t)PAGE_SIZE - 1);
+  if (a < b) {
+#ifdef MADV_FREE
+    //Cheaper, as the pages are reclaimed only under memory pressure;
+    //not supported before Linux 4.5
+    if (madvise((void *)a, b - a, MADV_FREE) != 0)
+#endif
+      madvise((void *)a, b - a, MADV_DONTNEED);
+  }
+  myth_freelist_push(&env->freelist_stack_released, ptr);
+  env->stack_cache.n_released_stacks++;
+}
+
+//Called when env frees a descriptor beyond g_myth_stack_cache_high
+void myth_stack_cache_release_desc(myth_running_env_t env, void * th) {
+#if MYTH_STACK_CACHE_CAN_UNMAP
+  myth_munmap(th, myth_desc_block_size());
+  env->stack_cache.n_unmapped_descs++;
+#else
+  myth_freelist_push(&env->freelist_desc, th);
+  env->stack_cache.n_descs++;
+#endif
+}
+
+//Print the sizes of env's caches (MYTH_STACK_CACHE_STATS=1)
+void myth_stack_cache_print_stats(myth_running_env_t env) {
+  myth_stack_cache_stats_t s = &env->stack_cache;
+  unsigned long st_size = myth_stack_block_size();
+  unsigned long desc_size = myth_desc_block_size();
+  fprintf(stderr,
+	  "Rank %d: stacks cached %ld (%lu bytes) released %ld (%lu bytes)"
+	  " unmapped %ld (%lu bytes)\n",
+	  env->rank,
+	  s->n_stacks, s->n_stacks * st_size,
+	  s->n_released_stacks, s->n_released_stacks * st_size,
+	  s->n_unmapped_stacks, s->n_unmapped_stacks * st_size);
+  fprintf(stderr,
+	  "Rank %d: descriptors cached %ld (%lu bytes)"
+	  " unmapped %ld (%lu bytes)\n",
+	  env->rank,
+	  s->n_descs, s->n_descs * desc_size,
+	  s->n_unmapped_descs, s->n_unmapped_descs * desc_size);
+  fprintf(stderr,
+	  "Rank %d: sent to other workers %ld stacks %ld descriptors,"
+	  " taken back from them %ld stacks %ld descriptors\n",
+	  env->rank,
+	  s->n_remote_stacks_out, s->n_remote_descs_out,
+	  s->n_remote_stacks_in, s->n_remote_descs_in);
+  if (g_myth_stack_arena_size) {
+    fprintf(stderr, "Rank %d: stack arenas %ld (%lu bytes)\n",
+	    env->rank, s->n_arenas,
+	    (unsigned long)(s->n_arenas * g_myth_stack_arena_size));
+  }
+}
+
+#endif
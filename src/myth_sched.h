@@ -41,6 +41,9 @@ MYTH_CTX_CALLBACK void myth_create_1(void *arg1,void *arg2,void *arg3);
 static inline int myth_create_ex_body(myth_thread_t * id,
 				      myth_thread_attr_t * attr,
 				      myth_func_t func, void *arg);
+static inline myth_thread_t myth_create_on_body(int worker,
+						myth_func_t func, void *arg);
+static inline int myth_thread_attr_init_body(myth_thread_attr_t * attr);
 MYTH_CTX_CALLBACK void myth_yield_ex_1(void * arg1, void * arg2, void * arg3);
 static inline int myth_yield_ex_body(int yield_opt);
 static inline int myth_yield_body(void);
@@ -64,6 +67,8 @@ static inline void *get_new_myth_thread_struct_stack(myth_running_env_t env,size
 static inline void init_myth_thread_struct(myth_running_env_t env,myth_thread_t th);
 static inline void free_myth_thread_struct_desc(myth_running_env_t e,myth_thread_t th);
 static inline void free_myth_thread_struct_stack(myth_running_env_t e,myth_thread_t th);
+static inline myth_thread_t get_new_myth_thread_struct_desc_ext(void);
+static inline void free_myth_thread_struct_desc_ext(myth_thread_t th);
 
 
 
@@ -4,7 +4,9 @@
 #pragma once
 #ifndef MYTH_SCHED_FUNC_H_
 #define MYTH_SCHED_FUNC_H_
+#include <stddef.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
 #include <sched.h>
@@ -31,6 +33,7 @@
 #include "myth_spinlock_func.h"
 #include "myth_desc_func.h"
 #include "myth_tls_func.h"
+#include "myth_timer_func.h"
 
 #ifndef PAGE_ALIGN
 #define PAGE_ALIGN(n) ((((n)+(PAGE_SIZE)-1)/(PAGE_SIZE))*PAGE_SIZE)
@@ -43,6 +46,72 @@ static inline size_t myth_align_stack_size(size_t newsize){
 #define myth_dprintf(...) myth_dprintf_1((char*)__func__,__VA_ARGS__)
 void myth_dprintf_1(char *func,char *fmt,...);
 
+#if MYTH_SPLIT_STACK_DESC
+//Put a freed stack of env (ptr is its freelist cell) to its cache,
+//or give it back if the cache is full
+static inline void myth_stack_cache_put_stack(myth_running_env_t env, void * ptr) {
+  if (env->stack_cache.n_stacks < g_myth_stack_cache_high) {
+    myth_freelist_push(&env->freelist_stack, ptr);
+    env->stack_cache.n_stacks++;
+  } else {
+    myth_stack_cache_release_stack(env, ptr);
+  }
+}
+
+//Put a freed descriptor of env to its cache, or give it back
+static inline void myth_stack_cache_put_desc(myth_running_env_t env, void * th) {
+  if (env->stack_cache.n_descs < g_myth_stack_cache_high) {
+    myth_freelist_push(&env->freelist_desc, th);
+    env->stack_cache.n_descs++;
+  } else {
+    myth_stack_cache_release_desc(env, th);
+  }
+}
+
+//Send a stack or descriptor freed by another worker to its home
+static inline void myth_remote_free_push(myth_freelist_cell_t * volatile * head,
+					 void * h_) {
+  myth_freelist_cell_t * h = h_;
+  myth_freelist_cell_t * x;
+  do {
+    x = *head;
+    h->next = x;
+  } while (!__sync_bool_compare_and_swap(head, x, h));
+}
+
+//Take all from a remote free list
+static inline myth_freelist_cell_t *
+myth_remote_free_take_all(myth_freelist_cell_t * volatile * head) {
+  myth_freelist_cell_t * x;
+  do {
+    x = *head;
+  } while (x && !__sync_bool_compare_and_swap(head, x, NULL));
+  return x;
+}
+
+//Move stacks other workers have sent back to env into its cache
+static inline void myth_remote_free_drain_stacks(myth_running_env_t env) {
+  myth_freelist_cell_t * x = myth_remote_free_take_all(&env->remote_free.stacks);
+  while (x) {
+    myth_freelist_cell_t * next = x->next;
+    myth_stack_cache_put_stack(env, x);
+    env->stack_cache.n_remote_stacks_in++;
+    x = next;
+  }
+}
+
+//Move descriptors other workers have sent back to env into its cache
+static inline void myth_remote_free_drain_descs(myth_running_env_t env) {
+  myth_freelist_cell_t * x = myth_remote_free_take_all(&env->remote_free.descs);
+  while (x) {
+    myth_freelist_cell_t * next = x->next;
+    myth_stack_cache_put_desc(env, x);
+    env->stack_cache.n_remote_descs_in++;
+    x = next;
+  }
+}
+#endif
+
 //Return a new thread descriptor
 static inline myth_thread_t get_new_myth_thread_struct_desc(myth_running_env_t env) {
 #if MYTH_SPLIT_STACK_DESC
@@ -51,7 +120,12 @@ static inline myth_thread_t get_new_myth_thread_struct_desc(myth_running_env_t e
   env->prof_data.dalloc_cnt++;
 #endif
   void * v_ret = myth_freelist_pop(&env->freelist_desc);
+  if (!v_ret && env->remote_free.descs) {
+    myth_remote_free_drain_descs(env);
+    v_ret = myth_freelist_pop(&env->freelist_desc);
+  }
   if (v_ret){
+    env->stack_cache.n_descs--;
     return v_ret;
   } else {
     //Allocate
@@ -82,6 +156,7 @@ static inline myth_thread_t get_new_myth_thread_struct_desc(myth_running_env_t e
       myth_spin_init_body(&ret->sanity_check);
 #endif
       myth_spin_init_body(&ret->lock);
+      ret->home = env->rank;
       if (i < STACK_ALLOC_UNIT - 1){
 	myth_freelist_push(&env->freelist_desc, ret);
 	th_ptr += th_size;
@@ -107,7 +182,7 @@ static inline myth_thread_t get_new_myth_thread_struct_desc(myth_running_env_t e
     //Allocate
     int i;
     size_t st_size = MYTH_MALLOC_SIZE_TO_RSIZE(REAL_STACK_SIZE);
-    size_t th_size = st_size + sizeof(myth_thread);
+    size_t th_size = st_size + sizeof(struct myth_thread);
     size_t alloc_size = th_size * STACK_ALLOC_UNIT;
 #if MYTH_ALLOC_PROF
     env->prof_data.malloc_cnt++;
@@ -177,8 +252,21 @@ th_ptr -> 4080-4087:
     return th_ptr;
   }
   void * ret = myth_freelist_pop(&env->freelist_stack);
+  if (!ret && env->remote_free.stacks) {
+    myth_remote_free_drain_stacks(env);
+    ret = myth_freelist_pop(&env->freelist_stack);
+  }
+  if (ret) {
+    env->stack_cache.n_stacks--;
+    return ret;
+  }
+  ret = myth_freelist_pop(&env->freelist_stack_released);
   if (ret) {
+    env->stack_cache.n_released_stacks--;
     return ret;
+  } else if (g_myth_stack_arena_size) {
+    //Carve out of the arena
+    return myth_stack_arena_alloc(env);
   } else {
     //Allocate
     int i;
@@ -221,6 +309,7 @@ th_ptr -> 4080-4087:
       *blk_size = 0;	  //indicates default
       if (i < STACK_ALLOC_UNIT - 1) {
 	myth_freelist_push(&env->freelist_stack, ret);
+	env->stack_cache.n_stacks++;
 	th_ptr += th_size;
       }
     }
@@ -237,10 +326,12 @@ th_ptr -> 4080-4087:
 
 static inline void init_myth_thread_struct(myth_running_env_t env, myth_thread_t th) {
   th->status = MYTH_STATUS_READY;
-  th->join_thread = NULL;
+  th->join_state = MYTH_JOIN_RUNNING;
   th->detached = 0;
   th->cancel_enabled = 1;
   th->cancelled = 0;
+  th->priority = 0;
+  th->pin = NULL;
   //th->pickle_ptr=NULL;
   th->env = env;
 #if MYTH_ENABLE_THREAD_ANNOTATION && MYTH_COLLECT_LOG
@@ -273,8 +364,17 @@ static inline void free_myth_thread_struct_desc(myth_running_env_t e,myth_thread
 #if MYTH_DESC_REUSE_CHECK
   myth_spin_unlock_body(&th->sanity_check);
 #endif
-  //Add to a freelist
-  myth_freelist_push(&e->freelist_desc,(void*)th);
+  if (th->home == MYTH_HOME_EXT){
+    //Not a block of the cache, which may unmap it
+    free_myth_thread_struct_desc_ext(th);
+  } else if (th->home != e->rank){
+    //Send it back to the worker that allocated it
+    myth_remote_free_push(&g_envs[th->home].remote_free.descs,(void*)th);
+    e->stack_cache.n_remote_descs_out++;
+  } else {
+    //Add to a freelist
+    myth_stack_cache_put_desc(e,(void*)th);
+  }
 #else
   myth_assert(th);
 #if FREE_MYTH_THREAD_STRUCT_DEBUG
@@ -304,7 +404,14 @@ static inline void free_myth_thread_struct_stack(myth_running_env_t e,myth_threa
 
     uintptr_t *blk_size = (uintptr_t*)(((uint8_t*)ptr) + sizeof(void*));
     if (*blk_size == 0) {
-      myth_freelist_push(&e->freelist_stack, ptr);
+      //The stack of an external descriptor stays with this worker
+      if (th->home != e->rank && th->home != MYTH_HOME_EXT) {
+	//Send it back to the worker that allocated it
+	myth_remote_free_push(&g_envs[th->home].remote_free.stacks, ptr);
+	e->stack_cache.n_remote_stacks_out++;
+      } else {
+	myth_stack_cache_put_stack(e, ptr);
+      }
     } else {
       void *stack_start=(((uint8_t*)ptr)-(*blk_size)+(sizeof(void*)*2));
       myth_flfree(e->rank,(size_t)(*blk_size),stack_start);
@@ -337,7 +444,7 @@ MYTH_CTX_CALLBACK void myth_create_1(void *arg1,void *arg2,void *arg3) {
 #endif
 
   //Push current thread to runqueue
-  myth_queue_push(&env->runnable_q, this_thread);
+  myth_runq_push(env, this_thread);
 
 #if MYTH_CREATE_PROF_DETAIL
   t1 = myth_get_rdtsc();
@@ -362,7 +469,13 @@ MYTH_CTX_CALLBACK void myth_create_1(void *arg1,void *arg2,void *arg3) {
   }
 #endif
   // Call entry point function
-  new_thread->result = (*fn)(new_thread->result);
+  {
+    void * result = (*fn)(new_thread->result);
+    //The thread may have been deserialized into another descriptor
+    //(myth_deserialize) meanwhile; look it up again
+    new_thread = myth_get_current_env_again()->this_thread;
+    new_thread->result = result;
+  }
   //myth_log_add(new_thread->env,MYTH_LOG_INT);
   myth_entry_point_cleanup(new_thread);
 }
@@ -391,12 +504,21 @@ static inline int myth_create_ex_body(myth_thread_t * id,
   size_t custom_data_size = (attr ? attr->custom_data_size : 0);
   void * custom_data      = (attr ? attr->custom_data : 0);
   int child_first         = (attr ? attr->child_first : 1);
+  int priority            = (attr ? attr->priority : 0);
+  int worker              = (attr ? attr->on_worker - 1 : -1);
+  int numa_node           = (attr ? attr->on_numa_node - 1 : -1);
+  int pinned              = (attr ? attr->pinned : 0);
   myth_running_env_t env = myth_get_current_env();
+  //Worker to deliver the new thread to, if not this one
+  myth_running_env_t target = NULL;
   //myth_log_add(env,MYTH_LOG_INT);
   // Allocate new thread descriptor
   myth_thread_t new_thread = get_new_myth_thread_struct_desc(env);
   (void)_;
   new_thread->next = 0;
+  if (worker >= 0 || numa_node >= 0) {
+    target = myth_preferred_env(env, worker, numa_node);
+  }
 #if MYTH_DEBUG_JOIN_FCC
   new_thread->join_called_at = 0;
   new_thread->child_status_when_join_was_called = "";
@@ -433,9 +555,24 @@ static inline int myth_create_ex_body(myth_thread_t * id,
   // Initialize thread descriptor
   init_myth_thread_struct(env, new_thread);
   new_thread->result = arg;
+  if (MYTH_N_PRIORITIES > 1 && priority > 0) {
+    new_thread->priority = (priority < MYTH_N_PRIORITIES ?
+			    priority : MYTH_N_PRIORITIES - 1);
+    if (!(g_myth_runq_slow & MYTH_RUNQ_SLOW_PRIO)) {
+      __sync_fetch_and_or(&g_myth_runq_slow, MYTH_RUNQ_SLOW_PRIO);
+    }
+  }
+  if (pinned) {
+    new_thread->pin = (target ? target : env);
+    if (!(g_myth_runq_slow & MYTH_RUNQ_SLOW_PINNED)) {
+      __sync_fetch_and_or(&g_myth_runq_slow, MYTH_RUNQ_SLOW_PINNED);
+    }
+  }
+  env->stats.n_created++;
+  myth_log_add_create(env, new_thread);
 
   size_t stk_size = stack_size - sizeof(void*) * 2;
-  if (child_first){
+  if (child_first && !target){
     myth_make_context_empty(&new_thread->context, stk, stk_size);
 
 #if MYTH_CREATE_PROF_DETAIL
@@ -472,8 +609,12 @@ static inline int myth_create_ex_body(myth_thread_t * id,
     env->prof_data.create_cycles_tmp=t0;
 #endif /* MYTH_CREATE_PROF */
 
-    //Push a new thread to runqueue
-    myth_queue_push(&env->runnable_q, new_thread);
+    //Push a new thread to runqueue, or hand it to target
+    if (target) {
+      myth_inbox_push(target, new_thread);
+    } else {
+      myth_runq_push(env, new_thread);
+    }
 #if MYTH_CREATE_PROF
     t1 = myth_get_rdtsc();
     env->prof_data.create_cycles += t1 - t0;
@@ -484,6 +625,16 @@ static inline int myth_create_ex_body(myth_thread_t * id,
   return 0;
 }
 
+static inline myth_thread_t myth_create_on_body(int worker,
+						myth_func_t func, void *arg) {
+  myth_thread_t id = 0;
+  myth_thread_attr_t attr;
+  myth_thread_attr_init_body(&attr);
+  attr.on_worker = worker + 1;
+  myth_create_ex_body(&id, &attr, func, arg);
+  return id;
+}
+
 /* --------
    exit
    -------- */
@@ -509,26 +660,37 @@ static inline void myth_join_1(myth_running_env_t e,myth_thread_t th,void **resu
   free_myth_thread_struct_desc(e,th);
 }
 
+//The joiner's context has been saved; th may wake it up from now on.
+//If th has finished meanwhile, put the joiner back to the runqueue
+static inline void myth_join_set_or_resume(myth_running_env_t env,
+					   myth_thread_t th,
+					   myth_thread_t this_thread)
+{
+  if (!myth_desc_join_set(th,this_thread)){
+    this_thread->env=env;
+    this_thread->status=MYTH_STATUS_READY;
+    myth_runq_push(env, this_thread);
+  }
+}
+
 MYTH_CTX_CALLBACK void myth_join_2(void *arg1,void *arg2,void *arg3)
 {
   myth_running_env_t env=arg1;
   myth_thread_t th=arg2,next_thread=arg3;
-  //Set join target
-  myth_desc_join_set(th,env->this_thread);
-  myth_spin_unlock_body(&th->lock);
+  myth_thread_t this_thread=env->this_thread;
   //Change current running thread
   env->this_thread=next_thread;
+  //Set join target
+  myth_join_set_or_resume(env,th,this_thread);
   //myth_log_add(env,MYTH_LOG_USER);
 }
 
 MYTH_CTX_CALLBACK void myth_join_3(void *arg1,void *arg2,void *arg3)
 {
   myth_thread_t this_thread=arg1,th=arg2;
-  (void)arg3;
+  myth_running_env_t env=arg3;
   //Set join target
-  myth_desc_join_set(th,this_thread);
-  //Change current running thread
-  myth_spin_unlock_body(&th->lock);
+  myth_join_set_or_resume(env,th,this_thread);
 }
 
 //Wait until the finish of a thread
@@ -551,42 +713,8 @@ static inline int myth_join_body(myth_thread_t th,void **result) {
 #if MYTH_JOIN_DEBUG
   myth_dprintf("myth_join:join started\n");
 #endif
-#if QUICK_CHECK_ON_JOIN
-
-#error "I told you to turn this off"
-  
   //If target is finished, return immediately
-  if (th->status == MYTH_STATUS_FREE_READY2){
-#if MYTH_JOIN_DEBUG
-    myth_dprintf("myth_join:join thread (%p) is already finished. Return immediately\n",th);
-#endif
-    //guarantee that successive read starts after this line
-    myth_rbarrier();
-#if MYTH_JOIN_PROF_DETAIL
-    if (result) *result = th->result;
-    t1 = myth_get_rdtsc();
-    env->prof_data.join_join += t1 - t0;
-    t0 = myth_get_rdtsc();
-    free_myth_thread_struct_desc(env,th);
-    t1 = myth_get_rdtsc();
-    env->prof_data.join_release += t1 - t0;
-    env->prof_data.join_d_cnt++;
-#else
-    myth_join_1(env,th,result);
-#endif
-#if MYTH_JOIN_PROF
-    t1 = myth_get_rdtsc();
-    env->prof_data.join_cycles += t1-t0;
-    env->prof_data.join_cnt++;
-#endif
-    //myth_log_add(env,MYTH_LOG_USER);
-    return 0;
-  }
-#endif
-  //Obtain lock and check again
-  myth_spin_lock_body(&th->lock);
-  //If target is finished, return
-  if (myth_desc_is_finished(th)){
+  if (th->join_state == MYTH_JOIN_FINISHED){
 #if MYTH_DEBUG_JOIN_FCC
     th->join_called_at = myth_get_rdtsc();
     th->child_status_when_join_was_called = "child has been finished";
@@ -595,8 +723,8 @@ static inline int myth_join_body(myth_thread_t th,void **result) {
 #if MYTH_JOIN_DEBUG
     myth_dprintf("myth_join:join thread (%p) is already finished. Return immediately\n",th);
 #endif
-    myth_spin_unlock_body(&th->lock);
-    while (th->status != MYTH_STATUS_FREE_READY2);
+    //guarantee that successive read starts after this line
+    myth_rbarrier();
 #if MYTH_JOIN_PROF_DETAIL
     if (result) *result = th->result;
     t1 = myth_get_rdtsc();
@@ -619,12 +747,13 @@ static inline int myth_join_body(myth_thread_t th,void **result) {
   }
   //Set current thread as blocked
   myth_desc_set_not_runnable(this_thread);
+  myth_log_add_wait(env, MYTH_LOG_BLOCK, this_thread, (uint64_t)(uintptr_t)th);
 #if MYTH_JOIN_DEBUG
   myth_dprintf("myth_join:%p is added to %p's waiting list\n",this_thread,th);
 #endif
   //Get next runnable thread
   myth_thread_t next;
-  next = myth_queue_pop(&env->runnable_q);
+  next = myth_runq_pop(env);
 #if MYTH_JOIN_PROF
   t1 = myth_get_rdtsc();
 #endif
@@ -646,7 +775,7 @@ static inline int myth_join_body(myth_thread_t th,void **result) {
     //myth_log_add(this_thread->env,MYTH_LOG_WS);
     //Since there is no runnable thread, switch to scheduler and do work-steaing
     myth_swap_context_withcall(&this_thread->context,&env->sched.context,myth_join_3,
-			       (void*)this_thread,(void*)th,NULL);
+			       (void*)this_thread,(void*)th,(void*)env);
   }
 #if MYTH_JOIN_PROF
   t2 = myth_get_rdtsc();
@@ -655,15 +784,8 @@ static inline int myth_join_body(myth_thread_t th,void **result) {
 #if MYTH_JOIN_DEBUG
   myth_dprintf("myth_join:%p is resumed\n",this_thread);
 #endif
-#if 0
-  myth_spin_lock_body(&th->lock);
   //In this position, target is guaranteed to be finished
-  myth_assert(myth_desc_is_runnable(this_thread));
-  myth_assert(myth_desc_is_finished(th));
-  //Get return value
-  myth_spin_unlock_body(&th->lock);
-#endif
-  while (th->status != MYTH_STATUS_FREE_READY2) { }
+  myth_desc_wait_finished(th);
   myth_join_1(myth_get_current_env(),th,result);
 #if MYTH_JOIN_PROF
   t3 = myth_get_rdtsc();
@@ -683,17 +805,13 @@ static inline int myth_tryjoin_body(myth_thread_t th,void **result) {
   //TODO:Fix th->status is blocked after join
   myth_running_env_t env;
   env = myth_get_current_env();
-  //Obtain lock and check again
-  myth_spin_lock_body(&th->lock);
   //If target is finished, return
   if (myth_desc_is_finished(th)){
-    myth_spin_unlock_body(&th->lock);
-    while (th->status != MYTH_STATUS_FREE_READY2) { }
+    myth_desc_wait_finished(th);
     myth_join_1(env,th,result);
     //myth_log_add(env,MYTH_LOG_USER);
     return 0;
   } else {
-    myth_spin_unlock_body(&th->lock);
     return EBUSY;
   }
 }
@@ -717,25 +835,56 @@ static inline int myth_timespec_gt(const struct timespec * a,
   return 0;
 }
 
-//Wait until the finish of a thread
+/* called by the timer of a timedjoin on expiry. th has not
+   finished if its join state is still the joiner */
+static inline int myth_timedjoin_withdraw(myth_timer_t t) {
+  myth_thread_t th = t->arg;
+  if (myth_desc_join_unset(th, t->th)) {
+    t->th->status = MYTH_STATUS_READY;
+    return 1;
+  }
+  return 0;
+}
+
+//Wait until the finish of a thread or abstime
 static inline int myth_timedjoin_body(myth_thread_t th,
 				      void **result,
 				      const struct timespec *abstime) {
-  if (myth_tryjoin_body(th, result) == 0) {
+  myth_running_env_t env = myth_get_current_env();
+  myth_thread_t this_thread = env->this_thread;
+  myth_timer t[1];
+  struct timespec tp[1];
+  if (myth_desc_is_finished(th)) {
+    myth_desc_wait_finished(th);
+    myth_join_1(env, th, result);
     return 0;
+  }
+  hr_gettime(tp);
+  if (myth_timespec_gt(tp, abstime)) {
+    return ETIMEDOUT;
+  }
+  //Block as myth_join does, with the timer armed
+  myth_desc_set_not_runnable(this_thread);
+  myth_log_add_wait(env, MYTH_LOG_BLOCK, this_thread, (uint64_t)(uintptr_t)th);
+  myth_timer_init(t, abstime, this_thread, myth_timedjoin_withdraw, th);
+  myth_timer_arm(env, t);
+  myth_thread_t next = myth_runq_pop(env);
+  if (next) {
+    next->env = env;
+    myth_swap_context_withcall(&this_thread->context, &next->context,
+			       myth_join_2,
+			       (void*)env, (void*)th, (void*)next);
   } else {
-    struct timespec tp[1];
-    while (1) {
-      int err = hr_gettime(tp);
-      assert(err == 0);
-      if (myth_timespec_gt(tp, abstime)) return EBUSY;
-      if (myth_tryjoin_body(th, result) == 0) {
-	return 0;
-      } else {
-	myth_yield_ex_body(myth_yield_option_local_first);
-      }
-    }
+    myth_swap_context_withcall(&this_thread->context, &env->sched.context,
+			       myth_join_3,
+			       (void*)this_thread, (void*)th, (void*)env);
+  }
+  if (myth_timer_cancel(t)) {
+    return ETIMEDOUT;
   }
+  myth_desc_wait_finished(th);
+  myth_join_1(myth_get_current_env(), th, result);
+  return 0;
 }
 
 /* --------
@@ -853,22 +1002,12 @@ static inline int myth_create_join_many_ex_body(myth_thread_t * ids,
 
 static inline int myth_detach_body(myth_thread_t th)
 {
-  if (th->status==MYTH_STATUS_FREE_READY2){
-    //If a thread is finished, just release resource
-    free_myth_thread_struct_desc(myth_get_current_env(),th);
-    return 0;
-  }
-  //Obtain lock
-  myth_spin_lock_body(&th->lock);
-  if (myth_desc_is_finished(th)){//If a thread is finished, release resource
-    myth_spin_unlock_body(&th->lock);
-    while (th->status!=MYTH_STATUS_FREE_READY2);
+  //Set a thread as detached, unless it is finished
+  if (!myth_desc_set_detached(th)){
+    //If a thread is finished, release resource
+    myth_desc_wait_finished(th);
     free_myth_thread_struct_desc(myth_get_current_env(),th);
   }
-  else{//Set a thread as detached
-    myth_desc_set_detached(th);
-    myth_spin_unlock_body(&th->lock);
-  }
   return 0;
 }
 
@@ -882,6 +1021,12 @@ static inline int myth_thread_attr_init_body(myth_thread_attr_t * attr) {
   attr->detachstate = 0;
   myth_globalattr_get_guardsize_body(0, &attr->guardsize);
   myth_globalattr_get_child_first_body(0, &attr->child_first);
+  attr->priority = 0;
+  attr->on_worker = 0;
+  attr->on_numa_node = 0;
+  attr->pinned = 0;
+  attr->custom_data_size = 0;
+  attr->custom_data = 0;
   return 0;
 }
 
@@ -935,6 +1080,45 @@ static inline int myth_thread_attr_setstack_body(myth_thread_attr_t *attr,
   return 0;
 }
 
+static inline int myth_thread_attr_getpriority_body(const myth_thread_attr_t *attr,
+						    int *priority) {
+  *priority = attr->priority;
+  return 0;
+}
+
+static inline int myth_thread_attr_setpriority_body(myth_thread_attr_t *attr,
+						    int priority) {
+  if (priority < 0 || priority >= MYTH_N_PRIORITIES) return EINVAL;
+  attr->priority = priority;
+  return 0;
+}
+
+static inline int myth_thread_attr_getworker_body(const myth_thread_attr_t *attr,
+						  int *worker) {
+  *worker = attr->on_worker - 1;
+  return 0;
+}
+
+static inline int myth_thread_attr_setworker_body(myth_thread_attr_t *attr,
+						  int worker) {
+  if (worker < -1) return EINVAL;
+  attr->on_worker = worker + 1;
+  return 0;
+}
+
+static inline int myth_thread_attr_getnumanode_body(const myth_thread_attr_t *attr,
+						    int *numa_node) {
+  *numa_node = attr->on_numa_node - 1;
+  return 0;
+}
+
+static inline int myth_thread_attr_setnumanode_body(myth_thread_attr_t *attr,
+						    int numa_node) {
+  if (numa_node < -1) return EINVAL;
+  attr->on_numa_node = numa_node + 1;
+  return 0;
+}
+
 static inline int myth_getattr_default_body(myth_thread_attr_t *attr) {
   return myth_thread_attr_init_body(attr);
 }
@@ -957,7 +1141,7 @@ MYTH_CTX_CALLBACK void myth_yield_ex_1(void * arg1, void * arg2, void * arg3) {
   myth_thread_t this_thread = arg2;
   myth_thread_t next_thread = arg3;
   //Push current thread to the tail of runqueue
-  myth_queue_put(&env->runnable_q, this_thread);
+  myth_runq_put(env, this_thread);
   env->this_thread = next_thread;
   next_thread->env = env;
 }
@@ -973,29 +1157,31 @@ static inline int myth_yield_ex_body(int opt) {
 #if MYTH_YIELD_DEBUG
   myth_dprintf("myth_yield:thread %p yields execution to scheduler\n",th);
 #endif
+  //Threads whose timed wait has expired may be worth yielding to
+  myth_timer_poll(env);
   //Get next runnable thread
   next = NULL;
   switch (opt) {
   case myth_yield_option_half_half: {
     if (myth_random(0, 2) == 0) {
-      next = myth_queue_pop(&env->runnable_q);
+      next = myth_runq_pop(env);
       if (!next) {
 	next = g_myth_steal_func(env->rank);
       }
     } else {
       next = g_myth_steal_func(env->rank);
       if (!next) {
-	next = myth_queue_pop(&env->runnable_q);
+	next = myth_runq_pop(env);
       }
     }
     break;
   }
   case myth_yield_option_local_only: {
-    next = myth_queue_pop(&env->runnable_q);
+    next = myth_runq_pop(env);
     break;
   }
   case myth_yield_option_local_first: {
-    next = myth_queue_pop(&env->runnable_q);
+    next = myth_runq_pop(env);
     if (!next) {
       next = g_myth_steal_func(env->rank);
     }
@@ -1008,7 +1194,7 @@ static inline int myth_yield_ex_body(int opt) {
   case myth_yield_option_steal_first: {
     next = g_myth_steal_func(env->rank);
     if (!next) {
-      next = myth_queue_pop(&env->runnable_q);
+      next = myth_runq_pop(env);
     }
     break;
   }
@@ -1032,19 +1218,45 @@ static inline int myth_yield_body(void) {
   return myth_yield_ex_body(myth_yield_option_half_half);
 }
 
+/* suspend the current thread until abstime */
+static inline void myth_sleep_until(const struct timespec * abstime) {
+  int _ = myth_ensure_init();
+  myth_running_env_t env = myth_get_current_env();
+  myth_thread_t cur = env->this_thread;
+  myth_timer t[1];
+  (void)_;
+  /* next context to run. either another thread
+     or the scheduler */
+  myth_thread_t next;
+  myth_context_t next_ctx;
+  myth_timer_init(t, abstime, cur, 0, 0);
+  myth_timer_arm(env, t);
+  /* the timer is fired only by this worker, which cannot
+     do so before cur's context has been saved below */
+  next = myth_runq_pop(env);
+  env->this_thread = next;
+  if (next) {
+    next->env = env;
+    next_ctx = &next->context;
+  } else {
+    next_ctx = &env->sched.context;
+  }
+  myth_swap_context(&cur->context, next_ctx);
+  myth_timer_cancel(t);
+}
+
 static inline int myth_nanosleep_body(const struct timespec *req,
 				      struct timespec *rem) {
   struct timespec unt[1], cur[1];
-  (void)rem;
   if (req->tv_sec < 0) return EINVAL;
   if (req->tv_nsec < 0) return EINVAL;
   if (req->tv_nsec > 999999999) return EINVAL;
   hr_gettime(cur);
   myth_timespec_add(cur, req, unt);
-  while (1) {
-    hr_gettime(cur);
-    if (myth_timespec_gt(cur, unt)) break;
-    myth_yield_body();
+  myth_sleep_until(unt);
+  if (rem) {
+    rem->tv_sec = 0;
+    rem->tv_nsec = 0;
   }
   return 0;
 }
@@ -1083,7 +1295,12 @@ static void __attribute__((unused)) myth_entry_point(void)
   myth_dprintf("Running thread %p(arg:%p)\n",this_thread,this_thread->arg);
 #endif
   //Execute a thread function
-  this_thread->result=(*(this_thread->entry_func))(this_thread->result);
+  {
+    void * result = (*(this_thread->entry_func))(this_thread->result);
+    //See myth_create_1
+    this_thread = myth_get_current_env_again()->this_thread;
+    this_thread->result = result;
+  }
   myth_entry_point_cleanup(this_thread);
 }
 
@@ -1105,18 +1322,11 @@ MYTH_CTX_CALLBACK void myth_entry_point_1(void *arg1,void *arg2,void *arg3)
 #if MYTH_ENTRY_POINT_DEBUG
     myth_dprintf("Thread %p is detached.Freed resource\n",this_thread);
 #endif
-    myth_spin_unlock_body(&this_thread->lock);
     free_myth_thread_struct_desc(env,this_thread);
   }
   else{
-#if QUICK_CHECK_ON_JOIN
-    this_thread->status = MYTH_STATUS_FREE_READY;
-    myth_spin_unlock_body(&this_thread->lock);
-    this_thread->status = MYTH_STATUS_FREE_READY2;
-#else
-    this_thread->status=MYTH_STATUS_FREE_READY2;
-    myth_spin_unlock_body(&this_thread->lock);
-#endif
+    //Off the stack; the joiner may release it now
+    myth_desc_join_finish(this_thread);
   }
   env->this_thread = next_thread;
 #if MYTH_EP_PROF_DETAIL
@@ -1154,18 +1364,11 @@ MYTH_CTX_CALLBACK void myth_entry_point_2(void *arg1,void *arg2,void *arg3)
 #if MYTH_ENTRY_POINT_DEBUG
     myth_dprintf("Thread %p is detached.Freed resource\n",this_thread);
 #endif
-    myth_spin_unlock_body(&this_thread->lock);
     free_myth_thread_struct_desc(env,this_thread);
   }
   else{
-#if QUICK_CHECK_ON_JOIN
-    this_thread->status=MYTH_STATUS_FREE_READY;
-    myth_spin_unlock_body(&this_thread->lock);
-    this_thread->status=MYTH_STATUS_FREE_READY2;
-#else
-    this_thread->status=MYTH_STATUS_FREE_READY2;
-    myth_spin_unlock_body(&this_thread->lock);
-#endif
+    //Off the stack; the joiner may release it now
+    myth_desc_join_finish(this_thread);
   }
 #if MYTH_EP_PROF_DETAIL
   t1=myth_get_rdtsc();
@@ -1205,8 +1408,10 @@ static inline void myth_entry_point_cleanup(myth_thread_t this_thread) {
   env->prof_data.ep_cycles_tmp = t2;
 #endif
   this_thread_v = this_thread;
-  myth_spin_lock_body(&this_thread->lock);
-  myth_thread_t wait_thread = this_thread_v->join_thread;
+  uintptr_t join_state = myth_desc_join_exit(this_thread_v);
+  this_thread->detached = (join_state == MYTH_JOIN_DETACHED);
+  myth_thread_t wait_thread
+    = (join_state > MYTH_JOIN_FINISHED ? (myth_thread_t)join_state : NULL);
   //Execute a thread waiting for current thread
   if (wait_thread){
 #if MYTH_DEBUG_JOIN_FCC
@@ -1222,19 +1427,21 @@ static inline void myth_entry_point_cleanup(myth_thread_t this_thread) {
     myth_dprintf("Join process completed %p\n",this_thread);
 #endif
 #if SWITCH_AFTER_EXIT
+    //A thread pinned to another worker must go back there
+    if (!wait_thread->pin || wait_thread->pin == env) {
 #if MYTH_EP_PROF_DETAIL
-    t1 = myth_get_rdtsc();
-    env->prof_data.ep_join += t1 - t0;
-    env->prof_data.ep_d_tmp = myth_get_rdtsc();
+      t1 = myth_get_rdtsc();
+      env->prof_data.ep_join += t1 - t0;
+      env->prof_data.ep_d_tmp = myth_get_rdtsc();
+#endif
+      //Execute
+      myth_set_context_withcall(&wait_thread->context,
+				myth_entry_point_1,
+				(void*)env, this_thread, wait_thread);
+    }
 #endif
-    //Execute
-    myth_set_context_withcall(&wait_thread->context,
-			      myth_entry_point_1,
-			      (void*)env, this_thread, wait_thread);
-#else
     //Push to the runqueue
-    myth_queue_push(&env->runnable_q, wait_thread);
-#endif
+    myth_runq_push(env, wait_thread);
   }
 #if MYTH_EP_PROF_DETAIL
   t1 = myth_get_rdtsc();
@@ -1243,7 +1450,7 @@ static inline void myth_entry_point_cleanup(myth_thread_t this_thread) {
 #endif
   
   //Get next runnable thread
-  myth_thread_t next = myth_queue_pop(&env->runnable_q);
+  myth_thread_t next = myth_runq_pop(env);
 
 #if MYTH_EP_PROF_DETAIL
   t1 = myth_get_rdtsc();
@@ -1338,8 +1545,6 @@ static inline void myth_sched_prof_pause_body(void) {
   g_sched_prof=0;
 }
 
-#if 0
-
 //Release the stack of a stolen thread
 static inline void myth_release_stack_body(myth_thread_t th)
 {
@@ -1354,64 +1559,147 @@ static inline void myth_release_desc_body(myth_thread_t th)
   free_myth_thread_struct_desc(e,th);
 }
 
-//Serialize
-static inline void myth_serialize_body(myth_thread_t th,myth_pickle_t p)
+//Address just above the stack of th
+static inline uintptr_t myth_pickle_stack_top(myth_thread_t th)
+{
+  return (uintptr_t)th->stack + sizeof(void*) * 2;
+}
+
+//Bytes of the whole stack of th
+static inline size_t myth_pickle_stack_size(myth_thread_t th)
+{
+  uintptr_t *blk_size = (uintptr_t*)((char*)th->stack + sizeof(void*));
+  return (*blk_size ? *blk_size : g_attr.stacksize);
+}
+
+//Bytes of the stack th uses, from the saved stack pointer to the
+//top. The whole stack if the stack pointer is unknown
+static inline size_t myth_pickle_live_size(myth_thread_t th)
+{
+  uintptr_t top = myth_pickle_stack_top(th);
+  size_t stack_size = myth_pickle_stack_size(th);
+  uintptr_t sp = myth_context_stack_pointer(&th->context);
+  if (sp == 0 || sp > top || top - sp > stack_size) return stack_size;
+  return top - sp;
+}
+
+static inline size_t myth_pickle_size_body(myth_thread_t th)
+{
+  myth_assert(th->stack);
+  return offsetof(struct myth_pickle, live) + myth_pickle_live_size(th);
+}
+
+//Serialize a suspended thread th into p, which has
+//myth_pickle_size_body(th) bytes
+static inline void myth_serialize_body(myth_thread_t th,myth_pickle_t * p)
 {
+  size_t live_size = myth_pickle_live_size(th);
+  uintptr_t top = myth_pickle_stack_top(th);
+  myth_assert(th->stack);
+  p->magic = MYTH_PICKLE_MAGIC;
+  p->version = MYTH_PICKLE_VERSION;
+  p->desc_size = sizeof(struct myth_thread);
+  p->reserved = 0;
+  p->size = offsetof(struct myth_pickle, live) + live_size;
+  p->stack_top = top;
+  p->stack_size = myth_pickle_stack_size(th);
+  p->live_size = live_size;
   //Copy descriptor
-  memcpy(&p->desc,th,sizeof(myth_thread));
-  //スタックをコピー
-  memcpy(&p->stack,(void*)(((char*)th->stack)-(PAGE_ALIGNED_STACK_SIZE-sizeof(void*))),PAGE_ALIGNED_STACK_SIZE);
+  memcpy(&p->desc,th,sizeof(struct myth_thread));
+  //Copy the live part of the stack
+  memcpy(p->live,(void*)(top - live_size),live_size);
 }
 
-//Try de-serialize
-static inline myth_thread_t myth_deserialize_body(myth_pickle_t p)
+//Check if p was made by a compatible myth_serialize
+static inline int myth_pickle_check(myth_pickle_t * p)
+{
+  return p->magic == MYTH_PICKLE_MAGIC
+    && p->version == MYTH_PICKLE_VERSION
+    && p->desc_size == sizeof(struct myth_thread)
+    && p->live_size <= p->stack_size
+    && p->stack_size <= p->stack_top
+    && p->size == offsetof(struct myth_pickle, live) + p->live_size;
+}
+
+//Check p as above, and that the size bytes at p hold all of it
+static inline int myth_pickle_valid_body(myth_pickle_t * p, size_t size)
+{
+  return size >= offsetof(struct myth_pickle, live)
+    && myth_pickle_check(p)
+    && p->size <= size;
+}
+
+//Make the pages of the stack of p accessible at its original address.
+//If addr is not NULL, [addr, addr + size) is a range the caller has
+//reserved for it. Otherwise map the stack, unless something is there.
+//Returns 1 on success
+static inline int myth_pickle_map_stack(myth_pickle_t * p,
+					void * addr, size_t size)
+{
+  uintptr_t lo = (p->stack_top - p->stack_size) & ~((uintptr_t)PAGE_SIZE - 1);
+  uintptr_t hi = PAGE_ALIGN(p->stack_top);
+  if (addr) {
+    if (lo < (uintptr_t)addr || hi - (uintptr_t)addr > size) return 0;
+    return mprotect((void*)lo, hi - lo, PROT_READ|PROT_WRITE) == 0;
+  } else {
+    int flags = MAP_PRIVATE|MYTH_MAP_ANON|MYTH_MAP_STACK;
+    void *stack_ptr;
+#ifdef MAP_FIXED_NOREPLACE
+    flags |= MAP_FIXED_NOREPLACE;
+#endif
+    stack_ptr = mmap((void*)lo, hi - lo, PROT_READ|PROT_WRITE, flags, -1, 0);
+    if (stack_ptr == MAP_FAILED) return 0;
+    if (stack_ptr != (void*)lo) {
+      //Taken by something else
+      myth_munmap(stack_ptr, hi - lo);
+      return 0;
+    }
+    return 1;
+  }
+}
+
+//Fill th from p and copy the live stack back. The stack pages
+//are accessible already
+static inline myth_thread_t myth_pickle_restore(myth_pickle_t * p,
+						myth_thread_t th, int home)
+{
+  uintptr_t join_state = p->desc.join_state;
+  memcpy(th,&p->desc,sizeof(struct myth_thread));
+  memcpy((void*)(uintptr_t)(p->stack_top - p->live_size),p->live,p->live_size);
+  th->next = NULL;
+  th->env = NULL;
+  th->home = home;
+  myth_spin_init_body(&th->lock);
+  //Whoever was joining it stays with the serializer
+  th->join_state = (join_state == MYTH_JOIN_DETACHED
+		    ? MYTH_JOIN_DETACHED : MYTH_JOIN_RUNNING);
+  //Thread-specific data does not move
+  myth_tls_tree_init(th->tls);
+  return th;
+}
+
+//De-serialize at the original address of the stack
+static inline myth_thread_t myth_deserialize_body(myth_pickle_t * p,
+						  void * addr, size_t size)
 {
-  void *stack_ptr;
   myth_running_env_t e;
+  if (!myth_pickle_check(p)) return NULL;
+  if (!myth_pickle_map_stack(p, addr, size)) return NULL;
   e=myth_get_current_env();
-  myth_thread_t ret;
-  //Try to mmap with fixed address
-  void *stack_start_addr;
-  stack_start_addr=(void*)( ((char*)p->desc.stack)-(PAGE_ALIGNED_STACK_SIZE-sizeof(void*)) );
-  stack_ptr = myth_mmap(stack_start_addr, PAGE_ALIGNED_STACK_SIZE, PROT_READ|PROT_WRITE,
-			MAP_PRIVATE|MAP_FIXED|MYTH_MAP_ANON|MYTH_MAP_STACK, -1, 0);
-
-  //Error if allocation fails
-  if (stack_ptr==MAP_FAILED)return NULL;
-  myth_assert(stack_ptr!=p->desc.stack);
   //Allocate a new descriptor
-  ret=get_new_myth_thread_struct_desc(e);
-  //Copy the desctiptor and the stack
-  memcpy(ret,&p->desc,sizeof(myth_thread));
-  memcpy(stack_ptr,p->stack,PAGE_ALIGNED_STACK_SIZE);
-  return ret;
+  return myth_pickle_restore(p, get_new_myth_thread_struct_desc(e), e->rank);
 }
 
-static inline myth_thread_t myth_ext_deserialize_body(myth_pickle_t p)
+static inline myth_thread_t myth_ext_deserialize_body(myth_pickle_t * p,
+						      void * addr, size_t size)
 {
-  void *stack_ptr;
-  MAY_BE_UNUSED myth_running_env_t e;
-  e=myth_get_current_env();
-  myth_thread_t ret;
-  //Try to mmap with fixed address
-  void *stack_start_addr;
-  stack_start_addr=(void*)( ((char*)p->desc.stack)-(PAGE_ALIGNED_STACK_SIZE-sizeof(void*)) );
-
-  stack_ptr = myth_mmap(stack_start_addr, PAGE_ALIGNED_STACK_SIZE, PROT_READ|PROT_WRITE,
-			MAP_PRIVATE|MAP_FIXED|MYTH_MAP_ANON|MYTH_MAP_STACK,-1,0);
-  //Error if allocation fails
-  if (stack_ptr==MAP_FAILED)return NULL;
-  myth_assert(stack_ptr!=p->desc.stack);
+  if (!myth_pickle_check(p)) return NULL;
+  if (!myth_pickle_map_stack(p, addr, size)) return NULL;
   //Allocate a new descriptor
-  ret=get_new_myth_thread_struct_desc_ext();
-  //Copy the desctiptor and the stack
-  memcpy(ret,&p->desc,sizeof(myth_thread));
-  memcpy(stack_ptr,p->stack,PAGE_ALIGNED_STACK_SIZE);
-  return ret;
+  return myth_pickle_restore(p, get_new_myth_thread_struct_desc_ext(),
+			     MYTH_HOME_EXT);
 }
 
-#endif
-
 #include "myth_io_func.h"
 
 #endif /* MYTH_SCHED_FUNC_H_ */
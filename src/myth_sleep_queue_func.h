@@ -110,6 +110,34 @@ static inline myth_sleep_queue_item_t myth_sleep_queue_deq(myth_sleep_queue_t *
   return head;		/* done */
 }
 
+/* remove t from q if t is still in q and pred (if any) agrees,
+   which is called with q locked. returns 1 if t has been removed */
+static inline int myth_sleep_queue_remove(myth_sleep_queue_t * q,
+					  myth_sleep_queue_item_t t,
+					  int (*pred)(void *), void * arg) {
+  int removed = 0;
+  myth_sleep_queue_item_t prev = 0;
+  myth_sleep_queue_item_t x;
+  myth_spin_lock_body(q->ilock);
+  for (x = q->head; x; prev = x, x = x->next) {
+    if (x == t) {
+      if (!pred || pred(arg)) {
+	if (prev) {
+	  prev->next = x->next;
+	} else {
+	  q->head = x->next;
+	}
+	if (q->tail == x) {
+	  q->tail = prev;
+	}
+	removed = 1;
+      }
+      break;
+    }
+  }
+  myth_spin_unlock_body(q->ilock);
+  return removed;
+}
 
 #if 0				/* non-blocking version */
 
@@ -18,6 +18,7 @@
 #include "myth_sleep_queue_func.h"
 #include "myth_sched_func.h"
 #include "myth_spinlock_func.h"
+#include "myth_timer_func.h"
 
 //#define ALIGN_MUTEX
 
@@ -85,7 +86,7 @@ static inline void myth_block_on_queue(myth_sleep_queue_t * q,
   myth_running_env_t env = myth_get_current_env();
   myth_thread_t cur = env->this_thread;
   /* pop next thread to run */
-  myth_thread_t next = myth_queue_pop(&env->runnable_q);
+  myth_thread_t next = myth_runq_pop(env);
   /* next context to run. either another thread
      or the scheduler */
   myth_context_t next_ctx;
@@ -100,6 +101,7 @@ static inline void myth_block_on_queue(myth_sleep_queue_t * q,
   }
   /* now save the current context, myth_sleep_queue_enq_th(q, cur)
      to put cur in the q, and jump to next_ctx */
+  myth_log_add_wait(env, MYTH_LOG_BLOCK, cur, (uint64_t)(uintptr_t)q);
   myth_swap_context_withcall(&cur->context, next_ctx,
 			     myth_block_on_queue_cb, q, cur, m);
 }
@@ -133,7 +135,7 @@ static inline void myth_block_on_stack(myth_sleep_stack_t * s,
   myth_running_env_t env = myth_get_current_env();
   myth_thread_t cur = env->this_thread;
   /* pop next thread to run */
-  myth_thread_t next = myth_queue_pop(&env->runnable_q);
+  myth_thread_t next = myth_runq_pop(env);
   /* next context to run. either another thread
      or the scheduler */
   myth_context_t next_ctx;
@@ -148,10 +150,29 @@ static inline void myth_block_on_stack(myth_sleep_stack_t * s,
   }
   /* now save the current context, myth_sleep_queue_enq_th(q, cur)
      to put cur in the q, and jump to next_ctx */
+  myth_log_add_wait(env, MYTH_LOG_BLOCK, cur, (uint64_t)(uintptr_t)s);
   myth_swap_context_withcall(&cur->context, next_ctx,
 			     myth_block_on_stack_cb, s, cur, m);
 }
 
+/* block the current thread on sleep_queue q as myth_block_on_queue,
+   until abstime. on expiry, the worker's timer takes it out of q
+   with withdraw (see myth_timer.h). returns ETIMEDOUT if the timer
+   has done so, or 0 if woken up by somebody else */
+static inline int myth_block_on_queue_until(myth_sleep_queue_t * q,
+					    myth_mutex_t * m,
+					    const struct timespec * abstime,
+					    int (*withdraw)(myth_timer_t),
+					    void * arg) {
+  myth_running_env_t env = myth_get_current_env();
+  myth_timer t[1];
+  myth_timer_init(t, abstime, env->this_thread, withdraw, arg);
+  /* the timer is fired only by this worker, which cannot do so
+     before the callback of myth_block_on_queue has put us in q */
+  myth_timer_arm(env, t);
+  myth_block_on_queue(q, m);
+  return myth_timer_cancel(t) ? ETIMEDOUT : 0;
+}
 
 typedef void * (*callback_on_wakeup_t)(void *);
 
@@ -191,7 +212,7 @@ static inline int myth_wake_one_from_queue(myth_sleep_queue_t * q,
     callback(arg);
   }
   /* put the thread to wake up in run queue */
-  myth_queue_push(&env->runnable_q, to_wake);
+  myth_runq_push(env, to_wake);
   return 1;
 }
 
@@ -271,7 +292,7 @@ static inline int myth_wake_many_from_queue(myth_sleep_queue_t * q,
   for (i = 0; i < n; i++) {
     assert(to_wake);
     myth_thread_t next = to_wake->next;
-    myth_queue_push(&env->runnable_q, to_wake);
+    myth_runq_push(env, to_wake);
     to_wake = next;
   }
   return n;
@@ -293,7 +314,7 @@ static inline int myth_wake_if_any_from_queue(myth_sleep_queue_t * q,
     callback(arg);
   }
   /* put the thread that just woke up to the run queue */
-  myth_queue_push(&env->runnable_q, to_wake);
+  myth_runq_push(env, to_wake);
   return 1;			/* I woke up one */
 }
 
@@ -385,7 +406,7 @@ static inline int myth_wake_many_from_stack(myth_sleep_stack_t * s,
   for (i = 0; i < n; i++) {
     assert(to_wake);
     myth_thread_t next = to_wake->next;
-    myth_queue_push(&env->runnable_q, to_wake);
+    myth_runq_push(env, to_wake);
     to_wake = next;
   }
   return n;
@@ -450,7 +471,6 @@ static inline int myth_mutex_destroy_body(myth_mutex_t * mutex)
 }
 
 static inline int myth_mutex_trylock_body(myth_mutex_t * mutex) {
-  /* TODO: spin block */
   while (1) {
     long s = mutex->state;
     /* check the lock bit */
@@ -497,16 +517,38 @@ static inline int myth_mutex_trylock_body(myth_mutex_t * mutex) {
    1 : lock is held; no one in the queue
    2 : lock is free; some in the queue
    3 : lock is held; some in the queue
+
+   the top bits below the sign bit hold the spin count an adaptive
+   mutex expects to need (MYTH_MUTEX_ADAPTIVE). they are updated only
+   by the CAS that sets the lock bit, so the rest of the code can keep
+   adding/subtracting 1 and 2 to/from the state.
  */
-static inline int myth_mutex_lock_body(myth_mutex_t * mutex) {
-  /* TODO: spin block */
+#define MYTH_MUTEX_SPIN_SHIFT (sizeof(long) * 8 - 9)
+#define MYTH_MUTEX_SPIN_MASK (0xffL << MYTH_MUTEX_SPIN_SHIFT)
+
+#if MYTH_MUTEX_SPIN_MAX > 0xff
+#error "MYTH_MUTEX_SPIN_MAX must fit in MYTH_MUTEX_SPIN_MASK"
+#endif
+
+static inline int myth_mutex_spins(long s) {
+  return (s & MYTH_MUTEX_SPIN_MASK) >> MYTH_MUTEX_SPIN_SHIFT;
+}
+
+static inline long myth_mutex_set_spins(long s, int spins) {
+  return (s & ~MYTH_MUTEX_SPIN_MASK) | ((long)spins << MYTH_MUTEX_SPIN_SHIFT);
+}
+
+/* the lock loop; once the lock bit is set, the spin
+   estimate becomes spins unless it is negative */
+static inline int myth_mutex_lock_block(myth_mutex_t * mutex, int spins) {
   while (1) {
     long s = mutex->state;
     assert(s >= 0);
     /* check lock bit */
     if ((s & 1) == 0) {
       /* lock bit clear -> try to become the one who set it */
-      if (__sync_bool_compare_and_swap(&mutex->state, s, s + 1)) {
+      long t = (spins < 0 ? s + 1 : myth_mutex_set_spins(s + 1, spins));
+      if (__sync_bool_compare_and_swap(&mutex->state, s, t)) {
 	break;
       }
     } else {
@@ -523,28 +565,91 @@ static inline int myth_mutex_lock_body(myth_mutex_t * mutex) {
   }
   return 0;
 }
+
+/* spin up to twice the expected count (plus some) before blocking,
+   and move the expectation 1/8 of the way to what this call needed,
+   as glibc does for PTHREAD_MUTEX_ADAPTIVE_NP. spinning makes no
+   sense with a single worker, as the holder cannot run meanwhile */
+static inline int myth_mutex_lock_adaptive_body(myth_mutex_t * mutex) {
+  long s = mutex->state;
+  int spins, max_cnt, cnt;
+  if ((s & 1) == 0 && __sync_bool_compare_and_swap(&mutex->state, s, s + 1)) {
+    return 0;
+  }
+  if (g_attr.n_workers <= 1) {
+    return myth_mutex_lock_block(mutex, -1);
+  }
+  spins = myth_mutex_spins(s);
+  max_cnt = spins * 2 + 10;
+  if (max_cnt > MYTH_MUTEX_SPIN_MAX) max_cnt = MYTH_MUTEX_SPIN_MAX;
+  for (cnt = 1; cnt <= max_cnt; cnt++) {
+    myth_spin_pause();
+    s = mutex->state;
+    if ((s & 1) == 0) {
+      int t = spins + (cnt - spins) / 8;
+      if (__sync_bool_compare_and_swap(&mutex->state, s,
+				       myth_mutex_set_spins(s + 1, t))) {
+	return 0;
+      }
+    }
+  }
+  return myth_mutex_lock_block(mutex, spins + (max_cnt - spins) / 8);
+}
+
+static inline int myth_mutex_lock_body(myth_mutex_t * mutex) {
+  if (mutex->attr.type == MYTH_MUTEX_ADAPTIVE) {
+    return myth_mutex_lock_adaptive_body(mutex);
+  }
+  return myth_mutex_lock_block(mutex, -1);
+}
   
+/* take the thread of a timedlock off the queue, if its seat
+   in the queue has not been claimed by an unlocker yet.
+   called with mutex->sleep_q locked, with the thread in it.
+   the thread's seat (2 in state) is either still there, or
+   claimed by an unlocker that is going to dequeue a thread,
+   which is this one if no seat is left */
+static inline int myth_mutex_claim_seat(void * mutex_) {
+  myth_mutex_t * mutex = mutex_;
+  while (1) {
+    long s = mutex->state;
+    if (!(s & ~(MYTH_MUTEX_SPIN_MASK | 1))) {
+      return 0;
+    }
+    if (__sync_bool_compare_and_swap(&mutex->state, s, s - 2)) {
+      return 1;
+    }
+  }
+}
+
+static inline int myth_mutex_withdraw(myth_timer_t t) {
+  myth_mutex_t * mutex = t->arg;
+  return myth_sleep_queue_remove(mutex->sleep_q,
+				 (myth_sleep_queue_item_t)t->th,
+				 myth_mutex_claim_seat, mutex);
+}
+
 /* timedlock
-   the current implementation repeats trylock and then yield,
-   until it succeds trylock.
-   we want to make it block on the mutex, so that it will
-   promptly wake up when the mutex is unlocked.
-*/
+   as lock, but the thread blocks with a timer that takes it
+   off the queue at abstime */
 static inline int
 myth_mutex_timedlock_body(myth_mutex_t * mutex,
 			  const struct timespec *restrict abstime) {
-  if (myth_mutex_trylock_body(mutex) == 0) {
-    return 0;
-  } else {
-    struct timespec tp[1];
-    while (1) {
-      int err = hr_gettime(tp);
-      assert(err == 0);
-      if (myth_timespec_gt(tp, abstime)) return ETIMEDOUT;
-      if (myth_mutex_trylock_body(mutex) == 0) {
+  struct timespec tp[1];
+  while (1) {
+    long s = mutex->state;
+    if ((s & 1) == 0) {
+      if (__sync_bool_compare_and_swap(&mutex->state, s, s + 1)) {
 	return 0;
-      } else {
-	myth_yield_ex_body(myth_yield_option_local_first);
+      }
+      continue;
+    }
+    hr_gettime(tp);
+    if (myth_timespec_gt(tp, abstime)) return ETIMEDOUT;
+    if (__sync_bool_compare_and_swap(&mutex->state, s, s + 2)) {
+      if (myth_block_on_queue_until(mutex->sleep_q, 0, abstime,
+				    myth_mutex_withdraw, mutex) == ETIMEDOUT) {
+	return ETIMEDOUT;
       }
     }
   }
@@ -574,7 +679,7 @@ static inline int myth_mutex_unlock_body(myth_mutex_t * mutex) {
 	 show more useful info */
       exit(1);
     }
-    if (s > 1) {
+    if (s & ~(MYTH_MUTEX_SPIN_MASK | 1)) {
       /* some threads are blocked (or just have decided to block) 
 	 on the queue. decrement it (while still keeping the lock bit)
 	 wake up one, and then clear the lock bit */
@@ -586,8 +691,7 @@ static inline int myth_mutex_unlock_body(myth_mutex_t * mutex) {
       }
     } else {
       /* nobody waiting. clear the lock bit and done */
-      assert(s == 1);
-      if (__sync_bool_compare_and_swap(&mutex->state, 1, 0)) {
+      if (__sync_bool_compare_and_swap(&mutex->state, s, s - 1)) {
 	break;
       }
     }
@@ -622,9 +726,66 @@ myth_mutexattr_settype_body(myth_mutexattr_t *attr, int type) {
 
 /* ----------- reader-writer lock ----------- */
 
-static inline int unimplemented(void) {
-  assert(0);
-  return -1;
+/* 
+   state of a reader-writer lock
+
+   bit 0      : a writer holds the lock
+   bit 1      : a writer is waiting for readers of a read-mostly
+                lock to leave, after which it holds the lock
+   bits 2-21  : number of readers holding the lock
+                (always zero for a read-mostly lock, whose readers
+                are counted in reader_count)
+   bits 22-42 : number of writers blocked (or about to block) in sleep_q
+   bits 43-62 : number of readers blocked (or about to block) in sleep_s
+
+   when the lock is released and some threads are blocked, the
+   unlocker hands the lock over to them (sets the writer bit or
+   counts them as readers) before waking them up, so a thread
+   that wakes up always holds the lock.
+ */
+#define MYTH_RWLOCK_WRITER       (1L << 0)
+#define MYTH_RWLOCK_DRAINING     (1L << 1)
+#define MYTH_RWLOCK_READER       (1L << 2)
+#define MYTH_RWLOCK_WAIT_WRITER  (1L << 22)
+#define MYTH_RWLOCK_WAIT_READER  (1L << 43)
+
+static inline long myth_rwlock_n_readers(long s) {
+  return (s >> 2) & ((1L << 20) - 1);
+}
+
+static inline long myth_rwlock_n_wait_writers(long s) {
+  return (s >> 22) & ((1L << 21) - 1);
+}
+
+static inline long myth_rwlock_n_wait_readers(long s) {
+  return (s >> 43) & ((1L << 20) - 1);
+}
+
+/* a per-worker reader counter of a read-mostly lock.
+   a reader increments the counter of the worker it locks on
+   and decrements that of the worker it unlocks on, so only
+   the sum over workers is meaningful. one more entry follows
+   the last worker's, whose drainer is the writer blocked until
+   readers leave (see myth_rwlock_drain_readers) */
+struct myth_rwlock_reader_count {
+  volatile long n;
+  myth_thread_t volatile drainer;
+} __attribute__((aligned(CACHE_LINE_SIZE)));
+
+static inline int myth_rwlock_prefer_writer(myth_rwlock_t * rwlock) {
+  return rwlock->attr.kind == MYTH_RWLOCK_PREFER_WRITER_NONRECURSIVE;
+}
+
+static inline volatile long * myth_rwlock_my_reader_count(myth_rwlock_t * rwlock) {
+  myth_running_env_t env = myth_get_current_env();
+  return &rwlock->reader_count[env->rank].n;
+}
+
+/* 1 if a reader may enter the lock in state s now */
+static inline int myth_rwlock_can_read(myth_rwlock_t * rwlock, long s) {
+  if (s & (MYTH_RWLOCK_WRITER | MYTH_RWLOCK_DRAINING)) return 0;
+  if (myth_rwlock_prefer_writer(rwlock) && myth_rwlock_n_wait_writers(s)) return 0;
+  return 1;
 }
 
 static inline int
@@ -634,12 +795,23 @@ static inline int
 myth_rwlock_init_body(myth_rwlock_t *restrict rwlock,
 		      const myth_rwlockattr_t *restrict attr) {
   myth_sleep_queue_init(rwlock->sleep_q);
+  myth_sleep_stack_init(rwlock->sleep_s);
   rwlock->state = 0;
   if (attr) {
     rwlock->attr = *attr;
   } else {
     myth_rwlockattr_init_body(&rwlock->attr);
   }
+  rwlock->reader_count = 0;
+  if (rwlock->attr.read_mostly) {
+    int _ = myth_ensure_init();
+    void * p = 0;
+    size_t sz = sizeof(struct myth_rwlock_reader_count) * (g_attr.n_workers + 1);
+    (void)_;
+    if (real_posix_memalign(&p, CACHE_LINE_SIZE, sz) != 0) return ENOMEM;
+    memset(p, 0, sz);
+    rwlock->reader_count = p;
+  }
   return 0;
 }
 // myth_rwlock_t rwlock = MYTH_RWLOCK_INITIALIZER;
@@ -647,71 +819,356 @@ myth_rwlock_init_body(myth_rwlock_t *restrict rwlock,
 static inline int
 myth_rwlock_destroy_body(myth_rwlock_t *rwlock) {
   myth_sleep_queue_destroy(rwlock->sleep_q);
+  myth_sleep_stack_destroy(rwlock->sleep_s);
+  if (rwlock->reader_count) {
+    myth_free(rwlock->reader_count);
+    rwlock->reader_count = 0;
+  }
   return 0;
 }
 
+/* sum of the reader counters of a read-mostly lock */
+static inline long myth_rwlock_count_readers(myth_rwlock_t *rwlock) {
+  long n = 0;
+  int i;
+  for (i = 0; i < g_attr.n_workers; i++) {
+    n += rwlock->reader_count[i].n;
+  }
+  return n;
+}
+
+static inline myth_thread_t volatile * myth_rwlock_drainer(myth_rwlock_t *rwlock) {
+  return &rwlock->reader_count[g_attr.n_workers].drainer;
+}
+
+/* called by a reader of a read-mostly lock right after it has
+   decremented its counter, when it has seen the draining bit.
+   readers cannot tell if they are the last one, so whoever sees
+   a blocked drainer and no readers wakes it (see
+   myth_rwlock_drain_readers for the other side) */
+static inline void myth_rwlock_wake_drainer(myth_rwlock_t *rwlock) {
+  myth_thread_t volatile * d = myth_rwlock_drainer(rwlock);
+  myth_thread_t th = *d;
+  if (th && myth_rwlock_count_readers(rwlock) == 0
+      && __sync_bool_compare_and_swap(d, th, 0)) {
+    myth_running_env_t env = myth_get_current_env();
+    th->env = env;
+    myth_runq_push(env, th);
+  }
+}
+
+/* read-lock a read-mostly lock. the fast path only touches
+   the counter of this worker and reads the state */
+static inline int
+myth_rwlock_rdlock_read_mostly(myth_rwlock_t *rwlock, int try_only) {
+  volatile long * c = myth_rwlock_my_reader_count(rwlock);
+  while (1) {
+    /* announce first, then check for a writer. a writer sets
+       its bit first and then sums the counters, so either
+       I see the bit or it sees my count (both are full barriers) */
+    __sync_fetch_and_add(c, 1);
+    long s = rwlock->state;
+    if (!(s & (MYTH_RWLOCK_WRITER | MYTH_RWLOCK_DRAINING))) {
+      return 0;
+    }
+    __sync_fetch_and_sub(c, 1);
+    /* my count may have kept the drainer from being woken up */
+    if (s & MYTH_RWLOCK_DRAINING) myth_rwlock_wake_drainer(rwlock);
+    if (try_only) return EBUSY;
+    if (__sync_bool_compare_and_swap(&rwlock->state, s,
+				     s + MYTH_RWLOCK_WAIT_READER)) {
+      myth_block_on_stack(rwlock->sleep_s, 0);
+      /* the writer that unlocked counted me as a reader */
+      return 0;
+    }
+  }
+}
+
 /* read-lock a reader-writer lock */
 static inline int
 myth_rwlock_rdlock_body(myth_rwlock_t *rwlock) {
-  (void)rwlock;
-  unimplemented();
-  return 0;
+  if (rwlock->reader_count) {
+    return myth_rwlock_rdlock_read_mostly(rwlock, 0);
+  }
+  while (1) {
+    long s = rwlock->state;
+    if (myth_rwlock_can_read(rwlock, s)) {
+      if (__sync_bool_compare_and_swap(&rwlock->state, s,
+				       s + MYTH_RWLOCK_READER)) {
+	return 0;
+      }
+    } else if (__sync_bool_compare_and_swap(&rwlock->state, s,
+					    s + MYTH_RWLOCK_WAIT_READER)) {
+      /* reserved a seat in sleep_s; whoever hands the lock to
+	 readers will wait for me to be in it */
+      myth_block_on_stack(rwlock->sleep_s, 0);
+      /* the unlocker counted me as a reader */
+      return 0;
+    }
+  }
 }
 
 /* try to read-lock a reader-writer lock */
 static inline int
 myth_rwlock_tryrdlock_body(myth_rwlock_t *rwlock) {
-  (void)rwlock;
-  unimplemented();
-  return 0;
+  if (rwlock->reader_count) {
+    return myth_rwlock_rdlock_read_mostly(rwlock, 1);
+  }
+  while (1) {
+    long s = rwlock->state;
+    if (!myth_rwlock_can_read(rwlock, s)) {
+      return EBUSY;
+    } else if (__sync_bool_compare_and_swap(&rwlock->state, s,
+					    s + MYTH_RWLOCK_READER)) {
+      return 0;
+    }
+  }
+}
+
+/* repeat trylock until abstime, sleeping in between.
+   waiters are granted the lock by the unlocker (see
+   myth_rwlock_unlock_writer), which leaves no way to take
+   a thread off the wait, so timed waits do not enter it */
+static inline int
+myth_rwlock_timedlock(myth_rwlock_t *restrict rwlock,
+		      const struct timespec *restrict abstime,
+		      int (*trylock)(myth_rwlock_t *)) {
+  struct timespec tp[1], unt[1];
+  struct timespec d[1] = { { 0, MYTH_TIMER_TICK_NS } };
+  while (1) {
+    if (trylock(rwlock) == 0) return 0;
+    int err = hr_gettime(tp);
+    assert(err == 0);
+    (void)err;
+    if (myth_timespec_gt(tp, abstime)) return ETIMEDOUT;
+    myth_timespec_add(tp, d, unt);
+    myth_sleep_until(myth_timespec_gt(unt, abstime) ? abstime : unt);
+    if (d->tv_nsec < MYTH_RWLOCK_TIMED_SLEEP_MAX_NS) {
+      d->tv_nsec *= 2;
+    }
+  }
 }
 
 /* try to read-lock a reader-writer lock with time out */
 static inline int
 myth_rwlock_timedrdlock_body(myth_rwlock_t *restrict rwlock,
 			     const struct timespec *restrict abstime) {
-  (void)rwlock;
-  (void)abstime;
-  unimplemented();
-  return 0;
+  return myth_rwlock_timedlock(rwlock, abstime, myth_rwlock_tryrdlock_body);
+}
+
+/* called back after the drainer has saved its context (see
+   myth_block_on_queue_cb). publish it, then recheck the readers;
+   the atomic decrement of a leaving reader and the barrier here
+   make sure either it or we see the other, and the CAS on
+   drainer decides who puts it back to the run queue */
+MYTH_CTX_CALLBACK void myth_rwlock_drain_cb(void *arg1,void *arg2,void *arg3) {
+  myth_rwlock_t * rwlock = arg1;
+  myth_thread_t cur = arg2;
+  myth_thread_t volatile * d = myth_rwlock_drainer(rwlock);
+  (void)arg3;
+  *d = cur;
+  __sync_synchronize();
+  if (myth_rwlock_count_readers(rwlock) == 0
+      && __sync_bool_compare_and_swap(d, cur, 0)) {
+    myth_runq_push(myth_get_current_env(), cur);
+  }
+}
+
+/* block the current thread, the drainer of rwlock, until
+   a leaving reader finds no readers left */
+static inline void myth_rwlock_block_drainer(myth_rwlock_t *rwlock) {
+  myth_running_env_t env = myth_get_current_env();
+  myth_thread_t cur = env->this_thread;
+  myth_thread_t next = myth_runq_pop(env);
+  myth_context_t next_ctx;
+  env->this_thread = next;
+  if (next) {
+    next->env = env;
+    next_ctx = &next->context;
+  } else {
+    next_ctx = &env->sched.context;
+  }
+  myth_log_add_wait(env, MYTH_LOG_BLOCK, cur, (uint64_t)(uintptr_t)rwlock);
+  myth_swap_context_withcall(&cur->context, next_ctx,
+			     myth_rwlock_drain_cb, rwlock, cur, 0);
+}
+
+/* called by the writer that has set the draining bit of
+   a read-mostly lock. new readers see the bit and block,
+   so wait for readers in the critical section to leave.
+   no reader enters while the bit is set, so once woken
+   up the drainer has no readers left to wait for */
+static inline void myth_rwlock_drain_readers(myth_rwlock_t *rwlock) {
+  if (myth_rwlock_count_readers(rwlock)) {
+    myth_rwlock_block_drainer(rwlock);
+  }
+  __sync_fetch_and_add(&rwlock->state,
+		       MYTH_RWLOCK_WRITER - MYTH_RWLOCK_DRAINING);
 }
 
 /* write-lock a reader-writer lock */
 static inline int
 myth_rwlock_wrlock_body(myth_rwlock_t *rwlock) {
-  (void)rwlock;
-  unimplemented();
-  return 0;
+  while (1) {
+    long s = rwlock->state;
+    if (!(s & (MYTH_RWLOCK_WRITER | MYTH_RWLOCK_DRAINING))
+	&& myth_rwlock_n_readers(s) == 0) {
+      if (rwlock->reader_count) {
+	if (__sync_bool_compare_and_swap(&rwlock->state, s,
+					 s | MYTH_RWLOCK_DRAINING)) {
+	  myth_rwlock_drain_readers(rwlock);
+	  return 0;
+	}
+      } else if (__sync_bool_compare_and_swap(&rwlock->state, s,
+					      s | MYTH_RWLOCK_WRITER)) {
+	return 0;
+      }
+    } else if (__sync_bool_compare_and_swap(&rwlock->state, s,
+					    s + MYTH_RWLOCK_WAIT_WRITER)) {
+      myth_block_on_queue(rwlock->sleep_q, 0);
+      /* the unlocker set the writer bit for me, or, for a
+	 read-mostly lock, may have set the draining bit */
+      if (rwlock->state & MYTH_RWLOCK_DRAINING) {
+	myth_rwlock_drain_readers(rwlock);
+      }
+      return 0;
+    }
+  }
 }
 
+static inline int myth_rwlock_unlock_writer(myth_rwlock_t *rwlock,
+					    long s, long bit);
+
 /* try to write-lock a reader-writer lock */
 static inline int
 myth_rwlock_trywrlock_body(myth_rwlock_t *rwlock) {
-  (void)rwlock;
-  unimplemented();
-  return 0;
+  while (1) {
+    long s = rwlock->state;
+    if ((s & (MYTH_RWLOCK_WRITER | MYTH_RWLOCK_DRAINING))
+	|| myth_rwlock_n_readers(s)) {
+      return EBUSY;
+    }
+    if (!rwlock->reader_count) {
+      if (__sync_bool_compare_and_swap(&rwlock->state, s,
+				       s | MYTH_RWLOCK_WRITER)) {
+	return 0;
+      }
+    } else if (__sync_bool_compare_and_swap(&rwlock->state, s,
+					    s | MYTH_RWLOCK_DRAINING)) {
+      if (myth_rwlock_count_readers(rwlock) == 0) {
+	__sync_fetch_and_add(&rwlock->state,
+			     MYTH_RWLOCK_WRITER - MYTH_RWLOCK_DRAINING);
+	return 0;
+      }
+      /* readers are in; back off, letting in those who
+	 blocked meanwhile */
+      while (!myth_rwlock_unlock_writer(rwlock, rwlock->state,
+					MYTH_RWLOCK_DRAINING)) { }
+      return EBUSY;
+    }
+  }
 }
 
 /* try to write-lock a reader-writer lock with timeout */
 static inline int
 myth_rwlock_timedwrlock_body(myth_rwlock_t *restrict rwlock,
 			     const struct timespec *restrict abstime) {
-  (void)rwlock;
-  (void)abstime;
-  unimplemented();
-  return 0;
+  return myth_rwlock_timedlock(rwlock, abstime, myth_rwlock_trywrlock_body);
+}
+
+/* release the writer bit (or the draining bit of a read-mostly
+   lock; see trywrlock) in state s. returns 0 if the state has
+   changed meanwhile */
+static inline int myth_rwlock_unlock_writer(myth_rwlock_t *rwlock,
+					    long s, long bit) {
+  long n_r = myth_rwlock_n_wait_readers(s);
+  long n_w = myth_rwlock_n_wait_writers(s);
+  assert(s & bit);
+  if (n_w && (!n_r || myth_rwlock_prefer_writer(rwlock))) {
+    /* hand the lock to a blocked writer, keeping the bit */
+    if (!__sync_bool_compare_and_swap(&rwlock->state, s,
+				      s - MYTH_RWLOCK_WAIT_WRITER)) {
+      return 0;
+    }
+    myth_wake_one_from_queue(rwlock->sleep_q, 0, 0);
+  } else if (n_r) {
+    /* let all blocked readers in */
+    long t = s - bit - n_r * MYTH_RWLOCK_WAIT_READER;
+    volatile long * c = 0;
+    if (rwlock->reader_count) {
+      /* count them before clearing the bit, so that a
+	 writer draining readers sees them */
+      c = myth_rwlock_my_reader_count(rwlock);
+      __sync_fetch_and_add(c, n_r);
+      if (n_w) {
+	/* readers of a read-mostly lock cannot tell if they are
+	   the last one, so hand the lock to a writer right now;
+	   it waits for these readers to leave */
+	t = t + MYTH_RWLOCK_DRAINING - MYTH_RWLOCK_WAIT_WRITER;
+      }
+    } else {
+      t += n_r * MYTH_RWLOCK_READER;
+    }
+    if (!__sync_bool_compare_and_swap(&rwlock->state, s, t)) {
+      if (c) __sync_fetch_and_sub(c, n_r);
+      return 0;
+    }
+    myth_wake_many_from_stack(rwlock->sleep_s, 0, 0, n_r);
+    if (c && n_w) {
+      myth_wake_one_from_queue(rwlock->sleep_q, 0, 0);
+    }
+  } else if (!__sync_bool_compare_and_swap(&rwlock->state, s, s - bit)) {
+    return 0;
+  }
+  return 1;
+}
+
+/* unlock held by a reader */
+static inline int myth_rwlock_unlock_reader(myth_rwlock_t *rwlock, long s) {
+  long n = myth_rwlock_n_readers(s);
+  if (n == 1 && myth_rwlock_n_wait_writers(s)) {
+    /* the last reader hands the lock to a blocked writer */
+    if (!__sync_bool_compare_and_swap(&rwlock->state, s,
+				      s - MYTH_RWLOCK_READER
+				      - MYTH_RWLOCK_WAIT_WRITER
+				      + MYTH_RWLOCK_WRITER)) {
+      return 0;
+    }
+    myth_wake_one_from_queue(rwlock->sleep_q, 0, 0);
+    return 1;
+  } else {
+    /* readers block only while a writer holds or waits for 
+       the lock, so nobody else needs waking up */
+    return __sync_bool_compare_and_swap(&rwlock->state, s,
+					s - MYTH_RWLOCK_READER);
+  }
 }
 
 static inline int
 myth_rwlock_unlock_body(myth_rwlock_t *rwlock) {
-  (void)rwlock;
-  unimplemented();
-  return 0;
+  while (1) {
+    long s = rwlock->state;
+    if (s & MYTH_RWLOCK_WRITER) {
+      if (myth_rwlock_unlock_writer(rwlock, s, MYTH_RWLOCK_WRITER)) return 0;
+    } else if (rwlock->reader_count) {
+      __sync_fetch_and_sub(myth_rwlock_my_reader_count(rwlock), 1);
+      if (rwlock->state & MYTH_RWLOCK_DRAINING) {
+	myth_rwlock_wake_drainer(rwlock);
+      }
+      return 0;
+    } else if (myth_rwlock_n_readers(s) == 0) {
+      /* not locked */
+      return EPERM;
+    } else {
+      if (myth_rwlock_unlock_reader(rwlock, s)) return 0;
+    }
+  }
 }
 
 static inline int
 myth_rwlockattr_init_body(myth_rwlockattr_t *attr) {
-  attr->kind = MYTH_RWLOCK_PREFER_READER;
+  attr->kind = MYTH_RWLOCK_DEFAULT;
+  attr->read_mostly = 0;
   return 0;
 }
 
@@ -733,6 +1190,20 @@ myth_rwlockattr_setkind_body(myth_rwlockattr_t *attr, int pref) {
   return 0;
 }
 
+static inline int
+myth_rwlockattr_getreadmostly_body(const myth_rwlockattr_t *attr,
+				   int *read_mostly) {
+  *read_mostly = attr->read_mostly;
+  return 0;
+}
+
+static inline int
+myth_rwlockattr_setreadmostly_body(myth_rwlockattr_t *attr,
+				   int read_mostly) {
+  attr->read_mostly = (read_mostly != 0);
+  return 0;
+}
+
 /* ----------- condition variable ----------- */
 
 static inline int
@@ -769,15 +1240,19 @@ static inline int myth_cond_wait_body(myth_cond_t * cond, myth_mutex_t * mutex)
   return myth_mutex_lock(mutex);
 }
 
+static inline int myth_cond_withdraw(myth_timer_t t) {
+  myth_cond_t * cond = t->arg;
+  return myth_sleep_queue_remove(cond->sleep_q,
+				 (myth_sleep_queue_item_t)t->th, 0, 0);
+}
+
 static inline int
 myth_cond_timedwait_body(myth_cond_t * cond, myth_mutex_t * mutex,
 			 const struct timespec *restrict abstime) {
-  (void)cond;
-  (void)mutex;
-  (void)abstime;
-  unimplemented();
-  myth_block_on_queue(cond->sleep_q, mutex);
-  return myth_mutex_lock(mutex);
+  int ret = myth_block_on_queue_until(cond->sleep_q, mutex, abstime,
+				      myth_cond_withdraw, cond);
+  int err = myth_mutex_lock(mutex);
+  return (err ? err : ret);
 }
 
 static inline int
@@ -1035,7 +1510,7 @@ static inline int myth_uncond_wait_body(myth_uncond_t * u) {
   myth_running_env_t env = myth_get_current_env();
   myth_thread_t cur = env->this_thread;
   /* pop next thread to run */
-  myth_thread_t next = myth_queue_pop(&env->runnable_q);
+  myth_thread_t next = myth_runq_pop(env);
   /* next context to run. either another thread
      or the scheduler */
   myth_context_t next_ctx;
@@ -1050,6 +1525,7 @@ static inline int myth_uncond_wait_body(myth_uncond_t * u) {
   }
   /* now save the current context, myth_sleep_queue_enq_th(q, cur)
      to put cur in the q, and jump to next_ctx */
+  myth_log_add_wait(env, MYTH_LOG_BLOCK, cur, (uint64_t)(uintptr_t)u);
   myth_swap_context_withcall(&cur->context, next_ctx,
 			     myth_uncond_wait_cb, u, cur, 0);
   return 0;
@@ -1063,8 +1539,143 @@ static inline int myth_uncond_signal_body(myth_uncond_t * u) {
   }
   to_wake->env = env;
   u->th = 0;
-  myth_queue_push(&env->runnable_q, to_wake);
+  myth_runq_push(env, to_wake);
   return 0;
 }
 
+/* ----------- future ----------- */
+
+/* state of a future: myth_future_set (or myth_future_claim)
+   claims it by setting MYTH_FUTURE_SET and marks the value
+   MYTH_FUTURE_READY after writing it (myth_future_publish).
+   the rest counts threads that announced they are sleeping
+   in myth_future_get */
+#define MYTH_FUTURE_SET 1L
+#define MYTH_FUTURE_READY 2L
+#define MYTH_FUTURE_WAITER 4L
+
+/* conts of a future whose continuations have been taken
+   by myth_future_set */
+#define MYTH_FUTURE_CONTS_DONE ((myth_future_cont_t *)1)
+
+static inline void * myth_future_value_body(myth_future_t * f) {
+  if (f->size <= MYTH_FUTURE_INLINE_SIZE) {
+    return f->value.buf;
+  } else {
+    return f->value.ptr;
+  }
+}
+
+static inline int myth_future_init_body(myth_future_t * f, size_t size) {
+  f->state = 0;
+  myth_sleep_queue_init(f->sleep_q);
+  f->conts = 0;
+  f->size = size;
+  if (size > MYTH_FUTURE_INLINE_SIZE) {
+    f->value.ptr = myth_malloc(size);
+  }
+  return 0;
+}
+
+static inline int myth_future_destroy_body(myth_future_t * f) {
+  myth_sleep_queue_destroy(f->sleep_q);
+  if (f->size > MYTH_FUTURE_INLINE_SIZE) {
+    myth_free(f->value.ptr);
+  }
+  return 0;
+}
+
+static inline int myth_future_ready_body(myth_future_t * f) {
+  return (f->state & MYTH_FUTURE_READY) != 0;
+}
+
+static inline int myth_future_get_body(myth_future_t * f, void * value) {
+  while (1) {
+    long s = f->state;
+    if (s & MYTH_FUTURE_READY) {
+      break;
+    }
+    /* try to indicate I am going to sleep. myth_future_set
+       wakes up as many threads as it sees here */
+    if (__sync_bool_compare_and_swap(&f->state, s, s + MYTH_FUTURE_WAITER)) {
+      myth_block_on_queue(f->sleep_q, 0);
+      break;
+    }
+  }
+  myth_rbarrier();
+  if (value) {
+    memcpy(value, myth_future_value_body(f), f->size);
+  }
+  return 0;
+}
+
+static inline int myth_future_claim_body(myth_future_t * f) {
+  if (__sync_fetch_and_or(&f->state, MYTH_FUTURE_SET) & MYTH_FUTURE_SET) {
+    return EBUSY;
+  }
+  return 0;
+}
+
+static inline int myth_future_publish_body(myth_future_t * f) {
+  myth_future_cont_t * c;
+  myth_future_cont_t * rev = 0;
+  long s, n;
+  /* take the continuations. from now on, myth_future_then
+     calls them by itself */
+  do {
+    c = f->conts;
+  } while (!__sync_bool_compare_and_swap(&f->conts, c, MYTH_FUTURE_CONTS_DONE));
+  /* mark it ready and wake up those who are going to sleep */
+  do {
+    s = f->state;
+  } while (!__sync_bool_compare_and_swap(&f->state, s, s | MYTH_FUTURE_READY));
+  n = s / MYTH_FUTURE_WAITER;
+  if (n > 0) {
+    myth_wake_many_from_queue(f->sleep_q, 0, 0, n);
+  }
+  /* conts were pushed in front; call them in the attached order */
+  while (c) {
+    myth_future_cont_t * next = c->next;
+    c->next = rev;
+    rev = c;
+    c = next;
+  }
+  while (rev) {
+    myth_future_cont_t * next = rev->next;
+    rev->fn(f, rev->arg);
+    rev = next;
+  }
+  return 0;
+}
+
+static inline int myth_future_set_body(myth_future_t * f, const void * value) {
+  if (myth_future_claim_body(f)) {
+    return EBUSY;
+  }
+  if (value) {
+    memcpy(myth_future_value_body(f), value, f->size);
+  }
+  return myth_future_publish_body(f);
+}
+
+static inline int myth_future_then_body(myth_future_t * f,
+					myth_future_cont_t * cont,
+					void (*fn)(myth_future_t *, void *),
+					void * arg) {
+  cont->fn = fn;
+  cont->arg = arg;
+  while (1) {
+    myth_future_cont_t * c = f->conts;
+    if (c == MYTH_FUTURE_CONTS_DONE) {
+      /* the value has been written */
+      fn(f, arg);
+      return 0;
+    }
+    cont->next = c;
+    if (__sync_bool_compare_and_swap(&f->conts, c, cont)) {
+      return 0;
+    }
+  }
+}
+
 #endif /* MYTH_SYNC_FUNC_H_ */
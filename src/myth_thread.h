@@ -8,6 +8,7 @@
 #define MYTH_THREAD_H_
 
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "myth/myth.h"
 
@@ -21,18 +22,29 @@ typedef enum {
   MYTH_STATUS_READY = 0,
   // Blocked
   MYTH_STATUS_BLOCKED = 1,
-  // Execution finished. But you have to obtain lock before release
-  MYTH_STATUS_FREE_READY = 2,
-  //Execution finished. Feel free to release
-  MYTH_STATUS_FREE_READY2 = 3,
 } myth_status_t;
 
+/* Join state constants. Any other value of join_state is
+   the thread blocked in joining it */
+// Running, nobody joins it yet
+#define MYTH_JOIN_RUNNING  ((uintptr_t)0)
+// Running, detached
+#define MYTH_JOIN_DETACHED ((uintptr_t)1)
+// Execution finished, but still on its stack
+#define MYTH_JOIN_EXITING  ((uintptr_t)2)
+// Execution finished. Feel free to release
+#define MYTH_JOIN_FINISHED ((uintptr_t)3)
+
+/* home of a descriptor from myth_malloc (myth_ext_deserialize),
+   which no worker caches */
+#define MYTH_HOME_EXT (-1)
+
 /* Thread descriptor */
 // typedef 
 struct myth_thread {
   struct myth_thread * next;
-  // A thread which is waiting for this
-  struct myth_thread* join_thread;
+  // Join state (see above); a thread which is waiting for this
+  volatile uintptr_t join_state;
   myth_func_t entry_func;
   // Return value
   void *result;
@@ -43,13 +55,20 @@ struct myth_thread {
   size_t stack_size;
   // Pointer to worker thread
   struct myth_running_env* env;
-  // Lock
+  // Worker whose caches this descriptor and its stack return to,
+  // or MYTH_HOME_EXT
+  int home;
+  // Lock (for cancellation)
   myth_spinlock_t lock;
   // Status
   volatile myth_status_t status;
   uint8_t detached;
   uint8_t cancelled;
   uint8_t cancel_enabled;
+  // Priority level (myth_thread_attr_setpriority)
+  uint8_t priority;
+  // Worker this thread is pinned to (attr->pinned), or NULL
+  struct myth_running_env* pin;
 #if MYTH_ENABLE_THREAD_ANNOTATION && MYTH_COLLECT_LOG
   char annotation_str[MYTH_THREAD_ANNOTATION_MAXLEN];
   int recycle_count;
@@ -77,11 +96,28 @@ struct myth_thread {
 
 // __attribute__((aligned(CACHE_LINE_SIZE))) myth_thread, *myth_thread_t;
 
+/* Pickle of a suspended thread (see myth_serialize). Only the
+   live part of its stack, from the saved stack pointer to the
+   top, follows the header */
+#define MYTH_PICKLE_MAGIC   0x6b636970u	/* "pick" */
+#define MYTH_PICKLE_VERSION 2
+
 // typedef 
 struct myth_pickle {
+  uint32_t magic;
+  uint32_t version;
+  // sizeof(struct myth_thread) of the serializer
+  uint32_t desc_size;
+  uint32_t reserved;
+  // Bytes of the whole pickle, including the live stack
+  uint64_t size;
+  // The stack occupies [stack_top - stack_size, stack_top)
+  uint64_t stack_top;
+  uint64_t stack_size;
+  // The live stack [stack_top - live_size, stack_top) is in live[]
+  uint64_t live_size;
   struct myth_thread desc;
-  size_t stack_size;
-  char *stack;
+  char live[];
 } ;
 // myth_pickle_t;
 
@@ -0,0 +1,167 @@
+/*
+ * myth_timer.c : per-worker timer wheel for timed waits
+ */
+
+#include <string.h>
+
+#include "myth_config.h"
+
+#include "myth_timer.h"
+#include "myth_worker.h"
+#include "myth_timer_func.h"
+#include "myth_worker_func.h"
+#include "myth_spinlock_func.h"
+
+#define MYTH_TIMER_SLOT_MASK ((uint64_t)MYTH_TIMER_SLOTS - 1)
+
+void myth_timer_wheel_init(myth_timer_wheel_t w) {
+  memset(w, 0, sizeof(myth_timer_wheel));
+  myth_spin_init_body(&w->lock);
+  w->now = myth_timer_current_tick();
+}
+
+//Put t in the slot for its expiry, but not earlier than tick min.
+//A timer beyond the last level waits in its farthest slot and is
+//linked again when that slot is cascaded
+static void myth_timer_link(myth_timer_wheel_t w, myth_timer_t t, uint64_t min) {
+  uint64_t e = (t->expires < min ? min : t->expires);
+  uint64_t delta = e - w->now;
+  int l = 0;
+  while (l < MYTH_TIMER_LEVELS - 1
+	 && (delta >> (MYTH_TIMER_SLOT_BITS * (l + 1)))) {
+    l++;
+  }
+  if (delta >> (MYTH_TIMER_SLOT_BITS * (l + 1))) {
+    e = w->now + ((uint64_t)1 << (MYTH_TIMER_SLOT_BITS * MYTH_TIMER_LEVELS)) - 1;
+  }
+  myth_timer_t * head
+    = &w->slots[l][(e >> (MYTH_TIMER_SLOT_BITS * l)) & MYTH_TIMER_SLOT_MASK];
+  t->next = *head;
+  if (t->next) t->next->pprev = &t->next;
+  t->pprev = head;
+  *head = t;
+}
+
+//Process ticks up to tick, cascading upper levels as their slot
+//comes, and prepend expired timers to *fired
+static void myth_timer_advance(myth_timer_wheel_t w, uint64_t tick,
+			       myth_timer_t * fired) {
+  while (w->now < tick) {
+    myth_timer_t t, next;
+    int l;
+    if (w->n == 0) {
+      w->now = tick;
+      break;
+    }
+    w->now++;
+    for (l = 1; l < MYTH_TIMER_LEVELS; l++) {
+      myth_timer_t * head;
+      if (w->now & (((uint64_t)1 << (MYTH_TIMER_SLOT_BITS * l)) - 1)) break;
+      head = &w->slots[l][(w->now >> (MYTH_TIMER_SLOT_BITS * l)) & MYTH_TIMER_SLOT_MASK];
+      t = *head;
+      *head = NULL;
+      for (; t; t = next) {
+	next = t->next;
+	myth_timer_link(w, t, w->now);
+      }
+    }
+    t = w->slots[0][w->now & MYTH_TIMER_SLOT_MASK];
+    w->slots[0][w->now & MYTH_TIMER_SLOT_MASK] = NULL;
+    for (; t; t = next) {
+      next = t->next;
+      t->state = myth_timer_state_firing;
+      t->next = *fired;
+      *fired = t;
+      w->n--;
+    }
+  }
+}
+
+//Arm t on the wheel of env, which must be the current worker
+void myth_timer_arm(myth_running_env_t env, myth_timer_t t) {
+  myth_timer_wheel_t w = &env->timer_wheel;
+  myth_spin_lock_body(&w->lock);
+  if (w->n == 0) {
+    //The wheel has not been advanced while empty
+    w->now = myth_timer_current_tick();
+  }
+  t->wheel = w;
+  t->state = myth_timer_state_armed;
+  //The current tick has been processed (or is being skipped)
+  myth_timer_link(w, t, w->now + 1);
+  w->n++;
+  myth_spin_unlock_body(&w->lock);
+}
+
+//Disarm t if it is still armed, and wait for its expiry in
+//progress if any. Returns 1 if t has withdrawn the thread (i.e.,
+//timed out), 0 otherwise. t can be discarded afterwards
+int myth_timer_cancel(myth_timer_t t) {
+  myth_timer_wheel_t w = t->wheel;
+  if (t->state == myth_timer_state_armed) {
+    myth_spin_lock_body(&w->lock);
+    if (t->state == myth_timer_state_armed) {
+      *t->pprev = t->next;
+      if (t->next) t->next->pprev = t->pprev;
+      w->n--;
+      t->state = myth_timer_state_done;
+    }
+    myth_spin_unlock_body(&w->lock);
+  }
+  while (t->state == myth_timer_state_firing) {
+    myth_spin_pause();
+  }
+  myth_rbarrier();
+  return t->state == myth_timer_state_fired;
+}
+
+//Fire expired timers of the current worker's wheel. Threads they
+//withdraw go to the current worker's run queue
+void myth_timer_poll_really(myth_running_env_t env) {
+  myth_timer_wheel_t w = &env->timer_wheel;
+  myth_timer_t fired = NULL, next;
+  uint64_t tick = myth_timer_current_tick();
+  if (tick <= w->now) return;
+  //Somebody is cancelling; check again later
+  if (!myth_spin_trylock_body(&w->lock)) return;
+  myth_timer_advance(w, tick, &fired);
+  myth_spin_unlock_body(&w->lock);
+  for (; fired; fired = next) {
+    myth_thread_t th = fired->th;
+    next = fired->next;
+    if (!fired->withdraw || fired->withdraw(fired)) {
+      //fired stays valid until th runs
+      myth_wbarrier();
+      fired->state = myth_timer_state_fired;
+      th->env = env;
+      myth_runq_push(env, th);
+    } else {
+      //Whoever took th will make it runnable, and th will
+      //discard fired after this
+      myth_wbarrier();
+      fired->state = myth_timer_state_done;
+    }
+  }
+}
+
+//Nanoseconds until the wheel may have something to fire
+//(0 if overdue), or -1 if nothing is armed
+long myth_timer_next_ns(myth_timer_wheel_t w) {
+  uint64_t t, now_ns;
+  int j;
+  struct timespec tp[1];
+  if (w->n == 0) return -1;
+  myth_spin_lock_body(&w->lock);
+  t = ((w->now >> MYTH_TIMER_SLOT_BITS) + 1) << MYTH_TIMER_SLOT_BITS;
+  for (j = 1; j < MYTH_TIMER_SLOTS; j++) {
+    if (w->slots[0][(w->now + j) & MYTH_TIMER_SLOT_MASK]) {
+      t = w->now + j;
+      break;
+    }
+  }
+  myth_spin_unlock_body(&w->lock);
+  hr_gettime(tp);
+  now_ns = myth_timespec_to_ns(tp);
+  if (t * MYTH_TIMER_TICK_NS <= now_ns) return 0;
+  return (long)(t * MYTH_TIMER_TICK_NS - now_ns);
+}
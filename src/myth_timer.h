@@ -0,0 +1,66 @@
+/*
+ * myth_timer.h : per-worker timer wheel for timed waits
+ */
+#pragma once
+#ifndef MYTH_TIMER_H_
+#define MYTH_TIMER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "myth/myth.h"
+#include "myth_config.h"
+
+//A hierarchical timing wheel of MYTH_TIMER_LEVELS levels.
+//Level l has MYTH_TIMER_SLOTS slots, each covering
+//MYTH_TIMER_SLOTS^l ticks of MYTH_TIMER_TICK_NS
+#define MYTH_TIMER_SLOTS (1 << MYTH_TIMER_SLOT_BITS)
+
+typedef enum {
+  //In a wheel
+  myth_timer_state_armed = 0,
+  //Expired and taken out of the wheel; calling withdraw
+  myth_timer_state_firing,
+  //Withdrew the thread from its wait and made it runnable
+  myth_timer_state_fired,
+  //Cancelled, or expired after the thread had been woken up
+  myth_timer_state_done,
+} myth_timer_state_t;
+
+/* a timer usually lives on the stack of the thread waiting
+   for it. the thread arms it on the wheel of the worker it
+   blocks on and must call myth_timer_cancel after it resumes,
+   whoever has woken it up */
+typedef struct myth_timer {
+  struct myth_timer * next;
+  struct myth_timer ** pprev;
+  uint64_t expires;		/* in ticks */
+  struct myth_timer_wheel * wheel;
+  myth_thread_t th;		/* thread to wake up */
+  /* called on expiry by the worker owning the wheel. it should take
+     th out of whatever it waits on and return 1, or return 0 if
+     somebody has already taken it out to wake it up. NULL means
+     th does not wait on anything else (e.g., nanosleep) */
+  int (*withdraw)(struct myth_timer * t);
+  void * arg;
+  volatile myth_timer_state_t state;
+} myth_timer, * myth_timer_t;
+
+typedef struct myth_timer_wheel {
+  myth_spinlock_t lock;
+  //Ticks processed so far
+  uint64_t now;
+  //Number of armed timers; the scheduler looks at nothing else
+  //while it is zero
+  volatile long n;
+  myth_timer_t slots[MYTH_TIMER_LEVELS][MYTH_TIMER_SLOTS];
+} __attribute__((aligned(CACHE_LINE_SIZE))) myth_timer_wheel, * myth_timer_wheel_t;
+
+struct myth_running_env;
+void myth_timer_wheel_init(myth_timer_wheel_t w);
+void myth_timer_arm(struct myth_running_env * env, myth_timer_t t);
+int myth_timer_cancel(myth_timer_t t);
+void myth_timer_poll_really(struct myth_running_env * env);
+long myth_timer_next_ns(myth_timer_wheel_t w);
+
+#endif	/* MYTH_TIMER_H_ */
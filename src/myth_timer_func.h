@@ -0,0 +1,46 @@
+/*
+ * myth_timer_func.h
+ */
+#pragma once
+#ifndef MYTH_TIMER_FUNC_H_
+#define MYTH_TIMER_FUNC_H_
+
+#include "myth_config.h"
+#include "myth_timer.h"
+#include "myth_worker.h"
+
+#include "myth_misc_func.h"
+
+static inline uint64_t myth_timespec_to_ns(const struct timespec * ts) {
+  return (uint64_t)ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+//The tick now
+static inline uint64_t myth_timer_current_tick(void) {
+  struct timespec tp[1];
+  hr_gettime(tp);
+  return myth_timespec_to_ns(tp) / MYTH_TIMER_TICK_NS;
+}
+
+//Prepare t to make th runnable at abstime (CLOCK_REALTIME), or
+//as soon as the tick that begins at or after abstime is processed
+static inline void myth_timer_init(myth_timer_t t,
+				   const struct timespec * abstime,
+				   myth_thread_t th,
+				   int (*withdraw)(myth_timer_t),
+				   void * arg) {
+  uint64_t ns = myth_timespec_to_ns(abstime);
+  t->expires = (ns + MYTH_TIMER_TICK_NS - 1) / MYTH_TIMER_TICK_NS;
+  t->th = th;
+  t->withdraw = withdraw;
+  t->arg = arg;
+}
+
+//Called by the scheduler loop and myth_yield
+static inline void myth_timer_poll(myth_running_env_t env) {
+  if (env->timer_wheel.n) {
+    myth_timer_poll_really(env);
+  }
+}
+
+#endif	/* MYTH_TIMER_FUNC_H_ */
@@ -5,7 +5,15 @@
 #include "myth_config.h"
 #include "config.h"
 
+#include <limits.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "myth_worker.h"
+#include "myth_idle.h"
 #include "myth_worker_func.h"
 
 #if EXPERIMENTAL_SCHEDULER
@@ -16,6 +24,15 @@ myth_thread_t myth_default_steal_func(int rank);
 myth_steal_func_t g_myth_steal_func = myth_default_steal_func;
 #endif
 
+int g_myth_steal_many = 1;
+int g_myth_steal_hier_retries[MYTH_STEAL_HIER_LEVELS];
+
+//Victims of each worker sorted by topology level:
+//victims of rank r at level l are
+//steal_hier_victims[r*(nw-1)+steal_hier_end[r][l-1] .. +steal_hier_end[r][l]]
+static int * steal_hier_victims;
+static int (*steal_hier_end)[MYTH_STEAL_HIER_LEVELS];
+
 myth_steal_func_t myth_wsapi_set_stealfunc(myth_steal_func_t fn)
 {
   myth_steal_func_t prev=g_myth_steal_func;
@@ -44,7 +61,7 @@ myth_thread_t myth_default_steal_func(int rank) {
 #endif
     //ws_victim=busy_env->rank;
     //Try to steal thread
-    next_run = myth_queue_take(&busy_env->runnable_q);
+    next_run = myth_steal_from(env, busy_env);
     if (next_run){
 #if MYTH_SCHED_LOOP_DEBUG
       myth_dprintf("env %p is stealing thread %p from %p...\n",env,steal_th,busy_env);
@@ -69,6 +86,243 @@ myth_thread_t myth_default_steal_func(int rank) {
   return next_run;
 }
 
+//Try nearby workers first: siblings sharing L2, then the same
+//socket, then remote sockets, g_myth_steal_hier_retries[l] random
+//victims at each level
+myth_thread_t myth_hier_steal_func(int rank) {
+  myth_running_env_t env = &g_envs[rank];
+  int * victims = &steal_hier_victims[rank * (g_attr.n_workers - 1)];
+  int l, i, b = 0;
+  for (l = 0; l < MYTH_STEAL_HIER_LEVELS; l++) {
+    int e = steal_hier_end[rank][l];
+    if (b < e) {
+      for (i = 0; i < g_myth_steal_hier_retries[l]; i++) {
+	int victim = victims[myth_random(b, e)];
+	myth_thread_t next_run;
+	//Inactive workers have given their threads away
+	if (victim >= g_myth_n_active_workers) continue;
+	next_run = myth_steal_from(env, &g_envs[victim]);
+	if (next_run) {
+	  myth_assert(next_run->status==MYTH_STATUS_READY);
+	  return next_run;
+	}
+      }
+    }
+    b = e;
+  }
+  return NULL;
+}
+
+//Build victim lists from the cpus workers are bound to and install
+//myth_hier_steal_func. Does nothing if workers are not bound, or
+//all workers are equally close (e.g., a single socket without SMT)
+int myth_steal_hier_init(int nw) {
+  //dom[r][l] : id of the level l domain of worker r's cpu
+  int (*dom)[MYTH_STEAL_HIER_LEVELS - 1];
+  int * level;
+  int r, j, l, any = 0, mixed = 0;
+  for (l = 0; l < MYTH_STEAL_HIER_LEVELS; l++) {
+    any |= g_myth_steal_hier_retries[l];
+  }
+  if (!any || nw == 1 || !g_attr.bind_workers) return 0;
+  if (g_myth_steal_func != myth_default_steal_func) return 0;
+  dom = myth_malloc(sizeof(dom[0]) * nw);
+  for (r = 0; r < nw; r++) {
+    int cpu = myth_get_worker_cpu(r);
+    if (cpu == -1) {
+      myth_free(dom);
+      return 0;
+    }
+    dom[r][0] = myth_get_cpu_domain(cpu, MYTH_CPU_DOMAIN_CACHE);
+    dom[r][1] = myth_get_cpu_domain(cpu, MYTH_CPU_DOMAIN_SOCKET);
+  }
+  level = myth_malloc(sizeof(int) * nw);
+  steal_hier_victims = myth_malloc(sizeof(int) * nw * (nw - 1));
+  steal_hier_end = myth_malloc(sizeof(steal_hier_end[0]) * nw);
+  for (r = 0; r < nw; r++) {
+    int * victims = &steal_hier_victims[r * (nw - 1)];
+    int n = 0, n_levels = 0;
+    for (j = 0; j < nw; j++) {
+      //The nearest level whose domain is known and shared
+      for (l = 0; l < MYTH_STEAL_HIER_LEVELS - 1; l++) {
+	if (dom[r][l] != -1 && dom[r][l] == dom[j][l]) break;
+      }
+      level[j] = (j == r ? -1 : l);
+    }
+    for (l = 0; l < MYTH_STEAL_HIER_LEVELS; l++) {
+      int n0 = n;
+      for (j = 0; j < nw; j++) {
+	if (level[j] == l) victims[n++] = j;
+      }
+      steal_hier_end[r][l] = n;
+      if (n > n0) n_levels++;
+    }
+    myth_assert(n == nw - 1);
+    if (n_levels > 1) mixed = 1;
+  }
+  myth_free(level);
+  myth_free(dom);
+  if (!mixed) {
+    myth_steal_hier_fini();
+    return 0;
+  }
+  g_myth_steal_func = myth_hier_steal_func;
+  return 1;
+}
+
+void myth_steal_hier_fini(void) {
+  if (g_myth_steal_func == myth_hier_steal_func) {
+    g_myth_steal_func = myth_default_steal_func;
+  }
+  myth_free(steal_hier_victims);
+  myth_free(steal_hier_end);
+  steal_hier_victims = NULL;
+  steal_hier_end = NULL;
+}
+
+myth_running_env_t myth_get_current_env_again(void) {
+  return myth_get_current_env();
+}
+
+int g_myth_idle_policy = myth_idle_policy_spin;
+myth_idle_t g_myth_idle;
+
+static void myth_idle_futex_wait(volatile int * addr, int val, long ns) {
+#if defined(__linux__)
+  struct timespec ts[1] = { { ns / 1000000000, ns % 1000000000 } };
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, ts, NULL, 0);
+#else
+  (void)addr; (void)val; (void)ns;
+  real_sched_yield();
+#endif
+}
+
+static void myth_idle_futex_wake(volatile int * addr, int n) {
+#if defined(__linux__)
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+#else
+  (void)addr; (void)n;
+#endif
+}
+
+static int myth_idle_work_available(void) {
+  int i, l;
+  for (i = 0; i < g_attr.n_workers; i++) {
+    for (l = 0; l < MYTH_N_PRIORITIES; l++) {
+      myth_thread_queue_t q = myth_runq_level(&g_envs[i], l);
+      if (q->top - q->base > 0) return 1;
+    }
+    if (g_envs[i].inbox) return 1;
+  }
+  return 0;
+}
+
+//Sleep until a thread becomes runnable, MYTH_IDLE_PARK_TIMEOUT_NS
+//passes or a timer of this worker is due. Returns 1 if woken up,
+//0 on timeout
+int myth_idle_park(myth_running_env_t env) {
+  int seq = env->park_seq;
+  int woken = 1;
+  long ns = myth_timer_next_ns(&env->timer_wheel);
+  if (ns < 0 || ns > MYTH_IDLE_PARK_TIMEOUT_NS) {
+    ns = MYTH_IDLE_PARK_TIMEOUT_NS;
+  }
+  //Announce, then recheck. The atomic add is a full barrier, and
+  //pushes fence before they look at parked workers (myth_idle_notify,
+  //myth_inbox_push), so a push either is seen by the recheck or sees us
+  env->parked = 1;
+  __sync_fetch_and_add(&g_myth_idle.n_parked, 1);
+  if (ns > 0 && !env->exit_flag && !myth_idle_work_available()) {
+    myth_idle_futex_wait(&env->park_seq, seq, ns);
+    woken = (env->park_seq != seq);
+  }
+  env->parked = 0;
+  __sync_fetch_and_sub(&g_myth_idle.n_parked, 1);
+  if (g_myth_idle.waking) g_myth_idle.waking = 0;
+  return woken;
+}
+
+//Wake env if it is parked
+void myth_idle_wake(myth_running_env_t env) {
+  __sync_fetch_and_add(&env->park_seq, 1);
+  myth_idle_futex_wake(&env->park_seq, 1);
+}
+
+//Wake one parked worker. The worker is claimed by clearing its
+//parked flag, so that it clears waking when it returns
+void myth_idle_wake_one(void) {
+  int i;
+  if (!__sync_bool_compare_and_swap(&g_myth_idle.waking, 0, 1)) return;
+  for (i = 0; i < g_attr.n_workers; i++) {
+    myth_running_env_t env = &g_envs[i];
+    if (env->parked && __sync_bool_compare_and_swap(&env->parked, 1, 0)) {
+      myth_idle_wake(env);
+      return;
+    }
+  }
+  //All have returned in the meantime
+  g_myth_idle.waking = 0;
+}
+
+void myth_idle_wake_all(void) {
+  int i;
+  for (i = 0; i < g_attr.n_workers; i++) {
+    if (g_envs[i].parked) myth_idle_wake(&g_envs[i]);
+  }
+}
+
+volatile int g_myth_runq_slow;
+
+//Workers of rank >= g_myth_n_active_workers are inactive
+//(myth_set_num_active_workers). They also sleep on this word
+volatile int g_myth_n_active_workers;
+
+//Hand the threads in the runqueue of inactive worker env over to
+//active workers, round robin
+static void myth_inactive_drain(myth_running_env_t env) {
+  int i = 0;
+  myth_thread_t th;
+  while ((th = myth_runq_pop(env))) {
+    int n = g_myth_n_active_workers;
+    myth_running_env_t target;
+    if (n > env->rank) n = env->rank;
+    if (n < 1) n = 1;
+    do {
+      target = &g_envs[i++ % n];
+      th->env = target;
+    } while (!myth_runq_trypass(target, th));
+  }
+}
+
+//Called by the scheduler of env while it is inactive. Give its
+//threads away and sleep until it is made active again or exits.
+//Timers of env still fire, and the threads they wake are given away
+void myth_inactive_park(myth_running_env_t env) {
+  int n;
+  while ((n = g_myth_n_active_workers) <= env->rank && !env->exit_flag) {
+    long ns;
+    myth_timer_poll(env);
+    myth_inactive_drain(env);
+    ns = myth_timer_next_ns(&env->timer_wheel);
+    if (ns < 0 || ns > MYTH_IDLE_PARK_TIMEOUT_NS) {
+      ns = MYTH_IDLE_PARK_TIMEOUT_NS;
+    }
+    if (ns > 0) myth_idle_futex_wait(&g_myth_n_active_workers, n, ns);
+  }
+}
+
+//Make workers [0, n) active and the others inactive. Worker 0
+//is always active
+int myth_set_num_active_workers_really(int n) {
+  if (n < 1) n = 1;
+  if (n > g_attr.n_workers) n = g_attr.n_workers;
+  g_myth_n_active_workers = n;
+  myth_idle_futex_wake(&g_myth_n_active_workers, INT_MAX);
+  //Parked workers may now be the only ones left to run threads
+  myth_idle_wake_all();
+  return n;
+}
+
 #if EXPERIMENTAL_SCHEDULER
 
 static unsigned long * myth_steal_prob_table;
@@ -111,8 +365,8 @@ myth_env_choose_victim(myth_running_env_t e) {
 static myth_thread_t myth_steal_func_with_prob(int rank) {
   myth_running_env_t env = &g_envs[rank];
   myth_running_env_t busy_env = myth_env_choose_victim(env);
-  if (busy_env){
-    myth_thread_t next_run = myth_queue_take(&busy_env->runnable_q);
+  if (busy_env && busy_env->rank < g_myth_n_active_workers){
+    myth_thread_t next_run = myth_steal_from(env, busy_env);
     if (next_run){
       myth_assert(next_run->status == MYTH_STATUS_READY);
     }
@@ -12,10 +12,12 @@
 
 #include "myth_config.h"
 #include "myth_internal_barrier.h"
+#include "myth_log.h"
 #include "myth_misc.h"
 #include "myth_sched.h"
 #include "myth_io.h"
 #include "myth_wsqueue.h"
+#include "myth_timer.h"
 
 #if MYTH_ECO_MODE && MYTH_ECO_TEIAN_STEAL
 typedef enum {
@@ -95,6 +97,50 @@ typedef struct myth_prof_data {
 #endif
 } myth_prof_data, *myth_prof_data_t;
 
+//Sizes of a worker's caches of freed stacks and descriptors.
+//Only stacks of the default size are cached
+typedef struct myth_stack_cache_stats {
+  long n_stacks;		/* stacks in freelist_stack */
+  long n_released_stacks;	/* stacks in freelist_stack_released */
+  long n_descs;			/* descriptors in freelist_desc */
+  long n_unmapped_stacks;	/* stacks unmapped so far */
+  long n_unmapped_descs;	/* descriptors unmapped so far */
+  long n_remote_stacks_out;	/* stacks freed here and sent to other workers */
+  long n_remote_descs_out;	/* descriptors freed here and sent to other workers */
+  long n_remote_stacks_in;	/* stacks freed by other workers and taken back */
+  long n_remote_descs_in;	/* descriptors freed by other workers and taken back */
+  long n_arenas;		/* stack arenas mapped so far */
+} myth_stack_cache_stats, *myth_stack_cache_stats_t;
+
+//Steals of a worker from one victim
+typedef struct myth_steal_counter {
+  uint64_t n_attempts;
+  uint64_t n_hits;
+} myth_steal_counter;
+
+//Counters always kept by a worker and read by myth_get_stats from
+//any thread. Only the owner writes them, without atomics
+typedef struct myth_sched_stats {
+  uint64_t n_created;		/* threads created */
+  uint64_t idle_ns;		/* time the scheduler had nothing to run */
+  volatile uint64_t idle_since;	/* start of the current idle period (ns), 0 if not idle */
+  myth_steal_counter * steals;	/* [victim rank], g_attr.n_workers entries */
+} myth_sched_stats;
+
+//The arena default stacks are currently carved out of
+typedef struct myth_stack_arena {
+  char * cur;			/* next slot */
+  char * end;
+} myth_stack_arena;
+
+//Stacks and descriptors freed by other workers, on their way back
+//to the worker that allocated them. Any worker pushes; the owner
+//takes all at once when its caches run dry
+typedef struct myth_remote_free_list {
+  myth_freelist_cell_t * volatile stacks;
+  myth_freelist_cell_t * volatile descs;
+} __attribute__((aligned(CACHE_LINE_SIZE))) myth_remote_free_list;
+
 //A structure describing an environment for executing a thread
 //(scheduler, worker thread, runqueue, etc...)
 //Each worker thread have one of them
@@ -105,14 +151,17 @@ typedef struct myth_running_env {
 #if MYTH_SPLIT_STACK_DESC
   myth_freelist_t freelist_desc;//Freelist of thread descriptor
   myth_freelist_t freelist_stack;//Freelist of stack
+  myth_freelist_t freelist_stack_released;//Freelist of stack whose pages have been released
+  myth_stack_cache_stats stack_cache;
+  myth_stack_arena stack_arena;
 #else
   myth_freelist_t freelist_ds;//Freelis
 #endif
-  int log_buf_size;
-  int log_count;
-  myth_spinlock_t log_lock;
-  struct myth_log_entry *log_data;
+#if MYTH_COLLECT_LOG
+  myth_log_ring log_ring;
+#endif
   struct myth_prof_data prof_data;
+  myth_sched_stats stats;
   struct myth_sched sched;	//Scheduler descriptor
   //The following entries may be read from other worker threads
   pthread_t worker;
@@ -120,12 +169,35 @@ typedef struct myth_running_env {
   //The following entries may be written by other worker threads
   //Appropriate synchronization is required
   myth_thread_queue runnable_q;//Runqueue
+  //Runqueues of priority levels 1 .. MYTH_N_PRIORITIES-1
+  myth_thread_queue prio_q[MYTH_N_PRIORITIES > 1 ? MYTH_N_PRIORITIES - 1 : 1];
+  //Consecutive threads taken from levels above 0 (starvation guard)
+  int prio_streak;
+  //Threads other workers created for this one (myth_create_on),
+  //a lock-free stack linked by next. Moved to the runqueue by pops
+  myth_thread_t volatile inbox __attribute__((aligned(CACHE_LINE_SIZE)));
+  //MYTH_IDLE_POLICY=park: 1 while this worker is parked (or about
+  //to park), and the futex word it sleeps on, bumped to wake it up
+  volatile int parked;
+  volatile int park_seq;
+  //NUMA node of the cpu this worker is bound to, or -1
+  int numa_node;
+  //Runnable threads pinned to this worker (FIFO linked by next).
+  //Only the owner touches them and thieves never see them
+  myth_thread_t pinned_head;
+  myth_thread_t pinned_tail;
   //Reference to Global free list
 #if MYTH_SPLIT_STACK_DESC
   myth_freelist_t *freelist_desc_g;//Freelist of thread descriptor
   myth_freelist_t *freelist_stack_g;//Freelist of stack
 #endif
   struct myth_io_struct_perenv io_struct;//I/O-related data structure. See myth_io_struct.h
+#if MYTH_SPLIT_STACK_DESC
+  myth_remote_free_list remote_free;
+#endif
+  //Timers of threads in timed waits that blocked on this worker.
+  //Fired by this worker; cancelled by any
+  myth_timer_wheel timer_wheel;
 #if MYTH_ECO_MODE
   int my_sem;
   int isSleepy;
@@ -159,6 +231,55 @@ int myth_scheduler_global_init(int nw);
 
 //typedef struct myth_thread* (*myth_steal_func_t)(int);
 extern myth_steal_func_t g_myth_steal_func;
+//Max number of threads taken by one steal (MYTH_STEAL_MANY)
+extern int g_myth_steal_many;
+
+//Limits of the stack caches (MYTH_STACK_CACHE_HIGH/MAX) and
+//whether to print their sizes at exit (MYTH_STACK_CACHE_STATS)
+extern long g_myth_stack_cache_high;
+extern long g_myth_stack_cache_max;
+extern int g_myth_stack_cache_stats;
+//Size of stack arenas (MYTH_STACK_ARENA_SIZE; 0 if disabled), whether
+//to back them by huge pages (MYTH_STACK_ARENA_HUGEPAGE), and the guard
+//size below each stack in them (MYTH_STACK_ARENA_GUARD)
+extern size_t g_myth_stack_arena_size;
+extern int g_myth_stack_arena_hugepage;
+extern size_t g_myth_stack_arena_guard;
+void * myth_stack_arena_alloc(myth_running_env_t env);
+void myth_stack_cache_release_stack(myth_running_env_t env, void * ptr);
+void myth_stack_cache_release_desc(myth_running_env_t env, void * th);
+void myth_stack_cache_print_stats(myth_running_env_t env);
+
+//Hierarchical victim selection (MYTH_STEAL_HIER).
+//Level 0: workers sharing L2, 1: same socket, 2: others
+#define MYTH_STEAL_HIER_LEVELS 3
+//Number of victims tried at each level per steal; all 0 disables it
+extern int g_myth_steal_hier_retries[MYTH_STEAL_HIER_LEVELS];
+myth_thread_t myth_hier_steal_func(int rank);
+int myth_steal_hier_init(int nw);
+void myth_steal_hier_fini(void);
+
+//Bits set once a thread of priority > 0 (MYTH_RUNQ_SLOW_PRIO) or
+//a pinned thread (MYTH_RUNQ_SLOW_PINNED) is created. Until then,
+//the runqueues of levels > 0 or the pinned threads are known to be
+//empty and not looked at, so pops and steals take the fast path
+#define MYTH_RUNQ_SLOW_PRIO   1
+#define MYTH_RUNQ_SLOW_PINNED 2
+extern volatile int g_myth_runq_slow;
+
+static inline void myth_runq_push(myth_running_env_t env, myth_thread_t th);
+static inline void myth_runq_put(myth_running_env_t env, myth_thread_t th);
+static inline int myth_runq_trypass(myth_running_env_t env, myth_thread_t th);
+static inline myth_thread_t myth_runq_pop(myth_running_env_t env);
+static inline myth_thread_t myth_runq_take(myth_running_env_t env);
+static inline void myth_inbox_push(myth_running_env_t env, myth_thread_t th);
+static inline myth_running_env_t myth_preferred_env(myth_running_env_t env, int worker, int numa_node);
+
+//Workers of rank >= g_myth_n_active_workers give their threads
+//away and sleep (myth_set_num_active_workers)
+extern volatile int g_myth_n_active_workers;
+void myth_inactive_park(myth_running_env_t env);
+int myth_set_num_active_workers_really(int n);
 
 //Thread index
 extern myth_running_env_t g_envs;
@@ -180,6 +301,11 @@ extern __thread int g_worker_rank;
 #error "invalid WENV_IMPL"
 #endif
 
+//myth_get_current_env out of line, so that the compiler cannot
+//reuse the TLS address of an earlier call in the same function
+//(the thread may have moved to another worker since)
+myth_running_env_t myth_get_current_env_again(void);
+
 
 static void myth_sched_loop(void);
 
@@ -195,5 +321,8 @@ static inline void myth_startpoint_exit_ex_body(int rank);
 static void *myth_worker_thread_fn(void *args);
 
 static inline int myth_get_num_workers_body(void);
+static inline int myth_get_num_active_workers_body(void);
+static inline int myth_set_num_active_workers_body(int n);
+static inline int myth_runqueue_is_empty_body(void);
 
 #endif /* MYTH_WORKER_H_ */
@@ -16,6 +16,7 @@
 #include "myth_sched.h"
 #include "myth_log.h"
 #include "myth_io.h"
+#include "myth_idle.h"
 
 #include "myth_init_func.h"
 #include "myth_misc_func.h"
@@ -24,6 +25,7 @@
 #include "myth_sched_func.h"
 #include "myth_log_func.h"
 #include "myth_io_func.h"
+#include "myth_timer_func.h"
 
 #if MYTH_ECO_MODE
 #include "myth_eco.h"
@@ -111,12 +113,14 @@ static inline myth_running_env_t myth_get_current_env(void) {
 #if WS_TARGET_RANDOM
 //Search a worker thread that seems to be busy
 static inline myth_running_env_t myth_env_get_first_busy(myth_running_env_t e) {
+  //Inactive workers are never chosen
+  int n = g_myth_n_active_workers;
   //If number of worker threads == 1 , always fails
-  if (g_attr.n_workers == 1) return NULL;
+  if (n == 1) return NULL;
   //Choose randomly
   int idx;
   do {
-    idx = myth_random(0,g_attr.n_workers);
+    idx = myth_random(0,n);
   } while (idx == e->rank);
   return &g_envs[idx];
 }
@@ -129,11 +133,13 @@ static inline myth_running_env_t myth_env_get_first_busy(myth_running_env_t e) {
 #endif
 
 static inline myth_running_env_t myth_env_get_randomly(void) {
+  //Inactive workers are never chosen
+  int n = g_myth_n_active_workers;
   //If number of worker threads == 1 , always fails
-  if (g_attr.n_workers == 1) return &g_envs[0];
+  if (n == 1) return &g_envs[0];
   //Choose randomly
   int idx;
-  idx = myth_random(0, g_attr.n_workers);
+  idx = myth_random(0, n);
   return &g_envs[idx];
 }
 
@@ -141,9 +147,13 @@ void myth_alrm_sighandler(int signum,siginfo_t *sinfo,void* ctx);
 
 static void myth_setup_worker(int rank) {
   myth_running_env_t env = &g_envs[rank];
+  int i;
   env->rank = rank;
   env->exit_flag = 0;
   memset(&env->prof_data, 0, sizeof(myth_prof_data));
+  memset(&env->stats, 0, sizeof(myth_sched_stats));
+  env->stats.steals = myth_malloc(sizeof(myth_steal_counter) * g_attr.n_workers);
+  memset(env->stats.steals, 0, sizeof(myth_steal_counter) * g_attr.n_workers);
   //Initialize allocators
   myth_flmalloc_init_worker(rank);
   //myth_malloc_wrapper_init_worker(rank);
@@ -156,10 +166,31 @@ static void myth_setup_worker(int rank) {
   //Initialize runqueue
   myth_queue_init(&env->runnable_q);
   myth_queue_clear(&env->runnable_q);
+  for (i = 0; i < MYTH_N_PRIORITIES - 1; i++) {
+    myth_queue_init(&env->prio_q[i]);
+    myth_queue_clear(&env->prio_q[i]);
+  }
+  env->prio_streak = 0;
+  env->inbox = NULL;
+  env->parked = 0;
+  env->park_seq = 0;
+  env->pinned_head = NULL;
+  env->pinned_tail = NULL;
+  env->numa_node = (g_attr.bind_workers > 0 ?
+		    myth_get_cpu_domain(myth_get_worker_cpu(rank),
+					MYTH_CPU_DOMAIN_NODE) : -1);
+  //Initialize timers
+  myth_timer_wheel_init(&env->timer_wheel);
   //Initialize freelist for thread descriptor
 #if MYTH_SPLIT_STACK_DESC
   myth_freelist_init(&env->freelist_desc);
   myth_freelist_init(&env->freelist_stack);
+  myth_freelist_init(&env->freelist_stack_released);
+  memset(&env->stack_cache, 0, sizeof(env->stack_cache));
+  env->remote_free.stacks = NULL;
+  env->remote_free.descs = NULL;
+  env->stack_arena.cur = NULL;
+  env->stack_arena.end = NULL;
 #if (INITIAL_STACK_ALLOC_UNIT>0)
   {
     //Allocate
@@ -262,6 +293,7 @@ static inline void myth_cleanup_worker(int rank)
   //synchronize
   myth_internal_barrier_wait(&g_worker_barrier);
   myth_running_env_t env;
+  int i;
   env=myth_get_current_env();
   //cleanup timer
   if (rank==0){
@@ -281,6 +313,9 @@ static inline void myth_cleanup_worker(int rank)
 #endif
   //Release runqueue
   myth_queue_fini(&env->runnable_q);
+  for (i = 0; i < MYTH_N_PRIORITIES - 1; i++) {
+    myth_queue_fini(&env->prio_q[i]);
+  }
   //Release thread descriptor of current thread
   if (env->this_thread)free_myth_thread_struct_desc(env,env->this_thread);			//Found in a freelist-ds
   //Count freelist entry
@@ -295,6 +330,10 @@ static inline void myth_cleanup_worker(int rank)
   if (fl_num)
     fprintf(stderr,"Rank : %d freelist stack entry : %d\n",rank,fl_num);
 #endif
+  //Release steal counters
+  myth_free_with_size(env->stats.steals,
+		      sizeof(myth_steal_counter) * g_attr.n_workers);
+  env->stats.steals = NULL;
   //Release allocator
   myth_flmalloc_fini_worker(rank);
   //myth_malloc_wrapper_fini_worker(rank);
@@ -319,7 +358,7 @@ MYTH_CTX_CALLBACK void myth_startpoint_init_ex_1(void *arg1,void *arg2,void *arg
   myth_thread_t this_th = (myth_thread_t)arg2;
   (void)arg3;
   //Add to runqueue
-  myth_queue_push(&env->runnable_q,this_th);
+  myth_runq_push(env,this_th);
 }
 
 //Execute worker thread scheduling loop introducing current context as a new thread
@@ -343,6 +382,8 @@ static inline void myth_startpoint_init_ex_body(int rank)
      with myth_create_ex_body */
   myth_tls_tree_init(this_th->tls);
   
+  this_th->priority = 0;
+  this_th->pin = NULL;
   //Set worker thread descrptor
   this_th->env = env;
   //Initialize context for scheduler
@@ -362,7 +403,7 @@ MYTH_CTX_CALLBACK void myth_startpoint_exit_ex_1(void *arg1,void *arg2,void *arg
   (void)arg3;
   myth_running_env_t target=&g_envs[rank];
   th->env=target;
-  while (!myth_queue_trypass(&target->runnable_q,th)){
+  while (!myth_runq_trypass(target,th)){
     target=myth_env_get_randomly();
     th->env=target;
   }
@@ -388,6 +429,8 @@ static void myth_notify_workers_exit(void) {
 	g_envs[i].exit_flag = 1;
     }
   }
+  //Parked and inactive workers must see exit_flag
+  myth_set_num_active_workers_really(g_attr.n_workers);
 }
 
 //Return the context introduced by myth_startpoint_init_ex to the original pthread
@@ -451,6 +494,227 @@ static inline void *myth_worker_thread_fn(void *args) {
 
 extern myth_steal_func_t g_myth_steal_func;
 
+//Runqueue of env for threads of priority level l
+static inline myth_thread_queue_t myth_runq_level(myth_running_env_t env, int l) {
+  return (l == 0 ? &env->runnable_q : &env->prio_q[l - 1]);
+}
+
+//Append th to the pinned threads of env, or send it to the
+//inbox of the worker it is pinned to
+static inline void myth_pinned_put(myth_running_env_t env, myth_thread_t th) {
+  if (th->pin != env) {
+    myth_inbox_push(th->pin, th);
+    return;
+  }
+  th->next = NULL;
+  if (env->pinned_tail) {
+    env->pinned_tail->next = th;
+  } else {
+    env->pinned_head = th;
+  }
+  env->pinned_tail = th;
+}
+
+static inline myth_thread_t myth_pinned_pop(myth_running_env_t env) {
+  myth_thread_t th = env->pinned_head;
+  if (th) {
+    env->pinned_head = th->next;
+    if (!th->next) env->pinned_tail = NULL;
+    th->next = NULL;
+  }
+  return th;
+}
+
+//Push th to the runqueue of env of its priority
+static inline void myth_runq_push(myth_running_env_t env, myth_thread_t th) {
+  if (th->pin) {
+    myth_pinned_put(env, th);
+  } else if (MYTH_N_PRIORITIES > 1 && th->priority) {
+    myth_queue_push(&env->prio_q[th->priority - 1], th);
+  } else {
+    myth_queue_push(&env->runnable_q, th);
+  }
+}
+
+//Put th at the tail of the runqueue of env of its priority
+static inline void myth_runq_put(myth_running_env_t env, myth_thread_t th) {
+  if (th->pin) {
+    myth_pinned_put(env, th);
+  } else if (MYTH_N_PRIORITIES > 1 && th->priority) {
+    myth_queue_put(&env->prio_q[th->priority - 1], th);
+  } else {
+    myth_queue_put(&env->runnable_q, th);
+  }
+}
+
+//Pass th to the runqueue of env (another worker) of its priority.
+//A pinned thread is pinned to env from now on
+static inline int myth_runq_trypass(myth_running_env_t env, myth_thread_t th) {
+  if (th->pin) {
+    th->pin = env;
+    myth_inbox_push(env, th);
+    return 1;
+  } else if (MYTH_N_PRIORITIES > 1 && th->priority) {
+    return myth_queue_trypass(&env->prio_q[th->priority - 1], th);
+  } else {
+    return myth_queue_trypass(&env->runnable_q, th);
+  }
+}
+
+//Pop from the highest non-empty level, but from the lowest one
+//once MYTH_PRIO_STARVATION_LIMIT threads in a row came from above 0.
+//Pinned threads, which no other worker can run, are above all levels
+static inline myth_thread_t myth_runq_pop_prio(myth_running_env_t env) {
+  myth_thread_t th;
+  int l;
+  if (env->prio_streak >= MYTH_PRIO_STARVATION_LIMIT) {
+    env->prio_streak = 0;
+    for (l = 0; l < MYTH_N_PRIORITIES; l++) {
+      th = myth_queue_pop(myth_runq_level(env, l));
+      if (th) return th;
+    }
+    return myth_pinned_pop(env);
+  }
+  th = myth_pinned_pop(env);
+  if (th) {
+    env->prio_streak++;
+    return th;
+  }
+  for (l = MYTH_N_PRIORITIES - 1; l > 0; l--) {
+    th = myth_queue_pop(&env->prio_q[l - 1]);
+    if (th) {
+      env->prio_streak++;
+      return th;
+    }
+  }
+  env->prio_streak = 0;
+  return myth_queue_pop(&env->runnable_q);
+}
+
+//Push th to the inbox of env from any thread. The owner takes
+//the whole list at once, so a plain CAS push has no ABA problem
+static inline void myth_inbox_push(myth_running_env_t env, myth_thread_t th) {
+  myth_thread_t head;
+  th->env = env;
+  do {
+    head = env->inbox;
+    th->next = head;
+  } while (!__sync_bool_compare_and_swap(&env->inbox, head, th));
+  //The CAS is a full barrier, so either env sees th when it
+  //rechecks before parking, or we see it parked. Wake only env
+  if (env->parked) myth_idle_wake(env);
+}
+
+//Empty the inbox of env (the calling worker). Return the thread
+//delivered first and push the others to the runqueue, so that
+//the older ones are popped first
+static inline myth_thread_t myth_inbox_drain(myth_running_env_t env) {
+  myth_thread_t th = __sync_lock_test_and_set(&env->inbox, NULL);
+  myth_thread_t first = NULL;
+  //Newest first
+  while (th) {
+    myth_thread_t next = th->next;
+    th->next = NULL;
+    if (first) myth_runq_push(env, first);
+    first = th;
+    th = next;
+  }
+  return first;
+}
+
+//Worker a thread preferring worker or numa_node goes to when
+//created on env, or NULL to stay on env
+static inline myth_running_env_t myth_preferred_env(myth_running_env_t env,
+						    int worker, int numa_node) {
+  int n = g_myth_n_active_workers;
+  myth_running_env_t e = NULL;
+  if (worker >= 0 && worker < g_attr.n_workers) {
+    //An inactive worker would only give it away
+    e = &g_envs[worker < n ? worker : worker % n];
+  } else if (numa_node >= 0 && env->numa_node != numa_node) {
+    int i, r = myth_random(0, n);
+    for (i = 0; i < n; i++) {
+      if (g_envs[(r + i) % n].numa_node == numa_node) {
+	e = &g_envs[(r + i) % n];
+	break;
+      }
+    }
+  }
+  return (e == env ? NULL : e);
+}
+
+//Pop the next thread to run on env (the calling worker).
+//Threads in the inbox come first. Otherwise, just a pop of
+//runnable_q until priorities or pinned threads are used
+static inline myth_thread_t myth_runq_pop(myth_running_env_t env) {
+  if (env->inbox) return myth_inbox_drain(env);
+  if (g_myth_runq_slow) {
+    return myth_runq_pop_prio(env);
+  }
+  return myth_queue_pop(&env->runnable_q);
+}
+
+//Take a thread of levels above 0 from victim, highest first
+static inline myth_thread_t myth_runq_take_prio(myth_running_env_t victim) {
+  int l;
+  for (l = MYTH_N_PRIORITIES - 1; l > 0; l--) {
+    myth_thread_t th = myth_queue_take(&victim->prio_q[l - 1]);
+    if (th) return th;
+  }
+  return NULL;
+}
+
+//Take a thread from victim (another worker), highest level first
+static inline myth_thread_t myth_runq_take(myth_running_env_t victim) {
+  if (MYTH_N_PRIORITIES > 1 && (g_myth_runq_slow & MYTH_RUNQ_SLOW_PRIO)) {
+    myth_thread_t th = myth_runq_take_prio(victim);
+    if (th) return th;
+  }
+  return myth_queue_take(&victim->runnable_q);
+}
+
+//Steal from victim on behalf of env (the calling worker).
+//With MYTH_STEAL_MANY > 1, take up to half of the victim's threads,
+//return the oldest and push the rest to env's runqueue
+static inline myth_thread_t myth_steal_from(myth_running_env_t env,
+					    myth_running_env_t victim)
+{
+  myth_steal_counter * c = &env->stats.steals[victim->rank];
+  c->n_attempts++;
+  if (MYTH_N_PRIORITIES > 1 && (g_myth_runq_slow & MYTH_RUNQ_SLOW_PRIO)) {
+    //Threads of higher levels are stolen one at a time
+    myth_thread_t th = myth_runq_take_prio(victim);
+    if (th) {
+      c->n_hits++;
+      myth_log_add_steal(env, th, victim->rank);
+      return th;
+    }
+  }
+  if (g_myth_steal_many <= 1) {
+    myth_thread_t th = myth_queue_take(&victim->runnable_q);
+    if (th) {
+      c->n_hits++;
+      myth_log_add_steal(env, th, victim->rank);
+    }
+    return th;
+  } else {
+    myth_thread_t ths[MYTH_QUEUE_TAKE_MANY_MAX];
+    int n = myth_queue_take_many(&victim->runnable_q, ths, g_myth_steal_many);
+    int i;
+    if (n == 0) return NULL;
+    c->n_hits++;
+    for (i = 0; i < n; i++) {
+      myth_log_add_steal(env, ths[i], victim->rank);
+    }
+    for (i = 1; i < n; i++) {
+      myth_assert(ths[i]->status == MYTH_STATUS_READY);
+      ths[i]->env = env;
+      myth_queue_push(&env->runnable_q, ths[i]);
+    }
+    return ths[0];
+  }
+}
+
 static inline myth_thread_t myth_steal_body(void)
 {
   myth_thread_t ret;
@@ -459,11 +723,11 @@ static inline myth_thread_t myth_steal_body(void)
   target=myth_env_get_randomly();
   myth_assert(target);
   //Try to steal thread
-  ret = myth_queue_take(&target->runnable_q);
+  ret = myth_runq_take(target);
   if (ret){
     if (!ret->stack){
       //Cannot be stolen because it is main thread
-      while (!myth_queue_trypass(&target->runnable_q,ret)){
+      while (!myth_runq_trypass(target,ret)){
 	//Retry changing the target
 	target = myth_env_get_randomly();
       }
@@ -480,16 +744,12 @@ static inline void myth_import_body(myth_thread_t th)
 {
   myth_running_env_t e = myth_get_current_env();
   th->env=e;
-  myth_queue_push(&e->runnable_q,th);
+  myth_runq_push(e,th);
 }
 
 static inline void myth_ext_import_body(myth_thread_t th)
 {
-  myth_running_env_t target;
-  do{
-    target = myth_env_get_randomly();
-  }
-  while (!myth_queue_trypass(&target->runnable_q,th));
+  myth_inbox_push(myth_env_get_randomly(), th);
 }
 
 #if MYTH_ECO_MODE
@@ -500,7 +760,7 @@ static void myth_eco_sched_loop(myth_running_env_t env) {
     //sched_yield();
     myth_thread_t next_run;
     //Get runnable thread
-    next_run = myth_queue_pop(&env->runnable_q);
+    next_run = myth_runq_pop(env);
 #if MYTH_WRAP_SOCKIO
     //If there is no runnable thread, check I/O
     if (!next_run){
@@ -573,6 +833,48 @@ static void myth_eco_sched_loop(myth_running_env_t env) {
 }
 #endif
 
+//Clock of idle time in myth_sched_stats
+static inline uint64_t myth_stats_now_ns(void) {
+  struct timespec ts[1];
+#if defined(HAVE_LIBRT)
+  clock_gettime(CLOCK_MONOTONIC, ts);
+#else
+  struct timeval tv[1];
+  gettimeofday(tv, 0);
+  ts->tv_sec = tv->tv_sec;
+  ts->tv_nsec = tv->tv_usec * 1000;
+#endif
+  return (uint64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+//Account the idle period of env that has just ended, if any
+static inline void myth_stats_end_idle(myth_running_env_t env) {
+  uint64_t since = env->stats.idle_since;
+  if (since) {
+    env->stats.idle_ns += myth_stats_now_ns() - since;
+    env->stats.idle_since = 0;
+  }
+}
+
+//The scheduler found no thread for the *idle_count-th consecutive
+//time; spin, sched_yield or park according to MYTH_IDLE_POLICY
+static inline void myth_idle_wait(myth_running_env_t env, int * idle_count) {
+  int n = ++(*idle_count);
+  if (n <= MYTH_IDLE_SPIN_COUNT) return;
+  if (g_myth_idle_policy == myth_idle_policy_yield
+      || n <= MYTH_IDLE_SPIN_COUNT + MYTH_IDLE_YIELD_COUNT) {
+    real_sched_yield();
+    return;
+  }
+  if (myth_idle_park(env)) {
+    //Woken up for a new thread; look for it eagerly again
+    *idle_count = 0;
+  } else {
+    //Timed out; park again after one more round
+    *idle_count = MYTH_IDLE_SPIN_COUNT + MYTH_IDLE_YIELD_COUNT;
+  }
+}
+
 //Main loop of scheduler
 static void myth_sched_loop(void)
 {
@@ -595,7 +897,7 @@ static void myth_sched_loop(void)
   }
 #endif
   //get the first thread
-  myth_thread_t first_run=myth_queue_pop(&env->runnable_q);
+  myth_thread_t first_run=myth_runq_pop(env);
   myth_internal_barrier_wait(&g_worker_barrier);
   if (first_run){
     //sanity check
@@ -613,11 +915,21 @@ static void myth_sched_loop(void)
     return;
   }
 #endif
+  //Number of consecutive rounds that found no thread
+  int idle_count = 0;
   while (1) {
     //sched_yield();
     myth_thread_t next_run;
+    //Give threads away and sleep while this worker is inactive
+    if (env->rank >= g_myth_n_active_workers){
+      myth_stats_end_idle(env);
+      idle_count = 0;
+      myth_inactive_park(env);
+    }
+    //Wake up threads whose timed wait has expired
+    myth_timer_poll(env);
     //Get runnable thread
-    next_run=myth_queue_pop(&env->runnable_q);
+    next_run=myth_runq_pop(env);
 #if MYTH_WRAP_SOCKIO
     //If there is no runnable thread, check I/O
     if (!next_run){
@@ -640,20 +952,29 @@ static void myth_sched_loop(void)
 	myth_dprintf("myth_sched_loop:switching to thread:%p\n",next_run);
 #endif
 	myth_assert(next_run->status==MYTH_STATUS_READY);
+	idle_count = 0;
+	myth_stats_end_idle(env);
 	myth_swap_context(&env->sched.context, &next_run->context);
 #if MYTH_SCHED_LOOP_DEBUG
 	myth_dprintf("myth_sched_loop:returned from thread:%p\n",(void*)next_run);
 #endif
 	env->this_thread=NULL;
       }
-#if MYTH_PAUSE
     else {
-      // TODO: make it portable
-      __asm__ __volatile("pause;");
-    }
+      if (!env->stats.idle_since) env->stats.idle_since = myth_stats_now_ns();
+      if (g_myth_idle_policy != myth_idle_policy_spin) {
+	myth_idle_wait(env, &idle_count);
+      }
+#if MYTH_PAUSE
+      else {
+	// TODO: make it portable
+	__asm__ __volatile("pause;");
+      }
 #endif
+    }
     //Check exit flag
     if (env->exit_flag==1){
+      myth_stats_end_idle(env);
       env->this_thread=NULL;
 #if MYTH_SCHED_LOOP_DEBUG
       myth_dprintf("env %p received exit signal,exiting\n",env);
@@ -674,4 +995,84 @@ static inline int myth_get_num_workers_body(void) {
   return g_attr.n_workers;
 }
 
+static inline int myth_get_num_active_workers_body(void) {
+  myth_ensure_init();
+  return g_myth_n_active_workers;
+}
+
+static inline int myth_set_num_active_workers_body(int n) {
+  myth_ensure_init();
+  return myth_set_num_active_workers_really(n);
+}
+
+//No thread in the runqueues of the calling worker can be stolen,
+//i.e., thieves took everything it exposed (or it exposed nothing)
+static inline int myth_runqueue_is_empty_body(void) {
+  myth_running_env_t env;
+  int l;
+  myth_ensure_init();
+  env = myth_get_current_env();
+  if (!(g_myth_runq_slow & MYTH_RUNQ_SLOW_PRIO)) {
+    return env->runnable_q.top - env->runnable_q.base <= 0;
+  }
+  for (l = 0; l < MYTH_N_PRIORITIES; l++) {
+    myth_thread_queue_t q = myth_runq_level(env, l);
+    if (q->top - q->base > 0) return 0;
+  }
+  return 1;
+}
+
+//Take a snapshot of the counters of all workers. They are read
+//while the workers update them, so they may be a little stale
+static inline int myth_get_stats_body(myth_stats_t * s) {
+  int nw, i, j;
+  uint64_t now;
+  myth_ensure_init();
+  nw = g_attr.n_workers;
+  now = myth_stats_now_ns();
+  s->n_workers = nw;
+  memset(&s->total, 0, sizeof(s->total));
+  for (i = 0; i < nw; i++) {
+    myth_running_env_t env = &g_envs[i];
+    myth_worker_stats_t w[1];
+    uint64_t since = env->stats.idle_since;
+    memset(w, 0, sizeof(w));
+    w->n_created = env->stats.n_created;
+    w->idle_ns = env->stats.idle_ns;
+    if (since && now > since) w->idle_ns += now - since;
+    for (j = 0; j < nw; j++) {
+      myth_steal_counter * c = &env->stats.steals[j];
+      uint64_t a = c->n_attempts;
+      uint64_t h = c->n_hits;
+      //A hit may be counted after we read the attempts
+      if (h > a) a = h;
+      w->n_steal_attempts += a;
+      w->n_steal_hits += h;
+      if (s->steals) {
+	myth_steal_stats_t * st = &s->steals[i * nw + j];
+	st->n_attempts = a;
+	st->n_hits = h;
+	st->n_misses = a - h;
+      }
+    }
+    w->n_steal_misses = w->n_steal_attempts - w->n_steal_hits;
+    w->queue_high_water = env->runnable_q.high_water;
+#if MYTH_SPLIT_STACK_DESC
+    w->n_stacks_cached
+      = env->stack_cache.n_stacks + env->stack_cache.n_released_stacks;
+#endif
+    if (s->workers) s->workers[i] = *w;
+    s->total.n_created += w->n_created;
+    s->total.n_steal_attempts += w->n_steal_attempts;
+    s->total.n_steal_hits += w->n_steal_hits;
+    s->total.n_steal_misses += w->n_steal_misses;
+    s->total.idle_ns += w->idle_ns;
+    if (w->queue_high_water > s->total.queue_high_water) {
+      s->total.queue_high_water = w->queue_high_water;
+    }
+    s->total.n_stacks_cached += w->n_stacks_cached;
+  }
+  return 0;
+}
+
 #endif	/* MYTH_WORKER_FUNC_H_ */
@@ -26,6 +26,21 @@ static int myth_should_wrap_pthread(void) {
   return s_myth_should_wrap_pthread;
 }
 
+/* whether the wrapped pthread_mutex_lock spins before blocking,
+   regardless of the mutex type (MYTH_WRAP_MUTEX_ADAPTIVE=0/1) */
+static int myth_should_wrap_mutex_adaptive(void) {
+  static int s_myth_should_wrap_mutex_adaptive = -1;
+  if (s_myth_should_wrap_mutex_adaptive == -1) {
+    const char * s = getenv("MYTH_WRAP_MUTEX_ADAPTIVE");
+    if (s) {
+      s_myth_should_wrap_mutex_adaptive = (atoi(s) != 0);
+    } else {
+      s_myth_should_wrap_mutex_adaptive = MYTH_WRAP_MUTEX_ADAPTIVE;
+    }
+  }
+  return s_myth_should_wrap_mutex_adaptive;
+}
+
 void myth_wrap_pthread_warn_non_conforming_(const char * fun) {
   static int n_non_conforming = 0;
   const int max_warnings = 10;
@@ -712,6 +727,10 @@ static inline int pthread_mutex_type_to_myth(int t) {
     return MYTH_MUTEX_ERRORCHECK;
   case PTHREAD_MUTEX_RECURSIVE:
     return MYTH_MUTEX_RECURSIVE;
+#if defined(PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP)
+  case PTHREAD_MUTEX_ADAPTIVE_NP:
+    return MYTH_MUTEX_ADAPTIVE;
+#endif
   default:
     return MYTH_MUTEX_INVALID;
   }
@@ -815,7 +834,11 @@ int __wrap(pthread_mutex_lock)(pthread_mutex_t *mutex) {
   (void)_;
   if (myth_should_wrap_pthread()) {
     myth_handle_PTHREAD_MUTEX_INITIALIZER(mutex);
-    ret = myth_mutex_lock_body((myth_mutex_t *)mutex);
+    if (myth_should_wrap_mutex_adaptive()) {
+      ret = myth_mutex_lock_adaptive_body((myth_mutex_t *)mutex);
+    } else {
+      ret = myth_mutex_lock_body((myth_mutex_t *)mutex);
+    }
   } else {
     ret = real_pthread_mutex_lock(mutex);
   }
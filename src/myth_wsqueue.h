@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include "myth/myth.h"
@@ -35,6 +36,13 @@
 
 #define WS_CACHE_SIZE 2048
 
+//Maximum number of times a runqueue can be extended
+//(INITIAL_QUEUE_SIZE << MYTH_QUEUE_MAX_GROW entries at most)
+#define MYTH_QUEUE_MAX_GROW 22
+
+//Maximum number of threads myth_queue_take_many takes at once
+#define MYTH_QUEUE_TAKE_MANY_MAX 32
+
 //cache
 typedef struct{
   char data[WS_CACHE_SIZE];
@@ -56,6 +64,20 @@ typedef struct{
 #define USE_THREAD_CS 0
 #endif
 
+#if MYTH_WSQUEUE_CAS_STEAL
+//base and a tag, updated together by CAS (see myth_wsqueue_func.h)
+typedef union myth_queue_age {
+  uint64_t v;
+  struct {
+    int base;
+    unsigned int tag;
+  } s;
+} myth_queue_age_t;
+
+//set in the tag while base is frozen by trypass/put/grow/clear
+#define MYTH_QUEUE_AGE_BUSY 1u
+#endif
+
 //Runqueue data structure
 typedef struct myth_thread_queue
 {
@@ -64,13 +86,27 @@ typedef struct myth_thread_queue
   char pad0[CACHE_LINE_SIZE];
 #endif
   volatile int top;
+#if MYTH_WSQUEUE_CAS_STEAL
+  union {
+    volatile uint64_t age;
+    volatile int base;		/* = age.s.base */
+  };
+#else
   volatile int base;
+#endif
 #if PAD_MYTH_THREAD_QUEUE_TOP_BASE
   char pad1[CACHE_LINE_SIZE];
 #endif
+  /* circular buffer; thread at logical index i is in ptr[i & (size - 1)] */
   struct myth_thread** ptr;
   int size;
   myth_spinlock_t lock;
+  /* arrays replaced by myth_queue_grow. a thief may still be
+     reading them without the lock, so they are freed at fini */
+  struct myth_thread** old_ptrs[MYTH_QUEUE_MAX_GROW];
+  int n_old_ptrs;
+  /* most threads ever in the queue after a push (myth_get_stats) */
+  int high_water;
 #if USE_LOCK || USE_LOCK_ANY
   myth_spinlock_t m_lock;
 #endif
@@ -91,8 +127,11 @@ static inline void myth_queue_push(myth_thread_queue_t q,struct myth_thread *th)
 static inline struct myth_thread* myth_queue_pop(myth_thread_queue_t q);
 static inline void myth_queue_put(myth_thread_queue_t q,myth_thread_t th);
 static inline struct myth_thread* myth_queue_take(myth_thread_queue_t q);
+static inline int myth_queue_take_many(myth_thread_queue_t q,struct myth_thread** ths,int max_n);
 static inline int myth_queue_trypass(myth_thread_queue_t q,struct myth_thread* th);
 static inline void myth_queue_pass(myth_thread_queue_t q,struct myth_thread* th);
+static inline struct myth_thread** myth_queue_slot(myth_thread_queue_t q,int i);
+static inline void myth_queue_grow(myth_thread_queue_t q);
 
 static inline int myth_queue_is_operating(myth_thread_queue_t q);
 
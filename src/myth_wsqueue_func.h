@@ -7,6 +7,7 @@
 
 #include "myth_config.h"
 #include "myth_wsqueue.h"
+#include "myth_idle.h"
 
 #include "myth_spinlock_func.h"
 #include "myth_misc_func.h"
@@ -114,8 +115,14 @@ static inline void myth_queue_init(myth_thread_queue_t q){
   pthread_mutexattr_destroy(&attr);
 #endif
   q->size = INITIAL_QUEUE_SIZE;
+  myth_assert((q->size & (q->size - 1)) == 0);
   q->ptr = myth_malloc(sizeof(myth_thread_t)*q->size);
   memset(q->ptr,0,sizeof(myth_thread_t)*q->size);
+  q->n_old_ptrs = 0;
+  q->high_water = 0;
+#if MYTH_WSQUEUE_CAS_STEAL
+  q->age = 0;
+#endif
   q->base = q->size/2;
   q->top = q->base;
   memset(&q->wc,0,sizeof(myth_wscache));
@@ -128,8 +135,60 @@ static inline void myth_queue_fini(myth_thread_queue_t q){
   myth_spin_destroy(&q->m_lock);
 #endif
   myth_free_with_size(q->ptr,0);
+  int i;
+  for (i = 0; i < q->n_old_ptrs; i++) {
+    myth_free_with_size(q->old_ptrs[i],0);
+  }
+  q->n_old_ptrs = 0;
+}
+
+//Return the slot of logical index i
+static inline myth_thread_t * myth_queue_slot(myth_thread_queue_t q,int i)
+{
+  return &q->ptr[i & (q->size - 1)];
 }
 
+//Read the slot of logical index i without q->lock (e.g., peek).
+//size before ptr; see myth_queue_grow
+static inline myth_thread_t myth_queue_load_slot(myth_thread_queue_t q,int i)
+{
+  int size = q->size;
+  myth_wsqueue_rbarrier();
+  return q->ptr[i & (size - 1)];
+}
+
+//Double the size of the runqueue.
+//Owner only, and q->lock must be held, so no thief is inside
+//take/trypass. The old array is retired rather than freed because
+//myth_queue_peek reads the queue without the lock.
+static inline void myth_queue_grow(myth_thread_queue_t q)
+{
+  int old_size = q->size;
+  int new_size = old_size * 2;
+  myth_thread_t * old_ptr = q->ptr;
+  myth_thread_t * new_ptr;
+  int i;
+  if (q->n_old_ptrs == MYTH_QUEUE_MAX_GROW) {
+    myth_assert(0);
+    fprintf(stderr, "Fatal error:Runqueue overflow\n");
+    abort();
+  }
+  new_ptr = myth_malloc(sizeof(myth_thread_t) * new_size);
+  memset(new_ptr, 0, sizeof(myth_thread_t) * new_size);
+  for (i = q->base; i < q->top; i++) {
+    new_ptr[i & (new_size - 1)] = old_ptr[i & (old_size - 1)];
+  }
+  q->old_ptrs[q->n_old_ptrs++] = old_ptr;
+  myth_wsqueue_wbarrier();
+  //Publish ptr before size; a lock-free thief reads size first,
+  //so it never indexes the old array with the new size
+  q->ptr = new_ptr;
+  myth_wsqueue_wbarrier();
+  q->size = new_size;
+}
+
+#if !MYTH_WSQUEUE_CAS_STEAL
+
 static inline void myth_queue_clear(myth_thread_queue_t q)
 {
   myth_queue_enter_operation(q);
@@ -158,35 +217,26 @@ static inline void __attribute__((always_inline)) myth_queue_push(myth_thread_qu
   int t = q->top;
   //read barrier
   myth_wsqueue_rbarrier();
-  if (t == q->size){
+  //Keep some slots free; myth_queue_take_many reads the slots it
+  //took after publishing base, so we must not wrap around onto them
+  if (t - q->base >= q->size - 2 * MYTH_QUEUE_TAKE_MANY_MAX){
     //Acquire lock
     myth_wsqueue_lock_lock(&q->lock);
-    //Runqueue full?
-    if (q->base == 0){
-      myth_assert(0);
-      fprintf(stderr, "Fatal error:Runqueue overflow\n");
-      abort();
-      /* TODO:extend runqueue */
-    } else {
-      //Shift pointers
-      int offset = (- q->base - 1) / 2;
-      myth_assert(offset < 0);
-      memmove(&q->ptr[q->base+offset], &q->ptr[q->base], 
-	      sizeof(myth_thread_t) * (q->top - q->base));
-      q->top += offset;
-      q->base += offset;
+    //Runqueue full? (a thief may have made room meanwhile)
+    if (t - q->base >= q->size - 2 * MYTH_QUEUE_TAKE_MANY_MAX){
+      myth_queue_grow(q);
     }
-    t = q->top;
-    myth_assert(t < q->size);
     myth_wsqueue_lock_unlock(&q->lock);
   }
-  //Do not need to extend of move.
-  q->ptr[t] = th;
+  //Do not need to extend.
+  *myth_queue_slot(q, t) = th;
   myth_wsqueue_wbarrier();//Guarantee W-W dependency
   q->top = t + 1;
+  if (t + 1 - q->base > q->high_water) q->high_water = t + 1 - q->base;
 #if USE_LOCK || USE_LOCK_PUSH
   myth_spin_unlock_body(&q->m_lock);
 #endif
+  myth_idle_notify();
   myth_queue_exit_operation(q);
 }
 
@@ -213,7 +263,7 @@ static inline myth_thread_t __attribute__((always_inline)) myth_queue_pop(myth_t
   myth_wsqueue_rwbarrier();
   base = q->base;
   if (base + 1 < top){
-    ret = q->ptr[top];
+    ret = *myth_queue_slot(q, top);
     //q->ptr[top]=NULL;
 #if USE_LOCK || USE_LOCK_POP
     myth_spin_unlock_body(&q->m_lock);
@@ -224,8 +274,8 @@ static inline myth_thread_t __attribute__((always_inline)) myth_queue_pop(myth_t
     myth_wsqueue_lock_lock(&q->lock);
     base = q->base;
     if (base <= top){//OK
-      ret = q->ptr[top];
-      q->ptr[top] = NULL;
+      ret = *myth_queue_slot(q, top);
+      *myth_queue_slot(q, top) = NULL;
       if (top <= base) {
 	//invalidate cache
 	myth_wscache_t wc = &q->wc;
@@ -290,14 +340,15 @@ static inline myth_thread_t myth_queue_take(myth_thread_queue_t q)
 #else
   myth_wsqueue_lock_lock(&q->lock);
 #endif
-  //Increment base
+  //Read the slot before incrementing base; once base is incremented,
+  //the owner may reuse the slot for a push
   b = q->base;
+  ret = *myth_queue_slot(q, b);
+  //Increment base
   q->base = b + 1;
   myth_wsqueue_rwbarrier();
   top = q->top;
   if (b < top){
-    ret = q->ptr[b];
-    //q->ptr[b]=NULL;
     myth_wsqueue_lock_unlock(&q->lock);
 #if USE_LOCK || USE_LOCK_TAKE
     myth_spin_unlock_body(&q->m_lock);
@@ -314,32 +365,6 @@ static inline myth_thread_t myth_queue_take(myth_thread_queue_t q)
   myth_unreachable();
 }
 
-static inline myth_thread_t myth_queue_peek(myth_thread_queue_t q)
-{
-  myth_thread_t ret;
-  int b,top;
-#if QUICK_CHECK_ON_STEAL
-  if (q->top - q->base <= 0){
-    return NULL;
-  }
-#endif
-  //myth_wsqueue_lock_lock(&q->lock);
-  //if (!myth_wsqueue_lock_trylock(&q->lock))return NULL;
-  //Increment base
-  b = q->base;
-  top = q->top;
-  if (b < top){
-    ret = q->ptr[b];
-    //myth_wsqueue_lock_unlock(&q->lock);
-    return ret;
-  }else{
-    //myth_wsqueue_lock_unlock(&q->lock);
-    return NULL;
-  }
-  myth_unreachable();
-}
-
-
 static inline int myth_queue_trypass(myth_thread_queue_t q,myth_thread_t th)
 {
 #if USE_LOCK || USE_LOCK_TRYPASS
@@ -347,32 +372,28 @@ static inline int myth_queue_trypass(myth_thread_queue_t q,myth_thread_t th)
 #endif
   int ret = 1;
   if (!myth_wsqueue_lock_trylock(&q->lock)) return 0;
-  if (q->base == 0){
+  int b = q->base;
+  //Reserve the slot first, then check against top, which the
+  //owner may be incrementing without the lock. Only the owner
+  //extends the queue, so fail if it is full.
+  q->base = b - 1;
+  myth_wsqueue_rwbarrier();
+  if (q->top - (b - 1) >= q->size){
+    q->base = b;
     ret = 0;
   }
   else{
-    int b;
-    b = q->base;
-    q->ptr[b-1] = th;
+    *myth_queue_slot(q, b - 1) = th;
     myth_wsqueue_wbarrier();
-    q->base--;
   }
   myth_wsqueue_lock_unlock(&q->lock);
 #if USE_LOCK || USE_LOCK_TRYPASS
   myth_spin_unlock_body(&q->m_lock);
 #endif
+  if (ret) myth_idle_notify();
   return ret;
 }
 
-static inline void myth_queue_pass(myth_thread_queue_t q,myth_thread_t th)
-{
-  int ret;
-  do {
-    ret = myth_queue_trypass(q,th);
-  } while (ret == 0);
-}
-
-
 //put:Owner function: put a thread to the tail of the queue
 static inline void myth_queue_put(myth_thread_queue_t q, myth_thread_t th)
 {
@@ -381,33 +402,354 @@ static inline void myth_queue_put(myth_thread_queue_t q, myth_thread_t th)
   myth_spin_lock_body(&q->m_lock);
 #endif
   myth_wsqueue_lock_lock(&q->lock);
-  if (q->base == 0){
-    /* queue underflow at the bottom. move the contents higher */
-    if (q->top == q->size){
-      myth_assert(0);
-      fprintf(stderr,"Fatal error:Runqueue overflow\n");
-      abort();
-    } else {
-      int offset = (q->size - q->top + 1) / 2;
-      myth_assert(offset > 0);
-      memmove(&q->ptr[q->base + offset], &q->ptr[q->base],
-	      sizeof(myth_thread_t) * (q->top - q->base));
-      q->top += offset;
-      q->base += offset;
-      myth_assert(q->base > 0);
-    }
+  if (q->top - q->base >= q->size){
+    myth_queue_grow(q);
   }
   int b = q->base;
-  myth_assert(b > 0);
   b--;
-  q->ptr[b] = th;
+  *myth_queue_slot(q, b) = th;
   q->base = b;
   myth_wsqueue_lock_unlock(&q->lock);
 #if USE_LOCK || USE_LOCK_PUSH
   myth_spin_unlock_body(&q->m_lock);
 #endif
+  myth_idle_notify();
+  myth_queue_exit_operation(q);
+}
+
+
+//Take up to half of the threads (at most max_n) at once.
+//Returns the number of threads stored in ths, oldest first
+static inline int myth_queue_take_many(myth_thread_queue_t q,
+				       myth_thread_t * ths, int max_n)
+{
+  int b,top,n,i;
+  if (max_n > MYTH_QUEUE_TAKE_MANY_MAX) max_n = MYTH_QUEUE_TAKE_MANY_MAX;
+#if QUICK_CHECK_ON_STEAL
+  if (q->top - q->base <= 0){
+    return 0;
+  }
+#endif
+#if USE_LOCK || USE_LOCK_TAKE
+  myth_spin_lock_body(&q->m_lock);
+#endif
+  myth_wsqueue_lock_lock(&q->lock);
+  b = q->base;
+  top = q->top;
+  while (1) {
+    //Half, rounded up
+    n = (top - b + 1) / 2;
+    if (n > max_n) n = max_n;
+    if (n <= 0) {
+      n = 0;
+      break;
+    }
+    //Increment base by n
+    q->base = b + n;
+    myth_wsqueue_rwbarrier();
+    top = q->top;
+    if (b + n <= top) {
+      //The owner pops only above b + n now and keeps enough
+      //free slots not to push onto [b, b + n)
+      for (i = 0; i < n; i++) {
+	ths[i] = *myth_queue_slot(q, b + i);
+      }
+      break;
+    }
+    //The owner popped some; retry with the new top
+    q->base = b;
+    myth_wsqueue_rwbarrier();
+    top = q->top;
+  }
+  myth_wsqueue_lock_unlock(&q->lock);
+#if USE_LOCK || USE_LOCK_TAKE
+  myth_spin_unlock_body(&q->m_lock);
+#endif
+  return n;
+}
+
+#else  /* MYTH_WSQUEUE_CAS_STEAL */
+
+/* Chase-Lev style runqueue. Thieves (take) and the owner's pop of the
+   last thread race by CAS on q->age ({base, tag}) and never acquire
+   q->lock. Operations that move base downward or replace the array
+   (trypass, put, grow, clear) hold q->lock and freeze base by setting
+   MYTH_QUEUE_AGE_BUSY; a thief that sees it gives up, as if a trylock
+   had failed. The tag is bumped on every unfreeze, so a thief that
+   read the age before the freeze fails its CAS (no ABA). */
+
+#if USE_LOCK || USE_LOCK_ANY
+#error "MYTH_WSQUEUE_CAS_STEAL does not support USE_LOCK_*"
+#endif
+
+static inline myth_queue_age_t myth_queue_load_age(myth_thread_queue_t q)
+{
+  myth_queue_age_t a;
+  a.v = q->age;
+  return a;
+}
+
+static inline int myth_queue_cas_age(myth_thread_queue_t q,
+				     myth_queue_age_t old_a, myth_queue_age_t new_a)
+{
+  return __sync_bool_compare_and_swap(&q->age, old_a.v, new_a.v);
+}
+
+//Freeze base. q->lock must be held
+static inline myth_queue_age_t myth_queue_freeze(myth_thread_queue_t q)
+{
+  while (1) {
+    myth_queue_age_t a = myth_queue_load_age(q);
+    myth_queue_age_t n = a;
+    myth_assert(!(a.s.tag & MYTH_QUEUE_AGE_BUSY));
+    n.s.tag |= MYTH_QUEUE_AGE_BUSY;
+    if (myth_queue_cas_age(q, a, n)) return a;
+  }
+}
+
+//Unfreeze base, setting it to base
+static inline void myth_queue_unfreeze(myth_thread_queue_t q,
+				       myth_queue_age_t a, int base)
+{
+  myth_queue_age_t n;
+  n.s.base = base;
+  n.s.tag = a.s.tag + 2;
+  myth_wsqueue_wbarrier();
+  q->age = n.v;
+}
+
+static inline void myth_queue_clear(myth_thread_queue_t q)
+{
+  myth_queue_enter_operation(q);
+  myth_wsqueue_lock_lock(&q->lock);
+  myth_queue_age_t a = myth_queue_freeze(q);
+  myth_assert(q->top == a.s.base);
+  q->top = q->size/2;
+  myth_queue_unfreeze(q, a, q->size/2);
+  myth_wsqueue_lock_unlock(&q->lock);
   myth_queue_exit_operation(q);
 }
 
+//push/pop/peek:Owner thread operations
+static inline void __attribute__((always_inline)) myth_queue_push(myth_thread_queue_t q, myth_thread_t th)
+{
+  myth_queue_enter_operation(q);
+  int t = q->top;
+  myth_wsqueue_rbarrier();
+  //Keep one slot free so that trypass never writes a slot we may be
+  //filling (see myth_queue_trypass)
+  if (t - q->base >= q->size - 1){
+    myth_wsqueue_lock_lock(&q->lock);
+    myth_queue_age_t a = myth_queue_freeze(q);
+    if (t - a.s.base >= q->size - 1){
+      myth_queue_grow(q);
+    }
+    myth_queue_unfreeze(q, a, a.s.base);
+    myth_wsqueue_lock_unlock(&q->lock);
+  }
+  *myth_queue_slot(q, t) = th;
+  myth_wsqueue_wbarrier();//Guarantee W-W dependency
+  q->top = t + 1;
+  if (t + 1 - q->base > q->high_water) q->high_water = t + 1 - q->base;
+  myth_idle_notify();
+  myth_queue_exit_operation(q);
+}
+
+#if MYTH_QUEUE_LIFO
+static inline myth_thread_t __attribute__((always_inline)) myth_queue_pop(myth_thread_queue_t q)
+{
+  myth_queue_enter_operation(q);
+#if QUICK_CHECK_ON_POP
+  if (q->top <= q->base) {
+    return NULL;
+  }
+#endif
+  myth_thread_t ret;
+  int t = q->top - 1;
+  q->top = t;
+  myth_wsqueue_rwbarrier();
+  myth_queue_age_t a = myth_queue_load_age(q);
+  if (a.s.base < t){
+    //At least two threads; no thief can reach top
+    ret = *myth_queue_slot(q, t);
+    myth_queue_exit_operation(q);
+    return ret;
+  }
+  //Racing with thieves for the last thread. Wait for trypass/put
+  //in progress, which may add a thread below base.
+  while (a.s.tag & MYTH_QUEUE_AGE_BUSY){
+    myth_wsqueue_rbarrier();
+    a = myth_queue_load_age(q);
+  }
+  if (a.s.base < t){
+    ret = *myth_queue_slot(q, t);
+  } else if (a.s.base == t){
+    myth_queue_age_t n = a;
+    n.s.base = t + 1;
+    ret = *myth_queue_slot(q, t);
+    if (!myth_queue_cas_age(q, a, n)) {
+      //A thief took it
+      ret = NULL;
+    }
+    q->top = t + 1;
+  } else {
+    ret = NULL;
+    q->top = t + 1;
+  }
+  myth_queue_exit_operation(q);
+  return ret;
+}
+#else  /* MYTH_QUEUE_LIFO */
+static inline myth_thread_t myth_queue_take(myth_thread_queue_t q);
+static inline myth_thread_t myth_queue_pop(myth_thread_queue_t q){
+  return myth_queue_take(q);
+}
+#endif /* MYTH_QUEUE_LIFO */
+
+//Take a thread at base if pred (if given) accepts it.
+//Returns NULL when the queue is empty, pred rejects the thread,
+//or another thread won the race
+static inline myth_thread_t myth_queue_take_if(myth_thread_queue_t q,
+					       int (*pred)(myth_thread_t, void *),
+					       void * udata)
+{
+  myth_thread_t ret;
+  myth_thread_t * ptr;
+  int size, b;
+#if QUICK_CHECK_ON_STEAL
+  if (q->top - q->base <= 0){
+    return NULL;
+  }
+#endif
+  if (pred) {
+    //pred looks into the thread, so take it with base frozen
+    //as trypass does; a slot read optimistically may be stale
+    //(a popped thread, already freed) or in the middle of a grow
+    if (!myth_wsqueue_lock_trylock(&q->lock)) return NULL;
+    myth_queue_age_t a = myth_queue_freeze(q);
+    b = a.s.base;
+    ret = NULL;
+    myth_wsqueue_rwbarrier();
+    if (b < q->top) {
+      myth_thread_t th = *myth_queue_slot(q, b);
+      if (th && pred(th, udata)) ret = th;
+    }
+    myth_queue_unfreeze(q, a, (ret ? b + 1 : b));
+    myth_wsqueue_lock_unlock(&q->lock);
+    return ret;
+  }
+  myth_queue_age_t a = myth_queue_load_age(q);
+  if (a.s.tag & MYTH_QUEUE_AGE_BUSY) return NULL;
+  myth_wsqueue_rbarrier();
+  b = a.s.base;
+  if (b >= q->top) return NULL;
+  //size before ptr; see myth_queue_grow
+  size = q->size;
+  myth_wsqueue_rbarrier();
+  ptr = q->ptr;
+  ret = ptr[b & (size - 1)];
+  myth_queue_age_t n = a;
+  n.s.base = b + 1;
+  if (myth_queue_cas_age(q, a, n)) return ret;
+  return NULL;
+}
+
+//take/pass:Non-owner functions
+static inline myth_thread_t myth_queue_take(myth_thread_queue_t q)
+{
+  return myth_queue_take_if(q, NULL, NULL);
+}
+
+static inline int myth_queue_trypass(myth_thread_queue_t q,myth_thread_t th)
+{
+  int ret = 1;
+  if (!myth_wsqueue_lock_trylock(&q->lock)) return 0;
+  myth_queue_age_t a = myth_queue_freeze(q);
+  int b = a.s.base;
+  //The owner pushes without looking at the freeze, so keep the
+  //slot we write (b - 1, i.e. b - 1 + size) far away from top
+  if (q->top - b > q->size / 2){
+    ret = 0;
+    myth_queue_unfreeze(q, a, b);
+  } else {
+    *myth_queue_slot(q, b - 1) = th;
+    myth_queue_unfreeze(q, a, b - 1);
+  }
+  myth_wsqueue_lock_unlock(&q->lock);
+  if (ret) myth_idle_notify();
+  return ret;
+}
+
+//put:Owner function: put a thread to the tail of the queue
+static inline void myth_queue_put(myth_thread_queue_t q, myth_thread_t th)
+{
+  myth_queue_enter_operation(q);
+  myth_wsqueue_lock_lock(&q->lock);
+  myth_queue_age_t a = myth_queue_freeze(q);
+  int b = a.s.base;
+  if (q->top - b >= q->size - 1){
+    myth_queue_grow(q);
+  }
+  *myth_queue_slot(q, b - 1) = th;
+  myth_queue_unfreeze(q, a, b - 1);
+  myth_wsqueue_lock_unlock(&q->lock);
+  myth_idle_notify();
+  myth_queue_exit_operation(q);
+}
+
+//Take up to half of the threads (at most max_n).
+//A single CAS cannot validate more than one slot against the owner's
+//pops, so this is a series of takes that stops at the first failure
+static inline int myth_queue_take_many(myth_thread_queue_t q,
+				       myth_thread_t * ths, int max_n)
+{
+  int n = (q->top - q->base + 1) / 2;
+  int i;
+  if (n > max_n) n = max_n;
+  if (n > MYTH_QUEUE_TAKE_MANY_MAX) n = MYTH_QUEUE_TAKE_MANY_MAX;
+  for (i = 0; i < n; i++) {
+    myth_thread_t th = myth_queue_take_if(q, NULL, NULL);
+    if (!th) break;
+    ths[i] = th;
+  }
+  return i;
+}
+
+#endif /* MYTH_WSQUEUE_CAS_STEAL */
+
+static inline myth_thread_t myth_queue_peek(myth_thread_queue_t q)
+{
+  myth_thread_t ret;
+  int b,top;
+#if QUICK_CHECK_ON_STEAL
+  if (q->top - q->base <= 0){
+    return NULL;
+  }
+#endif
+  //myth_wsqueue_lock_lock(&q->lock);
+  //if (!myth_wsqueue_lock_trylock(&q->lock))return NULL;
+  //Increment base
+  b = q->base;
+  top = q->top;
+  if (b < top){
+    ret = myth_queue_load_slot(q, b);
+    //myth_wsqueue_lock_unlock(&q->lock);
+    return ret;
+  }else{
+    //myth_wsqueue_lock_unlock(&q->lock);
+    return NULL;
+  }
+  myth_unreachable();
+}
+
+
+static inline void myth_queue_pass(myth_thread_queue_t q,myth_thread_t th)
+{
+  int ret;
+  do {
+    ret = myth_queue_trypass(q,th);
+  } while (ret == 0);
+}
+
 
 #endif /* MYTH_WSQUEUE_FUNC_H_ */
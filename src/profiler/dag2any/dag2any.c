@@ -86,6 +86,8 @@ static struct option dag2a_options[] = {
   {"nosqlite",    no_argument, 0, 0 },
   {"text",        no_argument, 0, 0 },
   {"notext",      no_argument, 0, 0 },
+  {"trace",       no_argument, 0, 0 },
+  {"notrace",     no_argument, 0, 0 },
   {"nodes",       no_argument, 0, 0 },
   {"edges",       no_argument, 0, 0 },
   {"strings",     no_argument, 0, 0 },
@@ -107,6 +109,7 @@ static void usage(const char * progname) {
   U("    --[no]parallelism\n");
   U("    --[no]sqlite\n");
   U("    --[no]text\n");
+  U("    --[no]trace\n");
   U("    --[no]shrink\n");
   //U("    --nodes filename\n");
   //U("    --edges filename\n");
@@ -139,6 +142,7 @@ static int parse_args(int argc, char ** argv,
   opts->stat_file_yes = 0;	   /* no stat files */
   opts->gpl_file_yes = 0;	/* no parallelism files */
   opts->text_file_yes = 0;	   /* no text files */
+  opts->trace_file_yes = 0;	   /* no trace files */
   /* we set it to null, so that we can know
    if it was given by the user (either by
    environment or --prefix. if given, use
@@ -184,6 +188,10 @@ static int parse_args(int argc, char ** argv,
 	  o->text_file_yes = 1;
 	} else if (strcmp(name, "notext") == 0) {
 	  o->text_file_yes = 0;
+	} else if (strcmp(name, "trace") == 0) {
+	  o->trace_file_yes = 1;
+	} else if (strcmp(name, "notrace") == 0) {
+	  o->trace_file_yes = 0;
 	} else if (strcmp(name, "nodes") == 0) {
 	  o->nodes_file_yes = 1;
 	} else if (strcmp(name, "nonodes") == 0) {
@@ -723,6 +731,7 @@ static int read_and_analyze_dag(const char * filename) {
     if (dr_gen_gpl(G) == 0) return 0;
     if (dr_gen_dot(G) == 0) return 0;
     if (dr_gen_text(G) == 0) return 0;
+    if (dr_gen_trace(G) == 0) return 0;
     if (dr_gen_sqlite3(G) == 0) return 0;
     if (GS.opts.shrink) {
       if (dr_gen_pi_dag(G) == 0) return 0;
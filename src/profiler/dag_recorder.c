@@ -32,6 +32,7 @@ dr_global_state GS = {
     0,	 /* dot_file */
     0,	 /* sqlite_file */
     0,	 /* text_file */
+    0,	 /* trace_file */
     0,	 /* nodes_file */	
     0,	 /* edges_file */	
     0,	 /* strings_file */	
@@ -72,6 +72,7 @@ extern "C" {
     char dot_file_yes;	          /* if set, save dot file */
     char sqlite_file_yes;	  /* if set, save sqlite3 db */
     char text_file_yes;	          /* if set, save the text version of dag */
+    char trace_file_yes;	  /* if set, save chrome trace event json */
     char nodes_file_yes;	  /* if set, save nodes separately */
     char edges_file_yes;	  /* if set, save edges separately */
     char strings_file_yes;	  /* if set, save strings separately */
@@ -132,6 +133,7 @@ extern "C" {
     0,				/* dot_file */
     0,				/* sqlite_file */
     0,				/* text_file */
+    0,				/* trace_file */
     0,				/* nodes_file */	
     0,				/* edges_file */	
     0,			 /* strings_file */	
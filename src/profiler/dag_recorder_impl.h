@@ -120,6 +120,7 @@ int dr_gen_gpl(dr_pi_dag * G);
 int dr_gen_basic_stat(dr_pi_dag * G);
 int dr_gen_dot(dr_pi_dag * G);
 int dr_gen_text(dr_pi_dag * G);
+int dr_gen_trace(dr_pi_dag * G);
 
 int interpolate_counters(dr_pi_dag * G);
 
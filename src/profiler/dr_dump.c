@@ -815,6 +815,7 @@ void dr_dump_() {
     dr_gen_gpl(G);
     dr_gen_dot(G);
     dr_gen_text(G);
+    dr_gen_trace(G);
     dr_destroy_pi_dag(G);
   }
 }
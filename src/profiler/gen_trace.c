@@ -0,0 +1,163 @@
+/*
+ * gen_trace.c
+ */
+
+/*
+   write the dag in Chrome Trace Event Format (<prefix>.json),
+   which chrome://tracing and Perfetto UI (ui.perfetto.dev) open.
+
+   - each worker has a track (tid = worker). nodes that ran on
+     more than one worker (worker == -1) go to an extra track
+     "mixed" (tid = num_workers)
+   - each leaf (or collapsed) node is a complete ("X") event
+   - a create/create_cont edge whose ends are on different
+     tracks is a flow arrow from the creator to the stealer
+   - clocks are written as if they were nanoseconds
+ */
+
+#include <errno.h>
+#include <string.h>
+#define DAG_RECORDER 2
+#include "dag_recorder_impl.h"
+
+/* track of node g */
+static long
+dr_pi_dag_node_track(dr_pi_dag_node * g, dr_pi_dag * G) {
+  if (g->info.worker < 0 || g->info.worker >= G->num_workers) {
+    return G->num_workers;
+  } else {
+    return g->info.worker;
+  }
+}
+
+/* write clock t in microseconds */
+static void
+dr_trace_put_clock(FILE * wp, dr_clock_t t) {
+  fprintf(wp, "%llu.%03llu", t / 1000, t % 1000);
+}
+
+/* write s as a json string */
+static void
+dr_trace_put_str(FILE * wp, const char * s) {
+  fputc('"', wp);
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\') {
+      fprintf(wp, "\\%c", c);
+    } else if (c < 0x20) {
+      fprintf(wp, "\\u%04x", c);
+    } else {
+      fputc(c, wp);
+    }
+  }
+  fputc('"', wp);
+}
+
+static void
+dr_trace_gen_track_name(FILE * wp, long tid, const char * name) {
+  fprintf(wp,
+	  ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%ld,"
+	  "\"args\":{\"name\":\"%s\"}}", tid, name);
+}
+
+static void
+dr_pi_dag_node_gen_trace(long idx, dr_pi_dag_node * g,
+			 dr_pi_dag * G, FILE * wp) {
+  dr_pi_string_table * S = G->S;
+  const char * C = S->C;
+  long * I = S->I;
+  fprintf(wp, ",\n{\"name\":\"%s\",\"cat\":\"dag\",\"ph\":\"X\",\"pid\":0,"
+	  "\"tid\":%ld,\"ts\":",
+	  dr_dag_node_kind_to_str(g->info.kind), dr_pi_dag_node_track(g, G));
+  dr_trace_put_clock(wp, g->info.start.t);
+  fprintf(wp, ",\"dur\":");
+  dr_trace_put_clock(wp, g->info.end.t - g->info.start.t);
+  fprintf(wp, ",\"args\":{\"node\":%ld,\"t_1\":%llu,\"t_inf\":%llu,"
+	  "\"cpu\":%d,\"start\":",
+	  idx, g->info.t_1, g->info.t_inf, g->info.cpu);
+  dr_trace_put_str(wp, C + I[g->info.start.pos.file_idx]);
+  fprintf(wp, ",\"start_line\":%ld,\"end\":", g->info.start.pos.line);
+  dr_trace_put_str(wp, C + I[g->info.end.pos.file_idx]);
+  fprintf(wp, ",\"end_line\":%ld}}", g->info.end.pos.line);
+}
+
+/* a flow arrow from the end of u to the start of v, if they
+   are on different tracks */
+static void
+dr_pi_dag_edge_gen_trace(long idx, dr_pi_dag_edge * e,
+			 dr_pi_dag * G, FILE * wp) {
+  dr_pi_dag_node * u = &G->T[e->u];
+  dr_pi_dag_node * v = &G->T[e->v];
+  long tu = dr_pi_dag_node_track(u, G);
+  long tv = dr_pi_dag_node_track(v, G);
+  const char * kind = dr_dag_edge_kind_to_str(e->kind);
+  if (tu == tv) return;
+  /* bind to the slice of u, which ends at this point */
+  fprintf(wp, ",\n{\"name\":\"%s\",\"cat\":\"steal\",\"ph\":\"s\","
+	  "\"id\":%ld,\"pid\":0,\"tid\":%ld,\"ts\":", kind, idx, tu);
+  dr_trace_put_clock(wp, u->info.end.t - (u->info.end.t > u->info.start.t));
+  fprintf(wp, "}");
+  fprintf(wp, ",\n{\"name\":\"%s\",\"cat\":\"steal\",\"ph\":\"f\","
+	  "\"bp\":\"e\",\"id\":%ld,\"pid\":0,\"tid\":%ld,\"ts\":",
+	  kind, idx, tv);
+  dr_trace_put_clock(wp, v->info.start.t);
+  fprintf(wp, "}");
+}
+
+static int
+dr_pi_dag_gen_trace(dr_pi_dag * G, FILE * wp) {
+  long n = G->n;
+  long m = G->m;
+  dr_pi_dag_node * T = G->T;
+  dr_pi_dag_edge * E = G->E;
+  long i;
+  fprintf(wp, "{\"displayTimeUnit\":\"ns\",\n"
+	  "\"otherData\":{\"clock\":\"1 clock is shown as 1 ns\"},\n"
+	  "\"traceEvents\":[\n"
+	  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+	  "\"args\":{\"name\":\"dag recorder\"}}");
+  for (i = 0; i < G->num_workers; i++) {
+    char name[32];
+    sprintf(name, "worker %ld", i);
+    dr_trace_gen_track_name(wp, i, name);
+  }
+  dr_trace_gen_track_name(wp, G->num_workers, "mixed");
+  for (i = 0; i < n; i++) {
+    dr_pi_dag_node * g = &T[i];
+    if (g->info.kind < dr_dag_node_kind_section
+	|| g->subgraphs_begin_offset == g->subgraphs_end_offset) {
+      dr_pi_dag_node_gen_trace(i, g, G, wp);
+    }
+  }
+  for (i = 0; i < m; i++) {
+    dr_pi_dag_edge * e = &E[i];
+    if (e->kind == dr_dag_edge_kind_create
+	|| e->kind == dr_dag_edge_kind_create_cont) {
+      dr_pi_dag_edge_gen_trace(i, e, G, wp);
+    }
+  }
+  fprintf(wp, "\n]}\n");
+  if (ferror(wp)) {
+    fprintf(stderr, "%s:%d:error: fprintf %s\n",
+	    __FILE__, __LINE__, strerror(errno));
+    return 0;
+  } else {
+    return 1;
+  }
+}
+
+int dr_gen_trace(dr_pi_dag * G) {
+  if (!GS.opts.trace_file_yes) {
+    return 1;
+  } else {
+    FILE * wp = dr_pi_dag_open_to_write(GS.opts.dag_file_prefix, ".json",
+					"trace", GS.opts.verbose_level >= 1);
+    if (!wp) {
+      return 0;
+    } else {
+      int r = dr_pi_dag_gen_trace(G, wp);
+      fclose(wp);
+      return r;
+    }
+  }
+}
@@ -98,6 +98,8 @@ void dr_options_default_(dr_options * opts) {
       || getenv_bool("DR_DOT",                &opts->dot_file_yes)) {}
   if (getenv_bool("DAG_RECORDER_TEXT_FILE",   &opts->text_file_yes)
       || getenv_bool("DR_TEXT",               &opts->text_file_yes)) {}
+  if (getenv_bool("DAG_RECORDER_TRACE_FILE",  &opts->trace_file_yes)
+      || getenv_bool("DR_TRACE",              &opts->trace_file_yes)) {}
   /* NOTE: we do not set sqlite_file via environment variables */
   if (getenv_int("DAG_RECORDER_GPL_SIZE",     &opts->gpl_sz)
       || getenv_int("DR_GPL_SZ",              &opts->gpl_sz)) {}
@@ -160,6 +162,8 @@ dr_opts_print(dr_options * opts) {
 	    opts->dot_file_yes);
     fprintf(wp, "text_file_yes (DAG_RECORDER_TEXT_FILE,DR_TEXT) : %d\n", 
 	    opts->text_file_yes);
+    fprintf(wp, "trace_file_yes (DAG_RECORDER_TRACE_FILE,DR_TRACE) : %d\n", 
+	    opts->trace_file_yes);
     fprintf(wp, "gpl_sz (DAG_RECORDER_GPL_SIZE,DR_GPL_SZ) : %d\n", 
 	    opts->gpl_sz);
     fprintf(wp, "text_file_sep (DAG_RECORDER_TEXT_FILE_SEP,DR_TEXT_SEP) : %s\n", 
@@ -114,6 +114,7 @@ int dr_read_and_analyze_dag_(const char * filename) {
     if (dr_gen_basic_stat(G) == 0) return 0;
     if (dr_gen_dot(G) == 0) return 0;
     if (dr_gen_gpl(G) == 0) return 0;
+    if (dr_gen_trace(G) == 0) return 0;
     return 1;
   } else {
     return 0;
@@ -15,16 +15,34 @@ files_in_order = [
     (0, "myth_create_1"),
     (0, "myth_create_2"),
     (0, "myth_create_join_many"),
+    (0, "myth_create_parent_first"),
+    (0, "myth_detach"),
+    (0, "myth_stack_cache"),
+    (0, "myth_pickle"),
+    (0, "myth_stats"),
+    (0, "myth_active_workers"),
+    (0, "myth_priority"),
+    (0, "myth_create_on"),
+    (0, "myth_pinned"),
+    (0, "myth_runqueue_empty"),
+    (0, "myth_future"),
+    (0, "mtbb_parallel_for_lazy"),
+    (0, "mtbb_parallel_algos"),
+    (0, "myth_steal_many"),
+    (0, "myth_idle_park"),
     (0, "myth_yield_0"),
     (0, "myth_yield_1"),
     (0, "myth_yield_2"),
     (0, "myth_sleep_queue"),
     (0, "myth_lock"),
+    (0, "myth_adaptive_lock"),
     (0, "myth_trylock"),
     (0, "myth_mixlock"),
+    (0, "myth_rwlock"),
     (0, "myth_cond_signal"),
     (0, "myth_cond_broadcast_0"),
     (0, "myth_cond_broadcast_1"),
+    (0, "myth_timedwait"),
     (0, "myth_barrier"),
     (0, "myth_join_counter"),
     (0, "myth_felock"),
@@ -51,6 +69,7 @@ files_in_order = [
     (0, "pth_create_2"),
     (0, "pth_lock"),
     (0, "pth_mixlock"),
+    (0, "pth_rwlock"),
     (0, "pth_mutex_initializer"),
     (0, "pth_trylock"),
     (0, "pth_yield"),
@@ -99,7 +118,7 @@ wr("""
 
 wr("""
 common_cflags = -I$(abs_top_srcdir)/include
-common_cxxflags = $(common_cflags)
+common_cxxflags = $(common_cflags) -I$(abs_top_srcdir)/src
 myth_ldadd = $(abs_top_srcdir)/src/libmyth.la
 myth_ld_ldadd = $(abs_top_srcdir)/src/libmyth-ld.la
 myth_dl_ldadd = $(abs_top_srcdir)/src/libmyth-dl.la -ldl
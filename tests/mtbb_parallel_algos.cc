@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <myth/myth.h>
+#include <mtbb/parallel_sort.h>
+#include <mtbb/parallel_scan.h>
+#include <mtbb/parallel_invoke.h>
+
+/* parallel_sort agrees with std::sort, also on inputs full of
+   duplicates, already sorted or reversed, and with a comparator;
+   parallel_scan agrees with a serial prefix sum whatever the
+   grainsize; parallel_invoke calls each of 1, 2 or more functions
+   exactly once */
+
+/* ---------------- parallel_sort ---------------- */
+
+/* kinds of input */
+enum { in_random, in_dup, in_one, in_sorted, in_reversed, n_inputs };
+
+void fill(std::vector<long>& a, int kind) {
+  long n = a.size();
+  long i;
+  for (i = 0; i < n; i++) {
+    switch (kind) {
+    case in_random:   a[i] = random(); break;
+    case in_dup:      a[i] = random() % 3; break;
+    case in_one:      a[i] = 7; break;
+    case in_sorted:   a[i] = i; break;
+    case in_reversed: a[i] = n - i; break;
+    }
+  }
+}
+
+int check_sort(long n, int kind, int greater) {
+  std::vector<long> a(n);
+  fill(a, kind);
+  std::vector<long> b(a);
+  if (greater) {
+    mtbb::parallel_sort(a.begin(), a.end(), std::greater<long>());
+    std::sort(b.begin(), b.end(), std::greater<long>());
+  } else {
+    mtbb::parallel_sort(a);
+    std::sort(b.begin(), b.end());
+  }
+  long i;
+  for (i = 0; i < n; i++) {
+    if (a[i] != b[i]) {
+      printf("NG: sort n=%ld input %d greater %d: a[%ld] = %ld != %ld\n",
+             n, kind, greater, i, a[i], b[i]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* ---------------- parallel_scan ---------------- */
+
+struct range {
+  long a;
+  long b;
+  long g;
+  range(long a_, long b_, long g_) : a(a_), b(b_), g(g_) {}
+  long begin() const { return a; }
+  long end() const { return b; }
+  long grainsize() const { return g; }
+  bool empty() const { return a >= b; }
+  bool is_divisible() const { return b - a > g; }
+};
+
+struct scan_body {
+  const long * x;
+  long * y;
+  scan_body(const long * x_, long * y_) : x(x_), y(y_) {}
+  long operator() (const range& r, long sum, bool is_final) const {
+    long i;
+    for (i = r.begin(); i < r.end(); i++) {
+      sum += x[i];
+      if (is_final) y[i] = sum;
+    }
+    return sum;
+  }
+};
+
+struct plus {
+  long operator() (long p, long q) const { return p + q; }
+};
+
+int check_scan(long n, long grainsize) {
+  std::vector<long> x(n + 1);
+  std::vector<long> y(n + 1, -1);
+  long i;
+  for (i = 0; i < n; i++) {
+    x[i] = random() % 1000 - 500;
+  }
+  long total = mtbb::parallel_scan(range(0, n, grainsize), 0L,
+                                   scan_body(&x[0], &y[0]), plus());
+  long sum = 0;
+  for (i = 0; i < n; i++) {
+    sum += x[i];
+    if (y[i] != sum) {
+      printf("NG: scan n=%ld grainsize %ld: y[%ld] = %ld != %ld\n",
+             n, grainsize, i, y[i], sum);
+      return 0;
+    }
+  }
+  if (total != sum) {
+    printf("NG: scan n=%ld grainsize %ld: returned %ld != %ld\n",
+           n, grainsize, total, sum);
+    return 0;
+  }
+  if (y[n] != -1) {
+    printf("NG: scan n=%ld grainsize %ld: wrote past the range\n",
+           n, grainsize);
+    return 0;
+  }
+  return 1;
+}
+
+/* ---------------- parallel_invoke ---------------- */
+
+long called[6];
+
+struct call {
+  int i;
+  call(int i_) : i(i_) {}
+  void operator() () const {
+    __sync_fetch_and_add(&called[i], 1);
+  }
+};
+
+int check_invoke(int n) {
+  int i;
+  for (i = 0; i < 6; i++) called[i] = 0;
+  switch (n) {
+  case 1: mtbb::parallel_invoke(call(0)); break;
+  case 2: mtbb::parallel_invoke(call(0), call(1)); break;
+  case 3: mtbb::parallel_invoke(call(0), call(1), call(2)); break;
+  case 6: mtbb::parallel_invoke(call(0), call(1), call(2),
+                                call(3), call(4), call(5)); break;
+  }
+  for (i = 0; i < 6; i++) {
+    long expected = (i < n);
+    if (called[i] != expected) {
+      printf("NG: invoke %d functions: function %d called %ld times\n",
+             n, i, called[i]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char ** argv) {
+  long n = (argc > 1 ? atol(argv[1]) : 100000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  /* around the cutoff to std::sort, and n */
+  long ns[] = { 0, 1, 2, 10,
+                MTBB_PARALLEL_SORT_CUTOFF, MTBB_PARALLEL_SORT_CUTOFF + 1,
+                n };
+  long grainsizes[] = { 1, 7, 1000, n };
+  int invokes[] = { 1, 2, 3, 6 };
+  int k, kind, g;
+  myth_globalattr_set_n_workers(0, n_workers);
+  srandom(12345);
+  for (k = 0; k < (int)(sizeof(ns) / sizeof(ns[0])); k++) {
+    for (kind = 0; kind < n_inputs; kind++) {
+      if (!check_sort(ns[k], kind, 0)) return 1;
+      if (!check_sort(ns[k], kind, 1)) return 1;
+    }
+    for (g = 0; g < (int)(sizeof(grainsizes) / sizeof(grainsizes[0])); g++) {
+      if (!check_scan(ns[k], grainsizes[g])) return 1;
+    }
+  }
+  for (k = 0; k < (int)(sizeof(invokes) / sizeof(invokes[0])); k++) {
+    if (!check_invoke(invokes[k])) return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <myth/myth.h>
+#include <mtbb/parallel_for.h>
+
+/* index-based parallel_for with auto_partitioner visits every
+   index exactly once, whatever the chunk, including a tail
+   shorter than a chunk, and nothing of an empty range */
+
+long * hits;
+
+struct count {
+  void operator() (long i) const {
+    __sync_fetch_and_add(&hits[i], 1);
+  }
+};
+
+/* check that exactly first, first + step, ... (< last) were hit */
+int check(long first, long last, long step, long n) {
+  long i;
+  for (i = 0; i < n; i++) {
+    long expected = (first <= i && i < last && (i - first) % step == 0);
+    if (hits[i] != expected) {
+      printf("NG: [%ld,%ld) step %ld: index %ld hit %ld times\n",
+             first, last, step, i, hits[i]);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int run(long first, long last, long step, long chunk, long n) {
+  memset(hits, 0, sizeof(long) * n);
+  if (step == 1) {
+    if (chunk) {
+      mtbb::parallel_for(first, last, count(), mtbb::auto_partitioner(chunk));
+    } else {
+      mtbb::parallel_for(first, last, count(), mtbb::auto_partitioner());
+    }
+  } else {
+    if (chunk) {
+      mtbb::parallel_for(first, last, step, count(), mtbb::auto_partitioner(chunk));
+    } else {
+      mtbb::parallel_for(first, last, step, count(), mtbb::auto_partitioner());
+    }
+  }
+  return check(first, last, step, n);
+}
+
+int main(int argc, char ** argv) {
+  long n = (argc > 1 ? atol(argv[1]) : 100000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  long chunks[] = { 0, 1, 64, 1000, 1000000 };
+  int k;
+  hits = (long *)calloc(sizeof(long), n);
+  myth_globalattr_set_n_workers(0, n_workers);
+  for (k = 0; k < (int)(sizeof(chunks) / sizeof(chunks[0])); k++) {
+    long c = chunks[k];
+    /* n - 3 is not a multiple of 64 or 1000, nor (n - 3) / 7 */
+    if (!run(0, n, 1, c, n)) return 1;
+    if (!run(3, n, 1, c, n)) return 1;
+    if (!run(3, n, 7, c, n)) return 1;
+    /* empty ranges */
+    if (!run(5, 5, 1, c, n)) return 1;
+    if (!run(5, 5, 7, c, n)) return 1;
+    if (!run(9, 5, 1, c, n)) return 1;
+    if (!run(9, 5, 7, c, n)) return 1;
+  }
+  free(hits);
+  printf("OK\n");
+  return 0;
+}
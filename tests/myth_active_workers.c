@@ -0,0 +1,79 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <myth/myth.h>
+
+/* shrink the workers to one, check no thread runs on
+   inactive workers, then grow them back */
+
+void * f(void * x) {
+  long i = (long)x;
+  if (i % 7 == 0) myth_yield();
+  return (void *)(long)myth_get_worker_num();
+}
+
+/* give inactive workers time to reach their scheduler and sleep */
+void settle(void) {
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+  } while ((t1.tv_sec - t0.tv_sec) * 1000000000L
+	   + (t1.tv_nsec - t0.tv_nsec) < 100000000L);
+}
+
+/* run nthreads threads and return the number of those that ran
+   on workers >= n_active */
+long run(myth_thread_t * th, long nthreads, int n_active) {
+  myth_thread_attr_t attr;
+  long i, n = 0;
+  myth_thread_attr_init(&attr);
+  attr.child_first = 0;
+  for (i = 0; i < nthreads; i++) {
+    int c = myth_create_ex(&th[i], &attr, f, (void *)i);
+    assert(c == 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    if ((long)ret >= n_active) n++;
+  }
+  return n;
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 1000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  int n_rounds = (argc > 3 ? atoi(argv[3]) : 3);
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  int r, c;
+  myth_globalattr_set_n_workers(0, n_workers);
+  c = myth_get_num_active_workers();
+  assert(c == n_workers);
+  c = myth_set_num_active_workers(0);
+  assert(c == 1);
+  c = myth_set_num_active_workers(n_workers + 1);
+  assert(c == n_workers);
+  for (r = 0; r < n_rounds; r++) {
+    long n;
+    c = myth_set_num_active_workers(1);
+    assert(c == 1);
+    c = myth_get_num_active_workers();
+    assert(c == 1);
+    settle();
+    /* the main thread stays on worker 0 with nobody stealing it */
+    n = run(th, nthreads, 1);
+    if (n) {
+      printf("NG: %ld threads ran on inactive workers\n", n);
+      return 1;
+    }
+    c = myth_set_num_active_workers(n_workers);
+    assert(c == n_workers);
+    run(th, nthreads, n_workers);
+  }
+  free(th);
+  printf("OK\n");
+  return 0;
+}
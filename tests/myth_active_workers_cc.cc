@@ -0,0 +1 @@
+#include "myth_active_workers.c"
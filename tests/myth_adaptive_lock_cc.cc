@@ -0,0 +1 @@
+#include "myth_adaptive_lock.c"
@@ -0,0 +1,75 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <myth/myth.h>
+
+/* a thread created by myth_create_on starts on the worker */
+
+void * f(void * x) {
+  (void)x;
+  return (void *)(long)myth_get_worker_num();
+}
+
+void * g(void * x) {
+  long i = (long)x;
+  if (i % 7 == 0) myth_yield();
+  return (void *)(i * i);
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 1000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_attr_t attr;
+  long i;
+  int w;
+  myth_globalattr_set_n_workers(0, n_workers);
+  for (i = 0; i < 10; i++) {
+    for (w = 0; w < n_workers; w++) {
+      void * ret;
+      myth_thread_t t = myth_create_on(w, f, 0);
+      myth_join(t, &ret);
+      if (ret != (void *)(long)w) {
+	printf("NG: created on %d, ran on %ld\n", w, (long)ret);
+	return 1;
+      }
+    }
+  }
+  /* out of range: created as usual */
+  {
+    void * ret;
+    myth_join(myth_create_on(n_workers, g, (void *)3), &ret);
+    assert(ret == (void *)9);
+  }
+  /* a zero-filled attribute asks for no worker, as a default one */
+  {
+    int w0 = 0, w1 = 0;
+    memset(&attr, 0, sizeof(attr));
+    myth_thread_attr_getworker(&attr, &w0);
+    myth_thread_attr_init(&attr);
+    myth_thread_attr_getworker(&attr, &w1);
+    if (w0 != -1 || w1 != -1) {
+      printf("NG: worker %d of a zero-filled attr, %d of a default one\n",
+	     w0, w1);
+      return 1;
+    }
+  }
+  /* many at once, child first or not */
+  myth_thread_attr_init(&attr);
+  for (i = 0; i < nthreads; i++) {
+    myth_thread_attr_setworker(&attr, (int)(i % n_workers));
+    attr.child_first = (int)(i % 2);
+    int c = myth_create_ex(&th[i], &attr, g, (void *)i);
+    assert(c == 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    assert(ret == (void *)(i * i));
+  }
+  free(th);
+  printf("OK\n");
+  return 0;
+}
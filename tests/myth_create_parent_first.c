@@ -0,0 +1,38 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+/* create many threads without switching to them, so that
+   they pile up in the creator's run queue */
+
+void * f(void * x) {
+  long i = (long)x;
+  return (void *)(i * i);
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 10000);
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_attr_t attr;
+  long i;
+  myth_thread_attr_init(&attr);
+  attr.child_first = 0;
+  attr.stacksize = 16 * 1024;
+  for (i = 0; i < nthreads; i++) {
+    int r = myth_create_ex(&th[i], &attr, f, (void *)i);
+    assert(r == 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    if (ret != (void *)(i * i)) {
+      printf("NG\n");
+      return 1;
+    }
+  }
+  free(th);
+  printf("OK\n");
+  return 0;
+}
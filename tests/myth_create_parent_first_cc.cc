@@ -0,0 +1 @@
+#include "myth_create_parent_first.c"
@@ -0,0 +1,44 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+volatile long n_finished = 0;
+
+void * f(void * x) {
+  long i = (long)x;
+  /* some threads finish right away, others after a while */
+  long j;
+  for (j = 0; j < i % 4; j++) myth_yield();
+  __sync_fetch_and_add(&n_finished, 1);
+  return (void *)(i * i);
+}
+
+int main(int argc, char ** argv) {
+  int nthreads = (argc > 1 ? atoi(argv[1]) : 1000);
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  long i;
+  /* detach threads, some of which have finished already */
+  for (i = 0; i < nthreads; i++) {
+    th[i] = myth_create(f, (void *)i);
+    if (i % 2) myth_yield();
+    myth_detach(th[i]);
+  }
+  while (n_finished < nthreads) myth_yield();
+  /* tryjoin until they finish */
+  for (i = 0; i < nthreads; i++) {
+    th[i] = myth_create(f, (void *)i);
+  }
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    while (myth_tryjoin(th[i], &ret) != 0) myth_yield();
+    if (ret != (void *)(i * i)) {
+      printf("NG\n");
+      return 1;
+    }
+  }
+  free(th);
+  printf("OK\n");
+  return 0;
+}
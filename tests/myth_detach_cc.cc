@@ -0,0 +1 @@
+#include "myth_detach.c"
@@ -0,0 +1,132 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <myth/myth.h>
+
+/* threads waiting on a future before and after it is set,
+   continuations attached before and after it, a value
+   too large to be stored inline, and a value written in place
+   between myth_future_claim and myth_future_publish */
+
+typedef struct {
+  long x[16];
+} big_t;
+
+myth_future_t f[1];
+myth_future_t g[1];
+myth_future_t h[1];
+long n_conts = 0;
+long last_cont = -1;
+
+void * getter(void * arg) {
+  long v = 0;
+  (void)arg;
+  myth_future_get(f, &v);
+  return (void *)v;
+}
+
+void * big_getter(void * arg) {
+  big_t v;
+  long i;
+  (void)arg;
+  myth_future_get(g, &v);
+  for (i = 0; i < 16; i++) {
+    if (v.x[i] != i * i) return (void *)1;
+  }
+  return 0;
+}
+
+void cont(myth_future_t * fu, void * arg) {
+  long i = (long)arg;
+  assert(myth_future_ready(fu));
+  assert(*(long *)myth_future_value(fu) == 12345);
+  /* attached before set -> called in the attached order */
+  assert(i == 0 || last_cont < i);
+  last_cont = i;
+  __sync_fetch_and_add(&n_conts, 1);
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 1000);
+  long n_cont = 100;
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_t * bh = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_future_cont_t * c
+    = (myth_future_cont_t *)calloc(sizeof(myth_future_cont_t), 2 * n_cont);
+  long v = 12345, w = 0;
+  big_t b;
+  long i;
+  int r;
+  myth_future_init(f, sizeof(long));
+  myth_future_init(g, sizeof(big_t));
+  assert(!myth_future_ready(f));
+  for (i = 0; i < n_cont; i++) {
+    myth_future_then(f, &c[i], cont, (void *)(i + 1));
+  }
+  assert(n_conts == 0);
+  for (i = 0; i < nthreads; i++) {
+    th[i] = myth_create(getter, 0);
+    bh[i] = myth_create(big_getter, 0);
+  }
+  /* let some of them block */
+  for (i = 0; i < 10; i++) {
+    myth_yield();
+  }
+  r = myth_future_set(f, &v);
+  assert(r == 0);
+  assert(n_conts == n_cont);
+  w = 54321;
+  r = myth_future_set(f, &w);
+  assert(r == EBUSY);
+  for (i = 0; i < 16; i++) {
+    b.x[i] = i * i;
+  }
+  memcpy(myth_future_value(g), &b, sizeof(big_t));
+  r = myth_future_set(g, 0);
+  assert(r == 0);
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    assert((long)ret == 12345);
+    myth_join(bh[i], &ret);
+    assert(ret == 0);
+  }
+  /* attached after set -> called right away */
+  for (i = 0; i < n_cont; i++) {
+    myth_future_then(f, &c[n_cont + i], cont, 0);
+    assert(n_conts == n_cont + i + 1);
+  }
+  assert(myth_future_ready(f));
+  myth_future_get(f, &w);
+  assert(w == 12345);
+  /* a set future cannot be claimed */
+  r = myth_future_claim(f);
+  assert(r == EBUSY);
+  /* nor can a claimed one be claimed or set again */
+  myth_future_init(h, sizeof(long));
+  r = myth_future_claim(h);
+  assert(r == 0);
+  r = myth_future_claim(h);
+  assert(r == EBUSY);
+  w = 54321;
+  r = myth_future_set(h, &w);
+  assert(r == EBUSY);
+  assert(!myth_future_ready(h));
+  *(long *)myth_future_value(h) = 777;
+  r = myth_future_publish(h);
+  assert(r == 0);
+  assert(myth_future_ready(h));
+  myth_future_get(h, &w);
+  assert(w == 777);
+  myth_future_destroy(h);
+  myth_future_destroy(f);
+  myth_future_destroy(g);
+  free(c);
+  free(th);
+  free(bh);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1 @@
+#include "myth_future.c"
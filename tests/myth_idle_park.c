@@ -0,0 +1,49 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <myth/myth.h>
+
+/* with MYTH_IDLE_POLICY=park, workers park whenever the main
+   thread pauses; each round must wake them up again */
+
+void * f(void * x) {
+  long i = (long)x;
+  if (i % 7 == 0) myth_yield();
+  return (void *)(i * i);
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 1000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  int n_rounds = (argc > 3 ? atoi(argv[3]) : 10);
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_attr_t attr;
+  long i;
+  int r;
+  setenv("MYTH_IDLE_POLICY", "park", 1);
+  myth_globalattr_set_n_workers(0, n_workers);
+  myth_thread_attr_init(&attr);
+  attr.child_first = 0;
+  attr.stacksize = 16 * 1024;
+  for (r = 0; r < n_rounds; r++) {
+    /* let the other workers go idle and park */
+    usleep(20 * 1000);
+    for (i = 0; i < nthreads; i++) {
+      int c = myth_create_ex(&th[i], &attr, f, (void *)i);
+      assert(c == 0);
+    }
+    for (i = 0; i < nthreads; i++) {
+      void * ret;
+      myth_join(th[i], &ret);
+      if (ret != (void *)(i * i)) {
+	printf("NG\n");
+	return 1;
+      }
+    }
+  }
+  free(th);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1 @@
+#include "myth_idle_park.c"
@@ -0,0 +1,113 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <myth/myth.h>
+
+volatile char * buf = 0;
+volatile int go = 0;
+
+/* fill a buffer on the stack and wait until serialized,
+   cleared and deserialized */
+void * f(void * x) {
+  long i = (long)x;
+  char a[1024];
+  long s = 0;
+  long j;
+  for (j = 0; j < (long)sizeof(a); j++) a[j] = (char)(i + j);
+  buf = a;
+  while (!go) myth_yield();
+  for (j = 0; j < (long)sizeof(a); j++) s += a[j];
+  return (void *)s;
+}
+
+/* serialize a thread, lose its stack and descriptor and bring it
+   back with myth_deserialize_into or, if ext, its myth_ext_ variant,
+   whose descriptor comes from outside the workers' caches */
+int roundtrip(long i, int ext) {
+  long j, s = 0;
+  myth_thread_t th, t;
+  myth_pickle_t * p;
+  size_t size;
+  void * ret;
+  uintptr_t a;
+  buf = 0;
+  go = 0;
+  for (j = 0; j < 1024; j++) s += (char)(i + j);
+  th = myth_create(f, (void *)i);
+  while (!buf) myth_yield();
+  /* take th out of run queues */
+  do {
+    t = myth_steal();
+    if (t && t != th) myth_import(t);
+  } while (t != th);
+  size = myth_pickle_size(th);
+  if (size > 65536) {
+    printf("NG: pickle of %lu bytes\n", (unsigned long)size);
+    return 0;
+  }
+  p = (myth_pickle_t *)malloc(size);
+  myth_serialize(th, p);
+  /* a range surely covering the stack of th */
+  a = ((uintptr_t)buf >> 26 << 26) - ((uintptr_t)1 << 26);
+  if (!myth_pickle_valid(p, size)) {
+    printf("NG: good pickle rejected\n");
+    return 0;
+  }
+  /* a pickle with a broken magic number or of another version
+     is rejected */
+  for (j = 0; j < 8; j += 4) {
+    ((unsigned char *)p)[j] ^= 0xff;
+    if (myth_pickle_valid(p, size)
+	|| myth_deserialize_into(p, (void *)a, (size_t)3 << 26)) {
+      printf("NG: bad pickle (byte %ld) accepted\n", j);
+      return 0;
+    }
+    ((unsigned char *)p)[j] ^= 0xff;
+  }
+  /* so is a truncated one, whether or not the header is all there */
+  if (myth_pickle_valid(p, size - 1) || myth_pickle_valid(p, 8)) {
+    printf("NG: short pickle accepted\n");
+    return 0;
+  }
+  /* lose the stack and bring it back from the pickle */
+  memset((char *)buf, 0, 1024);
+  myth_release_desc(th);
+  if (ext) {
+    t = myth_ext_deserialize_into(p, (void *)a, (size_t)3 << 26);
+  } else {
+    t = myth_deserialize_into(p, (void *)a, (size_t)3 << 26);
+  }
+  if (!t) {
+    printf("NG: deserialize failed (ext = %d)\n", ext);
+    return 0;
+  }
+  free(p);
+  go = 1;
+  if (ext) {
+    myth_ext_import(t);
+  } else {
+    myth_import(t);
+  }
+  /* frees the descriptor of t */
+  myth_join(t, &ret);
+  if (ret != (void *)s) {
+    printf("NG (ext = %d)\n", ext);
+    return 0;
+  }
+  return 1;
+}
+
+int main() {
+  /* cache no descriptors or stacks, so that every one freed is
+     released; an external descriptor must not be */
+  setenv("MYTH_STACK_CACHE_HIGH", "0", 1);
+  setenv("MYTH_STACK_CACHE_MAX", "0", 1);
+  if (!roundtrip(3, 0)) return 1;
+  if (!roundtrip(5, 1)) return 1;
+  if (!roundtrip(7, 0)) return 1;
+  printf("OK\n");
+  return 0;
+}
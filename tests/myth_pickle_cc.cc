@@ -0,0 +1 @@
+#include "myth_pickle.c"
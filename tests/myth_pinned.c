@@ -0,0 +1,75 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+/* pinned threads stay on their workers across yields and
+   mutex waits, while other threads are stolen around them */
+
+myth_mutex_t m[1];
+long counter = 0;
+int n_rounds = 100;
+
+void * pinned(void * x) {
+  int w = (int)(long)x;
+  long moved = 0;
+  int i;
+  for (i = 0; i < n_rounds; i++) {
+    myth_yield();
+    if (myth_get_worker_num() != w) moved++;
+    myth_mutex_lock(m);
+    counter++;
+    myth_yield();
+    myth_mutex_unlock(m);
+    if (myth_get_worker_num() != w) moved++;
+  }
+  return (void *)moved;
+}
+
+void * other(void * x) {
+  long i = (long)x;
+  myth_mutex_lock(m);
+  counter++;
+  myth_mutex_unlock(m);
+  if (i % 3 == 0) myth_yield();
+  return 0;
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 1000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  int n_pinned = 4 * n_workers;
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), n_pinned);
+  myth_thread_t * ot = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_attr_t attr;
+  long i;
+  myth_globalattr_set_n_workers(0, n_workers);
+  myth_mutex_init(m, 0);
+  myth_thread_attr_init(&attr);
+  attr.pinned = 1;
+  for (i = 0; i < n_pinned; i++) {
+    myth_thread_attr_setworker(&attr, (int)(i % n_workers));
+    int c = myth_create_ex(&th[i], &attr, pinned, (void *)(i % n_workers));
+    assert(c == 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    ot[i] = myth_create(other, (void *)i);
+  }
+  for (i = 0; i < nthreads; i++) {
+    myth_join(ot[i], 0);
+  }
+  for (i = 0; i < n_pinned; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    if (ret) {
+      printf("NG: pinned thread %ld moved %ld times\n", i, (long)ret);
+      return 1;
+    }
+  }
+  assert(counter == nthreads + n_pinned * n_rounds);
+  free(th);
+  free(ot);
+  printf("OK\n");
+  return 0;
+}
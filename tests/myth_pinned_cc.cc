@@ -0,0 +1 @@
+#include "myth_pinned.c"
@@ -0,0 +1,70 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+/* on one worker, threads of priority 3 run before those of
+   priority 0, except one of priority 0 after every 64 of 3 */
+
+int * order;
+int n_run = 0;
+
+void * f(void * x) {
+  order[n_run++] = (int)(long)x;
+  return x;
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 400);
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_attr_t attr;
+  long i, run = 0, n_high = 0;
+  int p, c;
+  order = (int *)calloc(sizeof(int), nthreads);
+  myth_globalattr_set_n_workers(0, 1);
+  myth_thread_attr_init(&attr);
+  attr.child_first = 0;
+  c = myth_thread_attr_getpriority(&attr, &p);
+  assert(c == 0 && p == 0);
+  c = myth_thread_attr_setpriority(&attr, -1);
+  assert(c == EINVAL);
+  c = myth_thread_attr_setpriority(&attr, 4);
+  assert(c == EINVAL);
+  for (i = 0; i < nthreads; i++) {
+    p = (i % 2 ? 3 : 0);
+    c = myth_thread_attr_setpriority(&attr, p);
+    assert(c == 0);
+    c = myth_create_ex(&th[i], &attr, f, (void *)(long)p);
+    assert(c == 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    assert(ret == (void *)(long)(i % 2 ? 3 : 0));
+  }
+  assert(n_run == nthreads);
+  for (i = 0; i < nthreads; i++) {
+    if (order[i] == 3) {
+      run++;
+      n_high++;
+      if (run > 64) {
+	printf("NG: %ld threads of priority 3 in a row\n", run);
+	return 1;
+      }
+    } else {
+      /* while threads of priority 3 are waiting, only the guard
+	 lets one of priority 0 run */
+      if (n_high < nthreads / 2 && run != 64) {
+	printf("NG: priority 0 ran after %ld of priority 3\n", run);
+	return 1;
+      }
+      run = 0;
+    }
+  }
+  free(order);
+  free(th);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,50 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+/* on one worker, the runqueue holds the parent of a child created
+   child-first, and a child created parent-first until it runs */
+
+void * child(void * x) {
+  (void)x;
+  return (void *)(long)myth_runqueue_is_empty();
+}
+
+int main(int argc, char ** argv) {
+  int n_rounds = (argc > 1 ? atoi(argv[1]) : 100);
+  myth_thread_attr_t attr;
+  int r, c;
+  myth_globalattr_set_n_workers(0, 1);
+  myth_thread_attr_init(&attr);
+  c = myth_runqueue_is_empty();
+  assert(c);
+  for (r = 0; r < n_rounds; r++) {
+    myth_thread_t th;
+    void * ret;
+    /* child-first; the child sees its parent in the runqueue */
+    attr.child_first = 1;
+    c = myth_create_ex(&th, &attr, child, 0);
+    assert(c == 0);
+    myth_join(th, &ret);
+    if (ret) {
+      printf("NG: the parent was not in the runqueue\n");
+      return 1;
+    }
+    c = myth_runqueue_is_empty();
+    assert(c);
+    /* parent-first; the child waits in the runqueue */
+    attr.child_first = 0;
+    c = myth_create_ex(&th, &attr, child, 0);
+    assert(c == 0);
+    c = myth_runqueue_is_empty();
+    assert(!c);
+    myth_join(th, &ret);
+    assert(ret);
+    c = myth_runqueue_is_empty();
+    assert(c);
+  }
+  printf("OK\n");
+  return 0;
+}
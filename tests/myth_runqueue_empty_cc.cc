@@ -0,0 +1 @@
+#include "myth_runqueue_empty.c"
@@ -0,0 +1,128 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+/* threads repeatedly read- or write-lock a lock.
+   writers increment x and y (yielding in between) and 
+   readers check x == y, for each preference and with
+   and without per-worker reader counters */
+
+typedef struct {
+  long nops_per_thread;
+  long a;
+  long b;
+  long r;
+  long * p;			/* p[0] = x, p[1] = y, p[2] = ng */
+  myth_rwlock_t * l;
+} arg_t;
+
+void * f(void * arg_) {
+  arg_t * arg = (arg_t *)arg_;
+  long a = arg->a, b = arg->b;
+  long nops_per_thread = arg->nops_per_thread;
+  if (b - a == 1) {
+    long i;
+    for (i = 0; i < nops_per_thread; i++) {
+      long k = (a * 7 + i) % 16;
+      if (k == 0) {
+	myth_rwlock_wrlock(arg->l);
+	arg->p[0]++;
+	myth_yield();
+	arg->p[1]++;
+	myth_rwlock_unlock(arg->l);
+      } else if (k == 1) {
+	if (myth_rwlock_trywrlock(arg->l) == 0) {
+	  arg->p[0]++;
+	  arg->p[1]++;
+	  myth_rwlock_unlock(arg->l);
+	}
+      } else if (k == 2) {
+	if (myth_rwlock_tryrdlock(arg->l) == 0) {
+	  if (arg->p[0] != arg->p[1]) arg->p[2] = 1;
+	  myth_rwlock_unlock(arg->l);
+	}
+      } else {
+	myth_rwlock_rdlock(arg->l);
+	long x = arg->p[0];
+	if (k == 3) myth_yield();
+	if (x != arg->p[1] || x != arg->p[0]) arg->p[2] = 1;
+	myth_rwlock_unlock(arg->l);
+      }
+    }
+    arg->r = a;
+  } else {
+    long c = (a + b) / 2;
+    arg_t cargs[2] = { { nops_per_thread, a, c, 0, arg->p, arg->l }, 
+		       { nops_per_thread, c, b, 0, arg->p, arg->l } };
+    myth_thread_t tid = myth_create(f, cargs);
+    f(cargs + 1);
+    myth_join(tid, 0);
+    arg->r = cargs[0].r + cargs[1].r;
+  }
+  return 0;
+}
+
+int run(long nthreads, long nops_per_thread, int kind, int read_mostly) {
+  myth_rwlockattr_t attr;
+  myth_rwlock_t l[1];
+  long p[3] = { 0, 0, 0 };
+  myth_rwlockattr_init(&attr);
+  myth_rwlockattr_setkind(&attr, kind);
+  myth_rwlockattr_setreadmostly(&attr, read_mostly);
+  myth_rwlock_init(l, &attr);
+  arg_t arg[1] = { { nops_per_thread, 0, nthreads, 0, p, l } };
+  myth_thread_t tid = myth_create(f, arg);
+  myth_join(tid, 0);
+  /* the lock must be free again */
+  if (myth_rwlock_trywrlock(l) != 0) {
+    printf("NG: lock not free (kind = %d, read_mostly = %d)\n", 
+	   kind, read_mostly);
+    return 0;
+  }
+  myth_rwlock_unlock(l);
+  myth_rwlock_destroy(l);
+  if (arg->r != (nthreads - 1) * nthreads / 2 || p[0] != p[1] || p[2]) {
+    printf("NG: x = %ld, y = %ld, ng = %ld (kind = %d, read_mostly = %d)\n",
+	   p[0], p[1], p[2], kind, read_mostly);
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char ** argv) {
+  long nthreads        = (argc > 1 ? atol(argv[1]) : 50);
+  long nops_per_thread = (argc > 2 ? atol(argv[2]) : 1000);
+  int kinds[3] = { MYTH_RWLOCK_PREFER_READER,
+		   MYTH_RWLOCK_PREFER_WRITER,
+		   MYTH_RWLOCK_PREFER_WRITER_NONRECURSIVE };
+  int ok = 1;
+  int i, read_mostly;
+  myth_rwlock_t s[1] = { MYTH_RWLOCK_INITIALIZER };
+  /* statically initialized lock */
+  ok = ok && (myth_rwlock_rdlock(s) == 0);
+  ok = ok && (myth_rwlock_tryrdlock(s) == 0);
+  ok = ok && (myth_rwlock_trywrlock(s) == EBUSY);
+  ok = ok && (myth_rwlock_unlock(s) == 0);
+  ok = ok && (myth_rwlock_unlock(s) == 0);
+  ok = ok && (myth_rwlock_trywrlock(s) == 0);
+  ok = ok && (myth_rwlock_tryrdlock(s) == EBUSY);
+  ok = ok && (myth_rwlock_unlock(s) == 0);
+  if (!ok) {
+    printf("NG: MYTH_RWLOCK_INITIALIZER\n");
+    return 1;
+  }
+  for (read_mostly = 0; read_mostly < 2; read_mostly++) {
+    for (i = 0; i < 3; i++) {
+      ok = ok && run(nthreads, nops_per_thread, kinds[i], read_mostly);
+    }
+  }
+  if (ok) {
+    printf("OK\n");
+    return 0;
+  } else {
+    return 1;
+  }
+}
@@ -0,0 +1 @@
+#include "myth_rwlock.c"
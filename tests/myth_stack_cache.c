@@ -0,0 +1,49 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <myth/myth.h>
+
+/* touch a few pages of the stack, let others run, and check
+   they are intact */
+void * f(void * x) {
+  long i = (long)x;
+  volatile char a[16384];
+  memset((char *)a, (int)(i & 0xff), sizeof(a));
+  myth_yield();
+  long j;
+  for (j = 0; j < (long)sizeof(a); j += 1024) {
+    if (a[j] != (char)(i & 0xff)) return (void *)-1;
+  }
+  return (void *)(i * i);
+}
+
+myth_thread_t th[2000];
+
+int main(int argc, char ** argv) {
+  int nthreads = (argc > 1 ? atoi(argv[1]) : 2000);
+  int r;
+  long i;
+  /* keep a few stacks and release (or unmap) the rest */
+  setenv("MYTH_STACK_CACHE_HIGH", "8", 1);
+  setenv("MYTH_STACK_CACHE_MAX", "100", 1);
+  /* small arenas with guards, to use many of them */
+  setenv("MYTH_STACK_ARENA_SIZE", "4194304", 0);
+  setenv("MYTH_STACK_ARENA_GUARD", "1", 0);
+  for (r = 0; r < 3; r++) {
+    for (i = 0; i < nthreads; i++) {
+      th[i] = myth_create(f, (void *)i);
+    }
+    for (i = 0; i < nthreads; i++) {
+      void * ret;
+      myth_join(th[i], &ret);
+      if (ret != (void *)(i * i)) {
+	printf("NG\n");
+	return 1;
+      }
+    }
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1 @@
+#include "myth_stack_cache.c"
@@ -0,0 +1,85 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+void * f(void * x) {
+  myth_yield();
+  return x;
+}
+
+/* check the sums in s agree with the counters of each worker and pair */
+int check(myth_stats_t * s) {
+  int nw = s->n_workers;
+  myth_worker_stats_t t = { 0, 0, 0, 0, 0, 0, 0 };
+  int i, j;
+  for (i = 0; i < nw; i++) {
+    myth_worker_stats_t * w = &s->workers[i];
+    unsigned long long a = 0, h = 0;
+    for (j = 0; j < nw; j++) {
+      myth_steal_stats_t * st = &s->steals[i * nw + j];
+      if (st->n_misses != st->n_attempts - st->n_hits) return 0;
+      a += st->n_attempts;
+      h += st->n_hits;
+    }
+    if (a != w->n_steal_attempts || h != w->n_steal_hits) return 0;
+    if (w->n_steal_misses != a - h) return 0;
+    t.n_created += w->n_created;
+    t.n_steal_attempts += w->n_steal_attempts;
+    t.idle_ns += w->idle_ns;
+    if (w->queue_high_water > t.queue_high_water) {
+      t.queue_high_water = w->queue_high_water;
+    }
+  }
+  return (t.n_created == s->total.n_created
+	  && t.n_steal_attempts == s->total.n_steal_attempts
+	  && t.idle_ns == s->total.idle_ns
+	  && t.queue_high_water == s->total.queue_high_water);
+}
+
+int main(int argc, char ** argv) {
+  int nthreads = (argc > 1 ? atoi(argv[1]) : 1000);
+  myth_stats_t s0, s1;
+  myth_thread_t * th;
+  int nw, i;
+  setenv("MYTH_NUM_WORKERS", "2", 0);
+  nw = myth_get_num_workers();
+  s0.workers = (myth_worker_stats_t *)malloc(sizeof(myth_worker_stats_t) * nw);
+  s0.steals = (myth_steal_stats_t *)malloc(sizeof(myth_steal_stats_t) * nw * nw);
+  s1.workers = (myth_worker_stats_t *)malloc(sizeof(myth_worker_stats_t) * nw);
+  s1.steals = (myth_steal_stats_t *)malloc(sizeof(myth_steal_stats_t) * nw * nw);
+  th = (myth_thread_t *)malloc(sizeof(myth_thread_t) * nthreads);
+  myth_get_stats(&s0);
+  for (i = 0; i < nthreads; i++) {
+    th[i] = myth_create(f, 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    myth_join(th[i], 0);
+  }
+  myth_get_stats(&s1);
+  if (s1.n_workers != nw
+      || s1.total.n_created - s0.total.n_created < (unsigned long long)nthreads
+      || s1.total.queue_high_water < 1
+      || !check(&s0) || !check(&s1)) {
+    printf("NG\n");
+    return 1;
+  }
+  for (i = 0; i < nw; i++) {
+    if (s1.workers[i].idle_ns < s0.workers[i].idle_ns
+	|| s1.workers[i].n_steal_attempts < s0.workers[i].n_steal_attempts) {
+      printf("NG: worker %d\n", i);
+      return 1;
+    }
+  }
+  /* the totals alone */
+  s0.workers = 0;
+  s0.steals = 0;
+  myth_get_stats(&s0);
+  if (s0.total.n_created < s1.total.n_created) {
+    printf("NG\n");
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,44 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <myth/myth.h>
+
+/* flat parent-first creation with several workers, so that
+   thieves find many threads in a victim's queue and (with
+   MYTH_STEAL_MANY) take many of them at once */
+
+void * f(void * x) {
+  long i = (long)x;
+  if (i % 7 == 0) myth_yield();
+  return (void *)(i * i);
+}
+
+int main(int argc, char ** argv) {
+  long nthreads = (argc > 1 ? atol(argv[1]) : 10000);
+  int n_workers = (argc > 2 ? atoi(argv[2]) : 4);
+  const char * steal_many = (argc > 3 ? argv[3] : "8");
+  myth_thread_t * th = (myth_thread_t *)calloc(sizeof(myth_thread_t), nthreads);
+  myth_thread_attr_t attr;
+  long i;
+  setenv("MYTH_STEAL_MANY", steal_many, 1);
+  myth_globalattr_set_n_workers(0, n_workers);
+  myth_thread_attr_init(&attr);
+  attr.child_first = 0;
+  attr.stacksize = 16 * 1024;
+  for (i = 0; i < nthreads; i++) {
+    int r = myth_create_ex(&th[i], &attr, f, (void *)i);
+    assert(r == 0);
+  }
+  for (i = 0; i < nthreads; i++) {
+    void * ret;
+    myth_join(th[i], &ret);
+    if (ret != (void *)(i * i)) {
+      printf("NG\n");
+      return 1;
+    }
+  }
+  free(th);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1 @@
+#include "myth_steal_many.c"
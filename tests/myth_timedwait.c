@@ -0,0 +1,147 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <myth/myth.h>
+
+double cur_time() {
+  struct timeval tp[1];
+  gettimeofday(tp, 0);
+  return tp->tv_sec + tp->tv_usec * 1.0e-6;
+}
+
+/* absolute time dt seconds from now */
+struct timespec after(double dt) {
+  struct timeval tp[1];
+  struct timespec ts;
+  long ns;
+  gettimeofday(tp, 0);
+  ns = tp->tv_usec * 1000 + (long)(dt * 1.0e9);
+  ts.tv_sec = tp->tv_sec + ns / 1000000000;
+  ts.tv_nsec = ns % 1000000000;
+  return ts;
+}
+
+myth_mutex_t m[1];
+myth_cond_t c[1];
+volatile int flag = 0;
+
+void * hold_mutex(void * arg) {
+  double dt = *(double *)arg;
+  double t0 = cur_time();
+  myth_mutex_lock(m);
+  while (cur_time() - t0 < dt) myth_yield();
+  myth_mutex_unlock(m);
+  return 0;
+}
+
+void * signal_later(void * arg) {
+  double dt = *(double *)arg;
+  myth_usleep((useconds_t)(dt * 1.0e6));
+  myth_mutex_lock(m);
+  flag = 1;
+  myth_cond_signal(c);
+  myth_mutex_unlock(m);
+  return 0;
+}
+
+void * sleep_for(void * arg) {
+  double dt = *(double *)arg;
+  myth_usleep((useconds_t)(dt * 1.0e6));
+  return arg;
+}
+
+/* many threads sleeping for various intervals */
+void * sleep_tree(void * arg) {
+  long n = (long)arg;
+  if (n == 1) {
+    double t0 = cur_time();
+    long us = 100 + (((long)&t0 >> 4) * 7919) % 5000;
+    myth_usleep(us);
+    assert(cur_time() - t0 >= us * 1.0e-6);
+  } else {
+    myth_thread_t tid = myth_create(sleep_tree, (void *)(n / 2));
+    sleep_tree((void *)(n - n / 2));
+    myth_join(tid, 0);
+  }
+  return 0;
+}
+
+int main() {
+  double short_dt = 0.01, long_dt = 0.2;
+  double t0, t1;
+  struct timespec ts;
+  myth_thread_t tid;
+  void * ret;
+  myth_mutex_init(m, 0);
+  myth_cond_init(c, 0);
+
+  /* nanosleep does not return early */
+  t0 = cur_time();
+  myth_usleep(50000);
+  t1 = cur_time();
+  if (t1 - t0 < 0.05) {
+    printf("NG: usleep(50000) returned after %f sec\n", t1 - t0);
+    return 1;
+  }
+  sleep_tree((void *)1000);
+
+  /* timedlock times out while another thread holds it ... */
+  tid = myth_create(hold_mutex, &long_dt);
+  while (myth_mutex_trylock(m) == 0) {
+    myth_mutex_unlock(m);
+    myth_yield();
+  }
+  ts = after(short_dt);
+  if (myth_mutex_timedlock(m, &ts) != ETIMEDOUT) {
+    printf("NG: timedlock did not time out\n");
+    return 1;
+  }
+  /* ... and gets it once released */
+  ts = after(10.0);
+  if (myth_mutex_timedlock(m, &ts) != 0) {
+    printf("NG: timedlock failed\n");
+    return 1;
+  }
+  myth_mutex_unlock(m);
+  myth_join(tid, 0);
+
+  /* cond_timedwait times out without a signal ... */
+  myth_mutex_lock(m);
+  ts = after(short_dt);
+  if (myth_cond_timedwait(c, m, &ts) != ETIMEDOUT) {
+    printf("NG: cond_timedwait did not time out\n");
+    return 1;
+  }
+  /* ... and wakes up on a signal */
+  tid = myth_create(signal_later, &short_dt);
+  ts = after(10.0);
+  while (!flag) {
+    if (myth_cond_timedwait(c, m, &ts) != 0) {
+      printf("NG: cond_timedwait timed out\n");
+      return 1;
+    }
+  }
+  myth_mutex_unlock(m);
+  myth_join(tid, 0);
+
+  /* timedjoin times out on a running thread, then joins it */
+  tid = myth_create(sleep_for, &long_dt);
+  ts = after(short_dt);
+  if (myth_timedjoin(tid, &ret, &ts) != ETIMEDOUT) {
+    printf("NG: timedjoin did not time out\n");
+    return 1;
+  }
+  ts = after(10.0);
+  if (myth_timedjoin(tid, &ret, &ts) != 0 || ret != &long_dt) {
+    printf("NG: timedjoin failed\n");
+    return 1;
+  }
+
+  myth_cond_destroy(c);
+  myth_mutex_destroy(m);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+
+/* threads repeatedly read- or write-lock a statically 
+   initialized lock. writers increment x and y and
+   readers check x == y */
+
+typedef struct {
+  long nops_per_thread;
+  long a;
+  long b;
+  long r;
+  long * p;			/* p[0] = x, p[1] = y, p[2] = ng */
+  pthread_rwlock_t * l;
+} arg_t;
+
+void * f(void * arg_) {
+  arg_t * arg = (arg_t *)arg_;
+  long a = arg->a, b = arg->b;
+  long nops_per_thread = arg->nops_per_thread;
+  if (b - a == 1) {
+    long i;
+    for (i = 0; i < nops_per_thread; i++) {
+      if ((a * 7 + i) % 8 == 0) {
+	pthread_rwlock_wrlock(arg->l);
+	arg->p[0]++;
+	sched_yield();
+	arg->p[1]++;
+	pthread_rwlock_unlock(arg->l);
+      } else {
+	pthread_rwlock_rdlock(arg->l);
+	long x = arg->p[0];
+	sched_yield();
+	if (x != arg->p[1]) arg->p[2] = 1;
+	pthread_rwlock_unlock(arg->l);
+      }
+    }
+    arg->r = a;
+  } else {
+    long c = (a + b) / 2;
+    arg_t cargs[2] = { { nops_per_thread, a, c, 0, arg->p, arg->l }, 
+		       { nops_per_thread, c, b, 0, arg->p, arg->l } };
+    pthread_t tid;
+    pthread_create(&tid, 0, f, cargs);
+    f(cargs + 1);
+    pthread_join(tid, 0);
+    arg->r = cargs[0].r + cargs[1].r;
+  }
+  return 0;
+}
+
+pthread_rwlock_t l[1] = { PTHREAD_RWLOCK_INITIALIZER };
+
+int main(int argc, char ** argv) {
+  long nthreads        = (argc > 1 ? atol(argv[1]) : 100);
+  long nops_per_thread = (argc > 2 ? atol(argv[2]) : 1000);
+
+  long p[3] = { 0, 0, 0 };
+  arg_t arg[1] = { { nops_per_thread, 0, nthreads, 0, p, l } };
+  pthread_t tid;
+  pthread_create(&tid, 0, f, arg);
+  pthread_join(tid, 0);
+
+  if (arg->r == (nthreads - 1) * nthreads / 2
+      && p[0] == p[1] && !p[2]) {
+    printf("OK\n");
+    return 0;
+  } else {
+    printf("NG: x = %ld, y = %ld, ng = %ld\n", p[0], p[1], p[2]);
+    return 1;
+  }
+}
@@ -0,0 +1 @@
+#include "pth_rwlock.c"